@@ -1,2252 +1,8232 @@
-#include <stdio.h>
-#include <string.h>
-
-/*** VIRTUAL SYSTEM PARAMETERS ***/
-#define SYSTEM_MEMORY_SIZE      10000
-#define GPR_NUMBER              8
-#define DEFAULT_PRIORITY	128
-#define TIMESLICE		200
-#define ReadyState 1
-#define EndOfList -1
-
-/*** VALUE CONSTANTS ***/
-#define SCRIPT_INDICATOR_END	-1
-#define MAX_FILENAME		128
-
-// Simulator Execution Status
-#define SIMULATOR_STATUS_HALTED	0
-#define SIMULATOR_STATUS_OK	1
-
-// Machine PSR Modes
-#define MACHINE_MODE_USER	0
-#define MACHINE_MODE_OS		1
-
-
-// Memory-Space Boundaries (non-inclusive)
-#define MAX_USER_MEMORY         3999
-#define MAX_HEAP_MEMORY         6999
-#define MAX_OS_MEMORY         	9999
-
-/*** ERROR CODES ***/
-#define OK                      -1
-#define ErrorFileOpen           -2
-#define ErrorInvalidAddress     -3
-#define ErrorInvalidPCValue     -4
-#define ErrorNoEndOfProgram     -5
-#define ErrorInvalidInstruction -6
-#define ErrorInvalidOpcode      -7
-#define ErrorInvalidMode        -8
-#define ErrorImmediateMode      -9
-#define ErrorRuntime            -10
-#define ErrorStackOverflow      -11
-#define ErrorStackUnderflow     -12
-#define ErrorInvalidMemorySize  -13
-#define ErrorNoFreeMemory       -14
-
-/*** EVENT CODES ***/
-#define StartOfInput			0
-#define StartOfOutput			1
-#define InputCompletion			2
-#define OutputCompletion		3
-#define TimeSliceExpired		4
-
-/*** GLOBAL VARS ***/
-long mem[SYSTEM_MEMORY_SIZE], gpr[GPR_NUMBER];
-long mar, mbr, clock, ir, psr, pc, sp;
-long OSFreeList = EndOfList;
-long UserFreeList = EndOfList;
-long RQ = EndOfList;
-long WQ = EndOfList;	// Printed in main and must therefore be initialized
-long SysShutdownStatus;
-
-//long EndOfList = -1; //indicates end of OSFreeList or UserFreeList
-
-long ProcessID = 1;
-
-const int Ready = 1;
-const int Running = 2;
-const int Waiting = 3;
-
-/*** PCB ***/
-const long PCBsize = 22;
-int NextPtr = 0;
-const int PCB_Pid = 1;
-const int PCB_State = 2;
-const int PCB_Reason = 3;
-const int PCB_Priority = 4;
-const int PCB_StackSize = 5;
-const int PCB_StackStartAddr = 6;
-const int PCB_GPR0 = 11;
-const int PCB_GPR1 = 12;
-const int PCB_GPR2 = 13;
-const int PCB_GPR3 = 14;
-const int PCB_GPR4 = 15;
-const int PCB_GPR5 = 16;
-const int PCB_GPR6 = 17;
-const int PCB_GPR7 = 18;
-const int PCB_SP = 19;
-const int PCB_PC = 20;
-const int PCB_PSR = 21;
-
-/*** FUNCTION PROTOTYPES ***/
-void InitializeSystem();
-int main(int argc, char *argv[]);
-int AbsoluteLoader(char* filename);
-long CPU();
-long SystemCall(long SystemCallID);
-long FetchOperand(long OpMode, long OpReg, long *OpAddress, long *OpValue);
-void DumpMemory(char* String, long StartAddress, long size);
-long CreateProcess(char *filename, long priority);
-long AllocateOSMemory(long RequestedSize);
-long FreeOSMemory(long *ptr, long size);
-long AllocateUserMemory(long size);
-long FreeUserMemory(long ptr, long size);
-long MemAllocSystemCall();
-long MemFreeSystemCall();
-void InitializePCB();
-void PrintPCB(long PCBptr);
-long PrintQueue(long Qptr);
-long InsertIntoRQ(long *PCBptr);
-long InsertIntoWQ(long *PCBptr);
-long SelectProcessFromRQ();
-void SaveContext(long PCBptr);
-void Dispatcher(long PCBptr);
-void TerminateProcess(long PCBptr);
-void CheckAndProcessInterrupt();
-void ISRrunProgramInterrupt();
-void ISRinputCompletionInterrupt();
-void ISRoutputCompletionInterrupt();
-void ISRshutdownSystem();
-long IOGetCSystemCall();
-long IOPutCSystemCall();
-long SearchAndRemovePCBfromWQ(long ProcessID);
-
-/*******************************************************************************
- * Function: InitializeSystem
- *
- * Description: Resets all Global Vars (Hardware) to an initial value 0
- *
- * Input Parameters
- *      None
- *
- * Output Parameters
- *      None
- *
- * Function Return Value
- *      None
- ******************************************************************************/
-void InitializeSystem()
-{
-	char filename[MAX_FILENAME];
-	strcpy(filename, "nullprocess.txt");
-
-	/* Initialize Memory Array and then GPR Register Array */
-	for (int i = 0; i < SYSTEM_MEMORY_SIZE; i++)
-		mem[i] = 0;
-	for (int i = 0; i < GPR_NUMBER; i++)
-		gpr[i] = 0;
-
-	/* Assigns value `0` to Each Individual Hardware Variable */
-	mar = mbr = clock = ir = psr = pc = sp = 0;
-
-	// Create user free list using the free block address and size given in the class
-	// This part has errors. "Next user free block pointer", "second location in free block"
-	UserFreeList = MAX_USER_MEMORY + 1;
-	mem[UserFreeList] = EndOfList;
-	mem[UserFreeList + 1] = MAX_HEAP_MEMORY - MAX_USER_MEMORY;
-
-	// Create OS free list using the free block address and size given in the class
-	// This part has errors. "Next OS free block pointer", "second location in free block"
-	OSFreeList = MAX_HEAP_MEMORY + 1;
-	mem[OSFreeList] = EndOfList;
-	mem[OSFreeList + 1] = MAX_OS_MEMORY - MAX_HEAP_MEMORY;
-
-
-	// Call Create Process function passing Null Process executing file and priority zero as arguments
-	CreateProcess(filename, 0);
-	return;
-}
-
-/*******************************************************************************
- * Function:Main
- *
- * Description:
- *
- * Input Parameters
- *      None
- *
- * Output Parameters
- *      None
- *
- * Function Return Value
- *      OK				-on successful execution
- *      ErrorFileOpen			-Cannot Open File
- *      ExecutionCompletionStatus	-Returns code returned by CPU
- ******************************************************************************/
-
-int main(int argc, char *argv[])
-{
-	/* Local Variables */
-	char filename[MAX_FILENAME];
-	long ReturnValue;
-	int ExecutionCompletionStatus;
-	long PCBPtr;
-
-
-	//Prompt User to load Machine Code Program
-	if (argc <= 1) {
-		printf("Enter Machine Code Program Filename >>");
-		fgets(filename, MAX_FILENAME, stdin);		// fgets is buffer-safe
-		strtok(filename, "\n");
-
-	} else
-		strcpy(filename, argv[1]);
-
-
-	// Ready System and Load File
-	InitializeSystem();
-	pc = AbsoluteLoader(filename);
-
-
-	while (SysShutdownStatus != 1){
-
-		// Check and process interrupt
-		CheckAndProcessInterrupt();
-
-		// Dump RQ and WQ
-		printf("RQ: Before CPU scheduling\n");
-		PrintQueue(RQ);
-		printf("WQ: Before CPU scheduling\n");
-		PrintQueue(WQ);
-		DumpMemory("Dynamic Memory Area before CPU scheduling", 0, 99);
-
-		// Select next process from RQ to give CPU
-		PCBPtr = SelectProcessFromRQ();
-
-		// Perform restore context using Dispatcher
-		Dispatcher(PCBPtr);
-
-		// Dump RQ
-		printf("RQ: After selecting process from RQ \n");
-		PrintQueue(RQ);
-
-		// Execute instructions of the running process using the CPU
-		ExecutionCompletionStatus = CPU();
-
-		// Dump dynamic memory area
-		DumpMemory("After executing program", MAX_USER_MEMORY, MAX_USER_MEMORY);
-
-		// Check return status
-		if(ExecutionCompletionStatus = TimeSliceExpired){
-			SaveContext(PCBPtr); // running process is losing CPU
-			InsertIntoRQ(&PCBPtr);
-			PCBPtr = EndOfList;
-		}
-		else if (ExecutionCompletionStatus = SIMULATOR_STATUS_HALTED | ExecutionCompletionStatus < 0){
-			TerminateProcess(PCBPtr);
-			PCBPtr = EndOfList;
-			SysShutdownStatus = 1;
-
-		}
-		else if (ExecutionCompletionStatus = StartOfInput){
-			mem[PCBPtr + PCB_Reason] = InputCompletion;
-			InsertIntoWQ(&PCBPtr);
-			PCBPtr = EndOfList;
-		}
-		else if (ExecutionCompletionStatus = StartOfOutput){
-			mem[PCBPtr + PCB_Reason] = OutputCompletion;
-			InsertIntoWQ(&PCBPtr);
-			PCBPtr = EndOfList;
-		}
-		else{
-			printf("Unknown programming error");
-		}
-	}
-
-	// Print OS is shutting down message
-	printf("OS shutting down");
-	return(ExecutionCompletionStatus); // Terminate operating system
-
-	/* // From Homework 1
-	// Check for Negative Error Code
-	if (pc < 0) {
-	printf("FILE ERROR: %d\n", pc);
-	return pc;
-	}
-
-	//Dump Memory, Execute, and Dump Memory
-	DumpMemory("Program Loaded into System", 0, 99);
-	ExecutionCompletionStatus = CPU();
-	printf("Execution Status: %d\n", ExecutionCompletionStatus);
-	DumpMemory("Program Execution Stopped System", 0, 99);
-	return(ExecutionCompletionStatus);
-	*/
-
-}
-
-
-/*******************************************************************************
- * Function: AbsoluteLoader
- * Description: Opens a file that contains HYPO-machine code (user program)
- * into the HYPO machine memory.
- * On a successful file load the function returns the value in the `End of
- * Program` line (Indicates PC Value).
- * On failure to load then the function displays the appropriate error message
- * and returns the appropriate error code.
- *
- *
- * Input Parameters
- *      filename			-Name of the Machine Code File
- *
- * Output Parameters
- *      None
- *
- * Function Return Value
- *      ErrorFileOpen			-Unable to open the file
- *      ErrorInvalidAddress		-Invalid address error
- *      ErrorNoEndOfProgram		-Missing end of program indicator
- *      ErrorInvalidPCValue		-Invalid PC value
- *      0 to Valid address range	-Successful Load, valid PC value
- ******************************************************************************/
-
-int AbsoluteLoader(char* filename)
-{
-	// Load machine code file into HYPO memory
-	FILE *fp;
-	fp = fopen(filename, "r"); //open file in READ mode
-	if (fp == NULL) {
-		printf("ERROR: Unable to open file.\n");
-		return ErrorFileOpen;
-	}
-
-	// Parse File
-	int addr, word;
-	while (fscanf(fp, "%d %d", &addr, &word) != EOF) {
-		// If Address indicates EOP, Word is PC Value
-		if (addr == SCRIPT_INDICATOR_END) {
-			fclose(fp);
-			if (word < SYSTEM_MEMORY_SIZE && word > 0)
-				return word;                    //Success
-			printf("ERROR: PC value Invalid\n");    //Error
-			return ErrorInvalidPCValue;
-		}
-		else if (0 <= addr <= MAX_USER_MEMORY)
-			mem[addr] = word;
-		else {
-			fclose(fp);
-			printf("ERROR: Address Location in Invalid Range\n");
-			return ErrorInvalidAddress;
-		}
-	}
-	fclose(fp);
-	printf("ERROR: No End of Program Indicator\n");         //Error
-	return ErrorNoEndOfProgram;
-}
-
-/*******************************************************************************
- * Function: CPU
- *
- * Description: CPU Execution is divided into 2 phases.
- * Decode: Parses the composite instruction into constituent parts. Validation
- * is done on individual components and an error is returned should any
- * instruction component is invalid.
- * Execute: The validity of the instruction (whole and in context) is
- * performed. Error is returned on an invalid instruction. Given a valid
- * instruction, a call is made to FetchOperand() and the result of it's
- * execution defines the state of the machine status (PSR).
- *
- * Notes:
- *
- *
- * Input Parameters
- *      None
- *
- * Output Parameters
- *      None
- *
- * Function Return Value
- *      OK				-on successful execution
- *      psr				-Returns Error given by FetchOperand()
- *      ErrorInvalidAddress		-Payload address not valid
- *      ErrorRuntime			-Unbound address during runtime
- *      ErrorInvalidInstruction		-Instruction not valid
- *      ErrorInvalidOpcode		-Opcode not valid
- *      ErrorStackOverflow		-Attempted to allocate beyond stack
- *      ErrorStackUnderflow		-Attempted to allocate beneath stack
- *
- * Initial Implementation done by Ykaro Rocha
- ******************************************************************************/
-
-long CPU()
-{
-	/* Local Variables */
-	long opcode, op1mode, op1gpr, op2mode, op2gpr, op1addr, op1val,
-	     op2addr, op2val, remainder, result, SystemCallID;
-	long status = OK;
-	long TimeLeft = TIMESLICE;
-
-	// Run CPU until HALT state
-	while (status = OK && TimeLeft > 0) {
-
-		// Fetch Cycle
-		if (0 <= pc <= MAX_USER_MEMORY) {
-			mar = pc;
-			pc++;
-			mbr = mem[mar];
-		}
-		else {
-			printf("ERROR: Invalid Runtime Address. Line: %d "
-					"Address: %d\n", pc, mem[pc]);          // Error
-			return(ErrorInvalidAddress);
-		}
-
-		ir = mbr;
-
-		// Decode Cycle			-CAPTURE-
-		opcode = ir / 10000;            //[65]4321
-		remainder = ir % 10000;
-
-		op1addr = remainder / 100;      //[43]21
-		op1val = gpr[op1addr];
-
-		op1mode = remainder / 1000;     //[4]321
-		remainder = remainder % 1000;
-
-		op1gpr = remainder / 100;       //[3]21
-		remainder = remainder % 100;
-
-
-		op2addr = remainder;            //[21]
-		op2val = gpr[op2addr];
-		op2mode = remainder / 10;       //[2]1
-		remainder = remainder % 10;
-
-		op2gpr = remainder;             //[1]
-
-
-		// Decode Validation
-		if (((0 <= op1mode <= 6) && (0 <= op2mode <= 6) &&
-					(0 <= op1gpr <= GPR_NUMBER) && (0 <= op2gpr <= GPR_NUMBER)) == 0) {
-			printf("ERROR: Invalid Instruction on line %d\n", mar); // Error
-			return ErrorInvalidInstruction;
-		}
-
-
-		// Execute Cycle
-
-		switch (opcode) {
-			case 0:                 //halt
-				printf("Machine is Halting\n");
-				return SIMULATOR_STATUS_HALTED;
-				clock += 12;
-				TimeLeft -= 12;
-				break;
-			case 1:                 //add
-				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
-				if (status != OK) {                //Return ERROR value to Main
-					return status;
-				}
-
-				status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
-				if (status != OK) {
-					return status;
-				}
-
-				//Add Operand Values
-				result = op1val + op2val;
-
-				// If op1mode is Register Mode
-				if (op1mode == 1) {
-					gpr[op1gpr] = result;
-				}
-				else if (op1mode == 6) {
-					printf("ERROR: Line %d Destination cannot be immediate\n", pc);
-					return ErrorImmediateMode;
-				}
-				else {        //Store result in op1address
-					mem[op1addr] = result;
-				}
-				clock += 3;
-				TimeLeft -= 3;
-				break;
-			case 2:                 //subtract
-				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
-				if (status != OK) {                //Return ERROR value to Main
-					return status;
-				}
-
-				status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
-				if (status != OK) {
-					return status;
-				}
-
-				//Subtract Operand Values
-				result = op1val - op2val;
-
-				// If op1mode is Register Mode
-				if (op1mode == 1) {
-					gpr[op1gpr] = result;
-				}
-				else if (op1mode == 6) {
-					printf("ERROR: Line %d Destination cannot be immediate\n", pc);
-					return ErrorImmediateMode;
-				}
-				else {        //Store result in op1address
-					mem[op1addr] = result;
-				}
-				clock += 3;
-				TimeLeft -= 3;
-				break;
-			case 3:                 //multiply
-				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
-				if (status != OK) {                //Return ERROR value to Main
-					return status;
-				}
-
-				status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
-				if (status != OK) {
-					return status;
-				}
-
-				//Multiply Operand Values
-				result = op1val * op2val;
-
-				// If op1mode is Register Mode
-				if (op1mode == 1) {
-					gpr[op1gpr] = result;
-				}
-				else if (op1mode == 6) {
-					printf("ERROR: Line %d Destination cannot be immediate\n", pc);
-					return ErrorImmediateMode;
-				}
-				else {        //Store result in op1address
-					mem[op1addr] = result;
-				}
-				clock += 6;
-				TimeLeft -= 6;
-				break;
-			case 4:                 //divide
-				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
-				if (status != OK) {                //Return ERROR value to Main
-					return status;
-				}
-
-				status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
-				if (status != OK) {
-					return status;
-				}
-
-				//Divide Operand Values
-				if (op2val != 0)		// Division by Zero Check
-					result = op1val / op2val;
-				else {
-					printf("ERROR: Line %d Division by Zero\n", pc);
-					return ErrorRuntime;
-				}
-
-
-				// If op1mode is Register Mode
-				if (op1mode == 1) {
-					gpr[op1gpr] = result;
-				}
-				else if (op1mode == 6) {
-					printf("ERROR: Line %d Destination cannot be immediate\n", pc);
-					return ErrorImmediateMode;
-				}
-				else {        //Store result in op1address
-					mem[op1addr] = result;
-				}
-				clock += 6;
-				TimeLeft -= 6;
-				break;
-			case 5:                 //move (op1 <- op2)
-				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
-				if (status != OK) {                //Return ERROR value to Main
-					return status;
-				}
-
-				status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
-				if (status != OK) {
-					return status;
-				}
-
-				// If op1mode is Register Mode
-				if (op1mode == 1) {
-					gpr[op1gpr] = op2val;
-				}
-				else if (op1mode == 6) {
-					printf("ERROR: Line %d Destination cannot be immediate\n", pc);
-					return ErrorImmediateMode;
-				}
-				else {        //Store result in op1address
-					mem[op1addr] = op2val;
-				}
-				clock += 2;
-				TimeLeft -= 2;
-				break;
-			case 6:                 //branch
-				if (0 <= pc <= MAX_USER_MEMORY)
-					pc = mem[pc];
-				else {
-					printf("ERROR: Invalid Branch Address at Runtime\n");
-					return ErrorRuntime;
-				}
-				clock += 2;
-				TimeLeft -= 2;
-				break;
-			case 7:                 //branch on minus
-				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
-				if (status != OK) {                //Return ERROR value to Main
-					return status;
-				}
-
-				if (op1val < 0) {
-					if (0 <= pc <= MAX_USER_MEMORY) {
-						pc = mem[pc];
-					}
-					else {
-						printf("ERROR: Invalid Branch Address at Runtime\n");
-						return ErrorRuntime;
-					}
-				}
-				else {
-					pc++;	//Skip Branch and advance
-				}
-				clock += 4;
-				TimeLeft -= 4;
-				break;
-			case 8:                 //branch on plus
-				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
-				if (status != OK) {                //Return ERROR value to Main
-					return status;
-				}
-
-				if (op1val > 0) {
-					if (0 <= pc <= MAX_USER_MEMORY) {
-						pc = mem[pc];
-					}
-					else {
-						printf("ERROR: Invalid Branch Address at Runtime\n");
-						return ErrorRuntime;
-					}
-				}
-				else {
-					pc++;	//Skip Branch and advance
-				}
-				clock += 4;
-				TimeLeft -= 4;
-				break;
-			case 9:                 //branch on zero
-				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
-				if (status != OK) {                //Return ERROR value to Main
-					return status;
-				}
-
-				if (op1val == 0) {
-					if (0 <= pc <= MAX_USER_MEMORY) {
-						pc = mem[pc];
-					}
-					else {
-						printf("ERROR: Invalid Branch Address at Runtime\n");
-						return ErrorRuntime;
-					}
-				}
-				else {
-					pc++;	//Skip Branch and advance
-				}
-				clock += 4;
-				TimeLeft -= 4;
-				break;
-			case 10:                //push
-				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
-				if (status != OK) {                //Return ERROR value to Main
-					return status;
-				}
-
-				if ((MAX_USER_MEMORY < sp < MAX_HEAP_MEMORY) != 0) {
-					printf("ERROR: Stack Address Overflow\n");
-					return ErrorStackOverflow;
-				}
-
-				// Push to Stack
-				sp++;
-				mem[sp] = op1val;
-				clock += 2;
-				TimeLeft -= 2;
-				break;
-			case 11:                //pop
-				if ((MAX_USER_MEMORY < sp < MAX_HEAP_MEMORY) != 0) {
-					printf("ERROR: Stack Address Underflow\n");
-					return ErrorStackUnderflow;
-				}
-
-				// Pop Stack
-				op1val = mem[sp];
-				sp--;
-				clock += 2;
-				TimeLeft -= 2;
-				break;
-			case 12:                //system call
-				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
-				if (status < 0) {
-					printf("ERROR: Systemcall to Invalid Address\n");
-					return ErrorRuntime;
-				}
-				long SystemCallID = mem[pc++];
-				status = SystemCall(SystemCallID);
-				clock += 12;
-				TimeLeft -= 12;
-				break;
-			default:                //Invalid Opcode
-				printf("ERROR: Invalid opcode on line %d\n", mar);         // Error
-				return ErrorInvalidOpcode;
-		}
-	}
-}
-
-
-/*******************************************************************************
- * Function: SystemCall
- *
- * Description: Processes SystemCall Instructions
- *
- * Input Parameters
- *      OpValue
- *
- * Output Parameters
- *
- *
- * Function Return Value
- *      OK				-Successful Fetch
- *      ErrorInvalidAddress		-Oprand address not valid
- *      ErrorInvalidMode		-Mode not correct
- *      ErrorInvalidPCValue		-Direct Mode PC out of bounds
- *
- * Initial Implementation done by Ykaro Rocha
- ******************************************************************************/
-
-long SystemCall(long SystemCallID)
-{
-	psr = MACHINE_MODE_OS;		// Set system mode to OS mode
-	printf("MACHINE STATUS SET >>> OS");
-
-	long status = OK;
-
-	switch (SystemCallID) {
-		case 1:                 //process_create
-			//status = CreateProcess(filename, priority);
-			printf("System call not implemented\n");
-			break;
-		case 2:                 //process_delete
-			// not needed
-			printf("System call not implemented\n");
-			break;
-		case 3:                 //process_inquiry
-			// not needed
-			printf("System call not implemented\n");
-			break;
-		case 4:                 //mem_alloc
-			//Dynamic memory allocation: Allocate user free memory system call
-			status = MemAllocSystemCall();
-			break;
-		case 5:                 //mem_free
-			// Free dynamically allocated user memory system call
-			status = MemFreeSystemCall();
-			break;
-		case 6:                 //msg_send
-			// not needed
-			status = printf("System call not implemented");
-			break;
-		case 7:                 //msg_recieve
-			// not needed
-			printf("System call not implemented");
-			break;
-		case 8:                 //io_getc
-			status = IOGetCSystemCall();
-			break;
-		case 9:                 //io_putc
-			status = IOPutCSystemCall();
-			break;
-		case 10:                //time_get
-			// not needed
-			printf("System call not implemented");
-			break;
-		case 11:                //time_set
-			// not needed
-			printf("System call not implemented");
-			break;
-		default:
-			printf("Invalid system call ID");
-			break;
-	}
-	psr = MACHINE_MODE_USER;		// Restore to User Mode
-	return status;
-}
-
-/*******************************************************************************
- * Function: FetchOperand
- *
- * Description: Depending on the Addressing Mode, function checks if address
- * refered to by the instruction is in valid memory space and performs actions
- * on the instruction. The result is returned.
- * The result is intended to define the status of the machine (psr).
- *
- * Input Parameters
- *      OpMode				Operand Mode Value
- *      OpReg				Operand GPR Value
- *
- * Output Parameters
- *      OpAddress			Address of Operand
- *      OpValue				Value of Operand when GPR and mode are valid
- *
- * Function Return Value
- *      OK				-Successful Fetch
- *      ErrorInvalidAddress		-Oprand address not valid
- *      ErrorInvalidMode		-Mode not correct
- *      ErrorInvalidPCValue		-Direct Mode PC out of bounds
- ******************************************************************************/
-
-long FetchOperand(
-		long OpMode,
-		long OpReg,
-		long *OpAddress,
-		long *OpValue)
-{
-	//Fetch value based on value based on the operand mode
-	switch (OpMode) {
-		case 1:         //Register Mode
-			*OpAddress = -1;         //Set to Invalid Address
-			*OpValue = gpr[OpReg];
-			break;
-		case 2:         //Register deferred mode
-			*OpAddress = gpr[OpReg];         //Grab OPAddress from Register
-
-			if (0 <= OpAddress <= MAX_USER_MEMORY) {
-				*OpValue = mem[*OpAddress];         //Grab OpValue in Mem
-			}
-			else {
-				printf("ERROR: Invalid Fetch Operand Address\n");
-				return ErrorInvalidAddress;
-			}
-
-			break;
-		case 3:         //Autoincrement mode -> ADDR in GPR, OPVAL in MEM
-			*OpAddress = gpr[OpReg];                //Op Address is in Register
-
-			if (0 <= OpAddress <= MAX_USER_MEMORY) {
-				*OpValue = mem[*OpAddress];         //Grab OpValue in Mem
-			}
-			else {
-				printf("ERROR: Invalid Fetch Operand Address\n");
-				return ErrorInvalidAddress;
-			}
-			gpr[OpReg]++;
-
-			break;
-		case 4:         //Autodecrement mode
-			--gpr[OpReg];
-			*OpAddress = gpr[OpReg];
-			if (0 <= OpAddress <= MAX_USER_MEMORY) {
-				*OpValue = mem[*OpAddress];         //Grab OpValue in Mem
-			}
-			else {
-				printf("ERROR: Invalid Fetch Operand Address\n");
-				return ErrorInvalidAddress;
-			}
-
-			break;
-		case 5:         //Direct mode -> OP Address is mem[pc]
-
-			if ((0 <= pc <= MAX_USER_MEMORY) == 0) {
-				printf("ERROR: Invalid PC Address at Runtime\n");
-				return ErrorRuntime;
-			}
-			*OpAddress = mem[pc++];
-			if (0 <= *OpAddress <= MAX_USER_MEMORY) {
-				*OpValue = mem[*OpAddress];
-			}
-			else {
-				printf("ERROR: Invalid Address\n");
-				return ErrorInvalidAddress;
-			}
-
-			break;
-		case 6:         //Immediate mode -> Opvalue in Instruction
-			if ((0 <= mem[pc] <= MAX_USER_MEMORY) == 0) {
-				printf("ERROR: Invalid PC Address at Runtime\n");
-				return ErrorRuntime;
-			}
-			*OpAddress = -1;                        //Set to Invalid Address
-			*OpValue = mem[pc++];
-
-			break;
-		default:        //Invalid mode
-			printf("ERROR: Invalid mode at line %d\n", mbr);
-			return ErrorInvalidMode;
-	}
-	return OK;
-}
-
-/*******************************************************************************
- * Function: DumpMemory
- *
- * Description: Displays the current state of all GeneralPurposeRegisters(GPR),
- * the StackPointer (SP), ProgramCounter(PC), ProcessorStatusRegister(PSR),
- * system Clock, and a dump of the system memory up-to a given memory address.
- *
- * Input Parameters
- *      String			String header displayed above Status Table
- *      StartAddress			Memory location from which to begin dump
- *      Size				Offset from StartAddress
- *
- * Output Parameters
- *      None
- *
- * Function Return Value
- *      None
- ******************************************************************************/
-
-void DumpMemory(
-		char* String,
-		long StartAddress,
-		long size)
-{
-	/* Print String Header */
-	printf("%s\n", String);
-
-	/* Returns Error */
-	if (StartAddress + size > SYSTEM_MEMORY_SIZE || StartAddress < 0) {
-		printf("ERROR: Invalid Dump-Memory Range\n");
-		return;
-	}
-
-	/* Print Register Table Header + Status */
-	for (int register_number = 0; register_number < GPR_NUMBER; register_number++)
-		printf("\tG%d", register_number);
-	printf("\tSP\tPC\n");
-
-	for (int register_number = 0; register_number < GPR_NUMBER; register_number++)
-		printf("\t%d", gpr[register_number]);
-	printf("\t%d\t%d\n", sp, pc);
-
-	/* Memory Table Header */
-	printf("Address");
-	for (int num = 0; num < 10; num++)
-		printf("\t+%d", num);
-	printf("\n");
-
-	/* Operational Variables */
-	long addr = (StartAddress / 10) * 10; //Rounds down to Nearest 10 (Integer Math)
-	long endAddress = StartAddress + size;
-
-	/* Dump Memory */
-	while (addr < endAddress) {
-		printf("%d\t", addr);
-		for (int i = 0; i < 10; i++)
-			printf("%d\t", mem[addr + i]);
-		printf("\n");
-		addr += 10;
-	}
-	printf("System-Clock >> %d\n", clock);
-	printf("Processor Status Register (PSR) >> %d\n", psr);
-}
-
-/*******************************************************************************
- * Function: CreateProcess [UNUSED]
- *
- * Description: Creates a PCB in Dyanamic Memory and populates the PCB indecies
- * with the values.
- *
- * Input Parameters
- *      String (pointer)		Name of the file associated with the process
- * 	Long				An interger value defining priority
- *
- * Output Parameters
- *      None
- *
- * Function Return Value
- * 	OK
- * 	ErrorInvalidAddress
- *
- * Initial Implementation done by Ykaro Rocha
- ******************************************************************************/
-long CreateProcess(char* filename, long priority)
-{
-	// Note to Professor: Team believed that CreateProcess was not to be implemented
-	// This section was originally written but commented out and bugs appeared.
-	// Now this section is implemented again.
-
-	// Allocate space for Process Control Block
-	long PCBptr = AllocateOSMemory(PCBsize);
-
-	//Check for Error
-	if (PCBptr < 0){
-		printf("ERROR: Could not allocate memory");
-		return(ErrorInvalidAddress);
-	}
-
-
-	// Initialize PCB: Set nextPCBlink to end of list, default priority, Ready state, and PID
-	InitializePCB(PCBptr);
-
-	// Load the program
-	if (AbsoluteLoader(filename) == OK)
-		mem[PCBptr + PCB_PC] = pc; 		// Store PC value in the PCB of the process
-	else
-		return ErrorFileOpen;
-
-	// Allocate stack space from user free list
-	PCBptr = AllocateUserMemory(mem[PCBptr + PCB_StackSize]);
-	//mem[PCBptr + PCB_StackSize] = PCBsize; 		// Set ptr = Allocate User Memory of size StackSize;
-	if (PCBptr < 0)			// Check for error
-	{  				// User memory allocation failed
-		FreeOSMemory(&PCBptr, PCBsize);
-		return(ErrorInvalidMemorySize);  		// return error code
-	}
-
-	// Store stack information in the PCB . SP, ptr, and size
-	mem[PCBptr + PCB_SP] = PCBptr + PCBsize;		// empty stack is high address, full is low address
-	mem[PCBptr + PCB_Priority] = PCBptr + PCBsize;
-	mem[PCBptr + PCB_StackSize] = PCBptr + PCBsize;
-	mem[PCBptr + PCB_Reason] = DEFAULT_PRIORITY;	// Set priority
-
-	DumpMemory("PCB Created", PCBptr, PCBsize);				// Dump PCB stack
-
-	PrintPCB(PCBptr);
-
-	// Insert PCB into Ready Queue according to the scheduling algorithm
-	InsertIntoRQ(&PCBptr);
-
-	return(OK);
-}
-/*******************************************************************************
- * Function: TerminateProcess
- *
- * Description: Deallocates the reference of the PCB from the lists in Dynamic
- * Memory and OS Memory
- *
- * Input Parameters
- * 	- PCBptr			Address of the PCB that is to be deallocated
- *
- * Output Parameters
- * 	- None
- *
- * Function Return Value
- * 	- None
- *
- * Initial Implementation done by Ykaro Rocha
- ******************************************************************************/
-
-void TerminateProcess(long PCBptr)
-{
-	//printf("Function not Implemented on account of Create Process Function not being implemented\n");
-	// Return stack memory using stack start address and stack size in the given PCB
-	long StackSize = PCBptr;
-	FreeUserMemory(PCBptr, mem[PCBptr + 5]);
-
-	// Return PCB memory using the PCBptr
-	FreeOSMemory(&PCBptr, mem[PCBptr + 5]);			// Free Process from PCB Stack
-
-	return;
-
-} //End of TerminateProcess function
-
-/*******************************************************************************
- * Function: AllocateOSMemory
- *
- * Description: Displays the current state of all GeneralPurposeRegisters(GPR),
- * the StackPointer (SP), ProgramCounter(PC), ProcessorStatusRegister(PSR),
- * system Clock, and a dump of the system memory up-to a given memory address.
- *
- * Input Parameters
- *      String			String header displayed above Status Table
- *      StartAddress			Memory location from which to begin dump
- *      Size				Offset from StartAddress
- *
- * Output Parameters
- *      None
- *
- * Function Return Value
- *      None
- *
- * Initial Implementation done by Ykaro Rocha
- ******************************************************************************/
-
-long AllocateOSMemory(long RequestedSize)  // return value contains address or error
-{
-	// Allocate memory from OS free space, which is organized as link
-	if (OSFreeList == EndOfList)
-	{
-		printf("ERROR: No Free OS Memory");
-		return(ErrorNoFreeMemory);   // ErrorNoFreeMemory is constant set to < 0
-	}
-	if (RequestedSize < 0)
-	{
-		printf("ERROR: Invalide Memory Size");
-		return(ErrorInvalidMemorySize);  // ErrorInvalidMemorySize is constant < 0
-	}
-	if (RequestedSize == 1)
-		RequestedSize = 2;  // Minimum allocated memory is 2 locations
-
-	long CurrentPtr = OSFreeList;
-	long PreviousPtr = EndOfList;
-	while (CurrentPtr != EndOfList)
-	{
-		// Check each block in the link list until block with requested memory size is found
-		if (mem[CurrentPtr + 1] == RequestedSize)
-		{  // Found block with requested size.  Adjust pointers
-			if (CurrentPtr == OSFreeList)  // first block
-			{
-				OSFreeList = mem[CurrentPtr];  // first entry is pointer to next block
-				mem[CurrentPtr] = EndOfList;  // reset next pointer in the allocated block
-				return(CurrentPtr);	// return memory address
-			}
-			else  // not first black
-			{
-				mem[PreviousPtr] = mem[CurrentPtr];  // point to next block
-				mem[CurrentPtr] = EndOfList;  // reset next pointer in the allocated block
-				return(CurrentPtr);    // return memory address
-			}
-		}
-		else if (mem[CurrentPtr + 1] > RequestedSize)
-		{  // Found block with size greater than requested size
-			if (CurrentPtr == OSFreeList)  // first block
-			{
-				mem[CurrentPtr + RequestedSize] = mem[CurrentPtr];  // move next block ptr
-				mem[CurrentPtr + RequestedSize + 1] = mem[CurrentPtr + 1] - RequestedSize;
-				OSFreeList = CurrentPtr + RequestedSize;  // address of reduced block
-				mem[CurrentPtr] = EndOfList;  // reset next pointer in the allocated block
-				return(CurrentPtr);	// return memory address
-			}
-			else  // not first black
-			{
-				mem[CurrentPtr + RequestedSize] = mem[CurrentPtr];  // move next block ptr
-				mem[CurrentPtr + RequestedSize + 1] = mem[CurrentPtr + 1] - RequestedSize;
-				mem[PreviousPtr] = CurrentPtr + RequestedSize;  // address of reduced block
-				mem[CurrentPtr] = EndOfList;  // reset next pointer in the allocated block
-				return(CurrentPtr);	// return memory address
-			}
-		}
-		else  // small block
-		{  // look at next block
-			PreviousPtr = CurrentPtr;
-			CurrentPtr = mem[CurrentPtr];
-		}
-	} // end of while CurrentPtr loop
-
-	printf("ERROR: No Free OS Memory");
-	return(ErrorNoFreeMemory);   // ErrorNoFreeMemory is constant set to < 0
-}
-
-
-/*******************************************************************************
- * Function: FreeOSMemory
- *
- * Description: Sets the allocated free list to a new value such that the
- * system expands the block of memory in free list. The memory that is no
- * longer allocated is considered to be free memory
- *
- * Input Parameters
- * 	- *ptr			A ptr to the block of memory considered 'free'
- * 				by the system
- * 	- size			Size by which to increase the free list
- *
- * Output Parameters
- * 	- None
- *
- * Function Return Value
- * 	- OK
- * 	- ErrorInvalidAddress
- ******************************************************************************/
-
-long FreeOSMemory(long *ptr, long size)
-{
-	if (*ptr < 7000 || *ptr > MAX_OS_MEMORY)
-	{
-		printf("ERROR: Invalid Adress");
-		return(ErrorInvalidAddress);
-	}
-
-	if (size == 1)
-	{
-		size = 2; //minimum allocated size
-	}
-
-	else if (size < 1 || (*ptr + size) >= MAX_OS_MEMORY)
-	{
-		//invalid size
-		printf("ERROR: Invalid size or Invalid Address");
-		return(ErrorInvalidAddress);
-	}
-
-	mem[*ptr] = OSFreeList;
-	mem[*ptr + 1] = size;
-	OSFreeList = *ptr;
-
-	return OK;
-}
-
-/*******************************************************************************
- * Function: AllocateUserMemory
- *
- * Description:
- *      This function is used to specify an amount of space in the user
- memory to be allocated based on the requested size
- *
- * Input Parameters
- *      RequestedSize - long value specfied by the user,
- *                      to determine size of memory block to be allocated
- *                      minimum value is 2 so if user requests less than 2
- *                      the program will automatically change it to 2
- *
- * Output Parameters
- *      None
- *
- * Function Return Value
- *      OK
- *      ErrorNoFreeMemory
- *      ErrorInvalidMemorySize
- *
- * initial implementation done by Jacob Nowlan
- ******************************************************************************/
-
-long AllocateUserMemory(long RequestedSize) //return value contains address or ERROR
-{
-	// Allocate memory from OS free space, which is organized as link
-	if (UserFreeList == EndOfList)
-	{
-		printf("ERROR: No free User memory\n");
-		return(ErrorNoFreeMemory);
-	}
-
-	if (RequestedSize < 0)
-	{
-		printf("ERROR: Invalid Memory Size\n");
-		return(ErrorInvalidMemorySize);
-	}
-
-	if (RequestedSize == 1)
-	{
-		RequestedSize = 2; //minimum allocated memory is 2 locations
-	}
-
-	long CurrentPtr = OSFreeList;
-	long PreviousPtr = EndOfList;
-	while (CurrentPtr != EndOfList)
-	{
-		if (mem[CurrentPtr + 1] == RequestedSize)
-		{//found block with requested Size
-			if (CurrentPtr == UserFreeList) // first block
-			{
-				UserFreeList = mem[CurrentPtr]; //first entry is pointer to next block
-				mem[CurrentPtr] = EndOfList;  //reset next pointer in the allocated blcok
-				return(CurrentPtr); //return memory address
-			}
-			else //not first block
-			{
-				mem[PreviousPtr] = mem[CurrentPtr]; //point to next block
-				mem[CurrentPtr] = EndOfList; //reset next pointer in the allocated block
-				return(CurrentPtr); //return memory address
-			}
-		}
-
-		else if (mem[CurrentPtr + 1] > RequestedSize)
-		{
-			//found block with size greater than RequestedSize
-			if (CurrentPtr == UserFreeList) //first block
-			{
-				mem[CurrentPtr + RequestedSize] = mem[CurrentPtr];
-
-				mem[CurrentPtr + RequestedSize + 1] = mem[CurrentPtr + 1] - RequestedSize;
-
-				UserFreeList = CurrentPtr + RequestedSize; //address of reduced block
-				mem[CurrentPtr] = EndOfList; //reset next pointer in the allocated block
-				return(CurrentPtr); //return memory address
-			}
-			else // not first block
-			{
-				mem[CurrentPtr + RequestedSize] = mem[CurrentPtr]; //move the next block pointer
-
-				mem[CurrentPtr + RequestedSize + 1] = mem[CurrentPtr + 1] - RequestedSize;
-
-				mem[PreviousPtr] = CurrentPtr + RequestedSize; //address of reduced block
-				mem[CurrentPtr] = EndOfList; //Reset next pointer in the allocated block
-				return(CurrentPtr); //return memory address
-			}
-		}
-		else //small block
-		{
-			//look at next block
-			PreviousPtr = CurrentPtr;
-			CurrentPtr = mem[CurrentPtr];
-
-		}
-	} //end of while CurrentPtr loop
-
-	printf("ERROR: No Free User memory\n");
-	return(ErrorNoFreeMemory);
-}
-
-/*******************************************************************************
- * Function: FreeUserMemory
- *
- * Description:
- *      This function frees up space in user memory
- *      This frees memory by using the pointer to specify
- *      the area that will be overridden
- *
- * Input Parameters
- *      ptr  - long value pointing to location in user memory that will be freed
- *      size - amount of space in the user memory to be freed
- *
- * Output Parameters
- *      UserFreeList
- *
- * Function Return Value
- *      ErrorInvalidAddress
- *
- * initial implementation by Jacob Nowlan
- ******************************************************************************/
-
-long FreeUserMemory(long ptr, long size)
-{
-	if (ptr < 0 || ptr > MAX_USER_MEMORY)
-	{
-		printf("ERROR: Invalid Adress");
-		return(ErrorInvalidAddress);
-	}
-
-	if (size == 1)
-	{
-		size = 2; //minimum allocated size
-	}
-
-	else if (size < 1 || (ptr + size) >= MAX_USER_MEMORY)
-	{
-		//invalid size
-		printf("ERROR: Invalid size or Invalid Address");
-		return(ErrorInvalidAddress);
-	}
-
-	mem[ptr] = UserFreeList;
-	mem[ptr + 1] = size; //set the free block size in the given free block
-	UserFreeList = ptr; // user free list points to given free block
-}
-
-/*******************************************************************************
- * Function: MemAllocSystemCall
- *
- * Description: this is a system call used to allow the machine code
- *              to request a service from the operating system,
- *              the service being memory allocation
- *
- * Input Parameters
- *      None
- *
- * Output Parameters
- *      gpr[1]
- *      gpr[2]
- *
- * Function Return Value
- *      OK
- *      ErrorInvalidAddress
- *
- * initial implementation by Jacob Nowlan
- ******************************************************************************/
-
-long MemAllocSystemCall()
-{
-	// Allocate memory from user free list
-	// Return status from the function is either the address of allocated memory or an error code
-
-	long Size = gpr[2];
-
-	//check if size is out of range
-	if (Size < 1 || Size > MAX_USER_MEMORY)
-	{
-		printf("Error: InvalidAddress");
-		return(ErrorInvalidAddress);
-	}
-
-	if (Size == 1)
-		Size = 2;
-
-	gpr[1] = AllocateUserMemory(Size);
-
-	if (gpr[1] < 0)
-	{
-		gpr[0] = gpr[1]; //set GPR0 to have the return status
-	}
-	else
-	{
-		gpr[0] = OK;
-	}
-
-	printf("MemAllocSystemCall - GPR0: %d\tGPR1: %d\tGPR2: %d", gpr[0], gpr[1], gpr[2]);
-
-	return gpr[0];
-}
-
-/*******************************************************************************
- * Function: MemFreeSystemCall
- *
- * Description: this is a system call used to allow the machine code
- *              to request a service from the operating system,
- *              allowing us to free space in user memory
- *
- * Input Parameters
- *      None
- *
- * Output Parameters
- *      gpr[0]
- *
- * Function Return Value
- *      OK
- *      ErrorInvalidAddress
- *
- * implemtation by Jacob Nowlan
- ******************************************************************************/
-
-long MemFreeSystemCall()
-{
-	// Return dynamically allocated memory to the user free list
-	// GPR1 has memory address and GPR2 has memory size to be released
-	// Return status in GPR0
-
-	long Size = gpr[2];
-
-	//check if size is out of range
-	if (Size < 1 || Size > MAX_USER_MEMORY)
-	{
-		printf("Error: InvalidAddress");
-		return(ErrorInvalidAddress);
-	}
-
-	if (Size == 1)
-		Size = 2;
-
-	gpr[0] = FreeUserMemory(gpr[1], Size);
-
-	printf("Mem_Free System Call - GPR0: %d\tGPR1: %d\tGPR2: %d", gpr[0], gpr[1], gpr[2]);
-
-	return gpr[0];
-}
-
-/*******************************************************************************
- * Function: InitializePCB
- *
- * Description:
- *      This function initializes all important values of the PCB
- *      sets all values in the user memory to 0
- *      allocates PID and set in in the pcb
- *      sets default state to ReadyState
- *      sets priority to default priority
- *      sets next pointer to point to end of list
- *
- * Input Parameters
- *      PCBptr  - long value specifying adress in pcb
- *
- * Output Parameters
- *      mem[PCBptr + PCB_Pid]       - ProcessID
- *      mem[PCBptr + PCB_State]     - the state of os
- *      mem[PCBptr + PCB_Priority]  - priority
- *      mem[PCBptr + NextPtr]       - nextPCBlink
- *
- * Function Return Value
- *      None
- *
- * Initial implementation by Jacob Nowlan
- ******************************************************************************/
-
-void InitializePCB(long PCBptr)
-{
-	//Set entire PCB area to 0 using PCBptr;
-	// Array initialization
-	for (int i = 0; i < PCBsize; i++)
-	{
-		mem[PCBptr + i] = 0;
-	}
-	// Allocate PID and set it in the PCB. PID zero is invalidcvoid
-	mem[PCBptr + PCB_Pid] = ProcessID++;  // ProcessID is global variable initialized to 1
-
-	//Set state field in the PCB = ReadyState;
-	mem[PCBptr + PCB_State] = ReadyState;
-
-	//Set priority field in the PCB = Default Priority;
-	mem[PCBptr + PCB_Priority] = DEFAULT_PRIORITY;
-
-	//Set next PCB pointer field in the PCB = EndOfList
-	mem[PCBptr + NextPtr] = EndOfList;
-
-	return;
-}
-
-/*******************************************************************************
- * Function: PrintPCB
- * Description: This function simply displays the status of the current PCB
- *
- * Input Parameters
- *      PCBptr      - the pointer to the start of the PCB
- *
- * Output Parameters
- *      None
- *
- * Function Return Value
- *      None
- *
- * Initial implementation by Jacob Nowlan
- ******************************************************************************/
-
-void PrintPCB(long PCBptr)
-{
-	printf("PCB address = %d\n",  PCBptr);
-	printf("Next PCB Ptr = %d\n", mem[PCBptr + NextPtr]);
-	printf("PID = %d\n", mem[PCBptr + PCB_Pid]);
-	printf("State = %d\n", mem[PCBptr + PCB_State]);
-	printf("PC = %d\n", mem[PCBptr + PCB_PC]);
-	printf("SP = %d\n", mem[PCBptr + PCB_SP]);
-	printf("Priority = %d\n", mem[PCBptr + PCB_Priority]);
-	printf("Stack Info: start address = %d\n", mem[PCBptr + PCB_StackStartAddr]);
-	printf("Size = %d\n", mem[PCBptr + PCB_StackSize]);
-	printf("GPR 0 = %d\n", mem[PCBptr + PCB_GPR0]);
-	printf("GPR 1 = %d\n", mem[PCBptr + PCB_GPR1]);
-	printf("GPR 2 = %d\n", mem[PCBptr + PCB_GPR2]);
-	printf("GPR 3 = %d\n", mem[PCBptr + PCB_GPR3]);
-	printf("GPR 4 = %d\n", mem[PCBptr + PCB_GPR4]);
-	printf("GPR 5 = %d\n", mem[PCBptr + PCB_GPR5]);
-	printf("GPR 6 = %d\n", mem[PCBptr + PCB_GPR6]);
-	printf("GPR 7 = %d\n", mem[PCBptr + PCB_GPR7]);
-
-	return;
-
-}  // end of PrintPCB() function
-
-/*******************************************************************************
- * Function: PrintQueue
- *
- * Description: This function will print all of the processes
- *              that are in the queue until it reaches the EndOfList
- *
- * Input Parameters
- *      Qptr    -pointer to a process in the queue
- *
- * Output Parameters
- *      none
- *
- * Function Return Value
- *      OK
- ******************************************************************************/
-
-long PrintQueue(long Qptr)
-{
-	long currentPCBPtr = Qptr;
-
-	if (currentPCBPtr == EndOfList)
-	{
-		printf("Empty List\n");
-		return(OK);
-	}
-
-	while (currentPCBPtr != EndOfList)
-	{
-		//Print PCB passing currentPCBPtr
-		PrintPCB(currentPCBPtr);
-		//currentPCBPtr = nextPCBlink;
-		currentPCBPtr = mem[currentPCBPtr + NextPtr];
-	}
-
-	return(OK);
-}
-
-/*******************************************************************************
- * Function: SelectProcessFromRQ
- *
- * Description: Selects the process that is at the front of the Ready Queue.
- *
- * Input Parameters
- * - None
- *
- * Output Parameters
- * - PCBptr			The ptr to the PCB which is to be run
- *
- * Function Return Value
- * - None
- ******************************************************************************/
-
-long SelectProcessFromRQ()
-{
-	long PCBptr = RQ;
-
-	if (RQ != EndOfList)
-	{
-		// Remove first PCB RQ
-
-		// Set RQ = next PCB pointed by RQ
-		RQ = mem[RQ + NextPtr];
-	}
-
-	// Set next point to EOL in the PCB
-	// Set Next PCBfield in the given PCB to End of List
-
-	mem[PCBptr + NextPtr] = EndOfList;
-
-	return(PCBptr);
-} //end of SelectProcessFromRQ
-
-
-/*******************************************************************************
- * Function: SaveContext
- *
- * Description: Save context stores all of the current values of the gpr's into
- *              the PCB, as well as storing the SP and PC into the PCB
- *
- * Input Parameters
- *      PCBptr      -Pointer to start of PCB
- *
- * Output Parameters
- *      mem[PCBptr + PCB_GPR0]
- *      mem[PCBptr + PCB_GPR1]
- *      mem[PCBptr + PCB_GPR2]
- *      mem[PCBptr + PCB_GPR3]
- *      mem[PCBptr + PCB_GPR4]
- *      mem[PCBptr + PCB_GPR5]
- *      mem[PCBptr + PCB_GPR6]
- *      mem[PCBptr + PCB_GPR7]
- *      mem[PCBptr + PCB_SP]
- *      mem[PCBptr + PCB_PC]
- *
- * Function Return Value
- *      None
- *
- * initial implementation by Jacob Nowlan
- ******************************************************************************/
-
-void SaveContext(long PCBptr)
-{
-	//Assume PCBptr is a valid pointer
-
-	mem[PCBptr + PCB_GPR0] = gpr[0];
-	mem[PCBptr + PCB_GPR1] = gpr[1];
-	mem[PCBptr + PCB_GPR2] = gpr[2];
-	mem[PCBptr + PCB_GPR3] = gpr[3];
-	mem[PCBptr + PCB_GPR4] = gpr[4];
-	mem[PCBptr + PCB_GPR5] = gpr[5];
-	mem[PCBptr + PCB_GPR6] = gpr[6];
-	mem[PCBptr + PCB_GPR7] = gpr[7];
-
-	mem[PCBptr + PCB_SP] = sp;
-
-	mem[PCBptr + PCB_PC] = pc;
-
-
-	//Copy all CPU GPRs into PCB using PCBptr with or without using loop
-
-	//Set SP field in the PCB=SP; //Save SP
-	//Set PC field in the PCB=PC; //Save PC
-}
-
-/*******************************************************************************
- * Function: Dispatcher
- *
- * Description: The Dispatcher serves as the opposite of save context
- *              this funtion stores the values of pcb into the systems GPR's,
- *              sp, and pc, as well as setting the psr to user mode
- *
- * Input Parameters
- *      PCBptr      - long value pointing to pcb
- *
- * Output Parameters
- *      gpr[0]
- *      gpr[1]
- *      gpr[2]
- *      gpr[3]
- *      gpr[4]
- *      gpr[5]
- *      gpr[6]
- *      gpr[7]
- *      sp
- *      pc
- *      psr
- *
- * Function Return Value
- *      None
- *
- * Initial implementation by Jacob Nowlan
- ******************************************************************************/
-
-void Dispatcher(long PCBptr)
-{
-	//PCBptr is assumed to be correct
-
-	//copy CPU GPR register values from given PCB into the CPU registers
-	//This is opposite of save CPU context
-
-	//Restore SP and PC from given PCB
-	gpr[0] = mem[PCBptr + PCB_GPR0];
-	gpr[1] = mem[PCBptr + PCB_GPR0];
-	gpr[2] = mem[PCBptr + PCB_GPR2];
-	gpr[3] = mem[PCBptr + PCB_GPR3];
-	gpr[4] = mem[PCBptr + PCB_GPR4];
-	gpr[5] = mem[PCBptr + PCB_GPR5];
-	gpr[6] = mem[PCBptr + PCB_GPR6];
-	gpr[7] = mem[PCBptr + PCB_GPR7];
-
-	sp = mem[PCBptr + PCB_SP];
-	pc = mem[PCBptr + PCB_PC];
-
-	psr = MACHINE_MODE_USER;
-
-	return;
-}
-
-/*******************************************************************************
- * Function: InsertIntoRQ
- *
- * Description: Inserts a Process into the Ready Queue at some position
- * dependent on it's priority.
- *
- * Input Parameters
- * - *PCBptr			Pointer to the PCB that is to be inserted
- *
- * Output Parameters
- * - None
- *
- * Function Return Value
- * 	OK
- * 	ErrorInvalidAddress
- ******************************************************************************/
-
-long InsertIntoRQ(long *PCBptr)
-{
-	// Insert PCB according to Priority Round Robin algorithm
-	// Use priority in the PCB to find the correct place to insert
-	long PreviousPtr = EndOfList;
-	long CurrentPtr = EndOfList;
-
-	//check for invalid PCB memory address
-	if ((PCBptr < 0) || (*PCBptr > MAX_USER_MEMORY))
-	{
-		printf("ERROR: Invalid Memory Address ");
-		return(ErrorInvalidAddress);
-	}
-
-	mem[*PCBptr + PCB_State] = Ready;   //set state to ready
-	mem[*PCBptr + NextPtr] = EndOfList; //set next pointer to end of list
-
-	if (RQ == EndOfList) //RQ is empty
-	{
-		RQ = *PCBptr;
-		return(OK);
-	}
-
-	//walk thru RQ and find place to insert
-	// PCB will be inserted at the end of its priority
-
-	while (CurrentPtr != EndOfList)
-	{
-		if (mem[*PCBptr + PCB_Priority] > mem[CurrentPtr + PCB_Priority])
-		{
-			if (PreviousPtr == EndOfList)
-			{
-				// Enter PCB in the front of the list as first entry
-				mem[*PCBptr + NextPtr] = RQ;
-				RQ = *PCBptr;
-				return(OK);
-			}
-			//enter PCB in the middle of the list
-			mem[*PCBptr + NextPtr] = mem[PreviousPtr + NextPtr];
-			mem[PreviousPtr + NextPtr] = *PCBptr;
-			return(OK);
-		}
-		else //PCB to inserted has lower or equal priority to the Current PCB in RQ
-		{
-			//go to next PCB in RQ
-			PreviousPtr = CurrentPtr;
-			CurrentPtr = mem[CurrentPtr + NextPtr];
-		}
-	} // end of while loop
-
-	//insert PCB at the end of RQ
-	mem[PreviousPtr + NextPtr] = *PCBptr;
-	return(OK);
-}
-
-/*** FUNCTIONS ***/
-/*******************************************************************************
- * Function: InsertIntoWQ
- *
- * Description: Inserts a Process into the Waiting Queue. The Waiting Queue is
- * not sorted by priority
- *
- * Input Parameters
- * - *PCBptr			Pointer to the PCB that is to be inserted
- *
- * Output Parameters
- * - None
- *
- * Function Return Value
- * 	OK
- * 	ErrorInvalidAddress
- *
- ******************************************************************************/
-
-long InsertIntoWQ(long *PCBptr)
-{
-	//insert given PCB at the front of InsertIntoWQ
-
-	//check for invalid PCB memory Address
-	if ((PCBptr < 0) || (*PCBptr > MAX_OS_MEMORY))
-	{
-		printf("ERROR: Invalid PCB address");
-		return(ErrorInvalidAddress); //error code < 0
-	}
-
-	mem[*PCBptr + PCB_State] = Waiting; //What
-	mem[*PCBptr + NextPtr] = WQ;
-
-	WQ = *PCBptr;
-
-	return(OK);
-} //end of InsertIntoWQ() function
-
-/*******************************************************************************
- * Function: CheckAndProcessInterrupt
- *
- * Description: Read interrupt ID number. Based on the interrupt ID,
- * service the interrupt.
- *
- * Input Parameters: N/A
- *
- * Output Parameters: N/A
- *
- * Function Return Value: N/A
- *
- * Initial implementation by Douglas Perkins
- ******************************************************************************/
-
-void CheckAndProcessInterrupt()
-{
-
-	int InterruptID;
-	// Prompt and read interrupt ID
-	printf("Possible interrupt IDs: \n0 - no interrupt"
-			"\n1 - run program"
-			"\n2 - shutdown system"
-			"\n3 - input operation completion (io_getc)"
-			"\n4 - output operation completion (io_putc)");
-
-	printf("Input interrupt ID: ");
-	scanf("%d", &InterruptID);
-	printf("Interrupt read: %d\n", InterruptID);
-
-	// Process interrupt
-	switch(InterruptID)
-	{
-		case 0: // no interrupt
-			break;
-
-		case 1: // run program
-			ISRrunProgramInterrupt();
-			break;
-
-		case 2: // shutdown system
-			ISRshutdownSystem();
-			SysShutdownStatus = 1;
-			break;
-
-		case 3: // input operation completion (io_getc)
-			ISRinputCompletionInterrupt();
-			break;
-
-		case 4: // output operation completion (io_putc)
-			ISRoutputCompletionInterrupt();
-			break;
-
-		default: // invalid interrupt ID
-			printf("Invalid interrupt ID");
-			break;
-	}
-
-	return;
-}
-
-
-/*******************************************************************************
- * Function: ISRrunProgramInterrupt
- *
- * Description: Read filename and create process.
- *
- * Input Parameters:
- * - None
- *
- * Output Parameters
- * - None
- *
- * Function Return Value
- *
- * Initial implementation by Douglas Perkins
- ******************************************************************************/
-
-void ISRrunProgramInterrupt()
-{
-	char filename[30];
-
-	// Prompt and read filename
-	printf("Input filename: ");
-	fgets(filename, 30, stdin);
-	strtok(filename, "\n");
-
-	// Call Create Process passing filename and Default Priority as arguments
-	CreateProcess(filename, DEFAULT_PRIORITY);
-
-	return;
-}
-
-
-
-/*******************************************************************************
- * Function: Input Completion Interrupt
- *
- * Description: Read PID of the process completing the io_getc operation and
- * 				read one character from the keyboard (input device). Store the
- * 				character in the GPR in the PCB of the process.
- *
- * Input Parameters: N/A
- *
- * Output Parameters: N/A
- *
- * Function Return Value: N/A
- *
- * Initial implementation by Douglas Perkins
- ******************************************************************************/
-
-void ISRinputCompletionInterrupt()
-{
-
-	int ProcessID;
-	long currentPCBptr = WQ;
-	char PCBReplacementChar;
-	long previousPCBptr = EndOfList;
-	char GPRChar;
-
-	// Prompt and read PID of the process completing input completion
-	printf("Input PID of the process completing input completion: ");
-	scanf("%d", &ProcessID);
-
-	// Search WQ to find the PCB having the given PID
-	while(currentPCBptr != EndOfList){
-		if(mem[currentPCBptr + NextPtr] == ProcessID){ // Try to find match in WQ
-			// match found, remove from WQ
-			if (previousPCBptr == EndOfList){
-				// first PCB
-				WQ = mem[currentPCBptr + NextPtr];
-			}
-			else
-			{
-				// not first PCB
-				mem[previousPCBptr + NextPtr] = mem[currentPCBptr + NextPtr];
-			}
-			mem[currentPCBptr + NextPtr] = EndOfList;
-
-			// This part of the code might not fit here, the pseudocode is hurting my brain.
-			// Read one character from standard input device keyboard
-			printf("Enter a character: ");
-			GPRChar = getchar();
-
-			// Store the character in the GPR in the PCB, type cast char->long
-			mem[currentPCBptr + PCB_GPR0] = GPRChar;
-
-			// Set the process state to Ready in the PCB
-			mem[currentPCBptr + PCB_State] = "Ready";
-
-			// Insert PCB into RQ
-			InsertIntoRQ(&currentPCBptr);
-			//return;
-		}
-
-		previousPCBptr = currentPCBptr;
-		currentPCBptr = mem[currentPCBptr + NextPtr];
-	} // Pretty sure the while needs to end here.
-
-	// Search RQ to find the PCB having the given PID
-	while(currentPCBptr != EndOfList){
-		// If no match is found in WQ, then search RQ
-		currentPCBptr = RQ;
-
-		if(mem[currentPCBptr + NextPtr] == ProcessID){ // Try to find match in RQ
-			// match found, remove from RQ? Pseudocode doesn't say to remove from RQ.
-			/*
-			   if (previousPCBptr == EndOfList){
-			// first PCB
-			RQ = mem[*currentPCBptr + NextPtr];
-			}
-			else
-			{
-			// not first PCB
-			mem[*previousPCBptr + NextPtr] = mem[*currentPCBptr + NextPtr];
-			}
-			*/
-
-			//mem[*currentPCBptr + NextPtr] = EndOfList;
-
-			// This part of the code might not fit here, the pseudocode is hurting my brain.
-			// Read one character from standard input device keyboard
-			printf("Enter a character: ");
-			GPRChar = getchar();
-
-			// Store the character in the GPR in the PCB, type cast char->long
-			mem[currentPCBptr + PCB_GPR0] = GPRChar;
-			// break;
-		}
-		// break;
-
-		previousPCBptr = currentPCBptr;
-		currentPCBptr = mem[currentPCBptr + NextPtr];
-	}
-
-	// If no matching PCB is found in WQ, and RQ, print invalid PID as an error message.
-	printf("Invalid Process ID");
-	return;
-}
-
-
-/*******************************************************************************
- * Function: Output Completion Interrupt
- *
- * Description: Read PID of the process completing the io_putc operation and
- * 				display one character on the monitor (output device) from the GPR
- * 				in the PCB of the process
- *
- * Input Parameters: N/A
- *
- * Output Parameters: N/A
- *
- * Function Return Value: N/A
- *
- * Initial implementation by Douglas Perkins
- ******************************************************************************/
-
-void ISRoutputCompletionInterrupt()
-{
-
-	int ProcessID;
-	long currentPCBptr = WQ;
-	char PCBReplacementChar;
-	long previousPCBptr = EndOfList;
-	char GPRChar;
-
-	// Prompt and read PID of the process completing input completion
-	printf("Input PID of the process completing input completion: ");
-	scanf("%d", &ProcessID);
-
-	// Search WQ to find the PCB having the given PID
-	while(currentPCBptr != EndOfList){
-		if(mem[currentPCBptr + NextPtr] == ProcessID){ // Try to find match in WQ
-			// match found, remove from WQ
-			if (previousPCBptr == EndOfList){
-				// first PCB
-				WQ = mem[currentPCBptr + NextPtr];
-			}
-			else
-			{
-				// not first PCB
-				mem[previousPCBptr + NextPtr] = mem[currentPCBptr + NextPtr];
-			}
-			mem[currentPCBptr + NextPtr] = EndOfList;
-
-			// This part of the code might not fit here, the pseudocode is hurting my brain.
-			// Read one character from standard input device keyboard
-			//printf("Enter a character: ");
-			//GPRChar = getchar();
-
-			// Print the character in the GPR in the PCB
-			// Cast to char?
-			printf("%c", (char)mem[currentPCBptr + PCB_GPR0]);
-
-			// Store the character in the GPR in the PCB, type cast char->long
-			// mem[*currentPCBptr + PCB_GPR0] = long(GPRChar);
-
-			// Set the process state to Ready in the PCB
-			mem[currentPCBptr + PCB_State] = "Ready";
-
-			// Insert PCB into RQ
-			InsertIntoRQ(&currentPCBptr);
-			//return;
-		}
-
-		previousPCBptr = currentPCBptr;
-		currentPCBptr = mem[currentPCBptr + NextPtr];
-	} // Pretty sure the while needs to end here.
-
-	// Search RQ to find the PCB having the given PID
-	while(currentPCBptr != EndOfList){
-		// If no match is found in WQ, then search RQ
-		currentPCBptr = RQ;
-
-		if(mem[currentPCBptr + NextPtr] == ProcessID){ // Try to find match in RQ
-			// match found, remove from RQ? Pseudocode doesn't say to remove from RQ.
-			/*
-			   if (previousPCBptr == EndOfList){
-			// first PCB
-			RQ = mem[*currentPCBptr + NextPtr];
-			}
-			else
-			{
-			// not first PCB
-			mem[*previousPCBptr + NextPtr] = mem[*currentPCBptr + NextPtr];
-			}
-			*/
-
-			//mem[*currentPCBptr + NextPtr] = EndOfList;
-
-			// Print the character in the GPR in the PCB
-			printf("%c", (char)mem[currentPCBptr + PCB_GPR0]);
-
-			// This part of the code might not fit here, the pseudocode is hurting my brain.
-			// Read one character from standard input device keyboard
-			//printf("Enter a character: ");
-			//GPRChar = getchar();
-
-		}
-		// break;
-
-		previousPCBptr = currentPCBptr;
-		currentPCBptr = mem[currentPCBptr + NextPtr];
-	}
-
-	// If no matching PCB is found in WQ, and RQ, print invalid PID as an error message.
-	printf("Invalid Process ID");
-	return;
-}
-
-
-/*******************************************************************************
- * Function: SearchAndRemovePCBfromWQ
- *
- * Description: Search the WQ for the matching PID.
- * 				When a match is found remove it from WQ and return PCB pointer.
- * 				If no match is found, return invalid PID error code.
- *
- * Input Parameters: N/A
- *
- * Output Parameters: N/A
- *
- * Function Return Value: N/A
- *
- * Initial implementation by Douglas Perkins
- ******************************************************************************/
-long SearchAndRemovePCBfromWQ(long ProcessID){
-
-	long currentPCBptr = WQ;
-	long previousPCBptr = EndOfList;
-
-	// Search WQ for a PCB that has the given PID
-	// If a match is found, remove it from WQ and return the PCB pointer.
-	while(currentPCBptr != EndOfList){
-		if(mem[currentPCBptr + NextPtr] == ProcessID){
-			// match found, remove from WQ
-			if (previousPCBptr == EndOfList){
-				// first PCB
-				WQ = mem[currentPCBptr + NextPtr];
-			}
-			else
-			{
-				// not first PCB
-				mem[previousPCBptr + NextPtr] = mem[currentPCBptr + NextPtr];
-			}
-			mem[currentPCBptr + NextPtr] = EndOfList;
-			return(currentPCBptr);
-		}
-		previousPCBptr = currentPCBptr;
-		currentPCBptr = mem[currentPCBptr + NextPtr];
-	}
-
-	printf("Process ID not found.");
-	return(EndOfList);
-}
-
-
-/*******************************************************************************
- * Function: ISRshutdownSystem
- *
- * Description: Terminate all Processes in RQ so that the system can shut down
- *
- * Input Parameters:
- * 	- None
- *
- * Output Parameters:
- * 	- None
- *
- * Function Return Value:
- * 	- None
- *
- * Initial implementation by Douglas Perkins
- ******************************************************************************/
-void ISRshutdownSystem(){
-
-	// Terminate all processes in RQ one by one.
-	long PCBptr = RQ;
-
-	while(PCBptr != EndOfList){
-		RQ = PCBptr;
-		TerminateProcess(PCBptr);
-		PCBptr = RQ;
-	}
-
-	// Terminate all processes in WQ one by one.
-	PCBptr = WQ;
-	while(PCBptr != EndOfList){
-		WQ = PCBptr;
-		TerminateProcess(PCBptr);
-		PCBptr = WQ;
-	}
-
-	return;
-}
-
-/*******************************************************************************
- * Function: IOGetC
- *
- * Description: Obtain one character from the user. Forces rescheduling
- *
- * Input Parameters: R1 = the character read
- *
- * Output Parameters
- * 		1. R0 = return code, always OK.
- *
- * Function Return Value
- *
- * Initial implementation by Douglas Perkins
- ******************************************************************************/
-
-long IOGetCSystemCall()
-{
-	gpr[1] = getchar();
-	gpr[0] = StartOfInput;
-	return gpr[1];
-}
-
-/*******************************************************************************
- * Function: IOPutC
- *
- * Description: Specifies a character to be printed on the user terminal.
- * Forces rescheduling
- * Input Parameters: R1 = character to be displayed
- *
- * Output Parameters
- * 		1. R0 = return code, always OK
- *
- * Function Return Value
- *
- * Initial implementation by Douglas Perkins
- ******************************************************************************/
-
-long IOPutCSystemCall()
-{
-	//printf("%d\n", R1);
-	putchar(gpr[1]);
-	gpr[0] = StartOfOutput;
-	return gpr[0];
-}
-
-
+#define clock HostClock		// Keeps the name `clock` for the simulated clock
+#include <time.h>
+#undef clock
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <dlfcn.h>
+
+/*** MACHINE CONFIGURATION ***/
+// The machine is fixed when the simulator is built, so every bound derived
+// from it is a constant the compiler folds. Build a larger machine with
+// -DMACHINE_WORDS=100000 or -DMACHINE_WORDS=1000000: the user, heap and OS
+// regions keep the proportions of the classic 10000-word machine.
+// -DTIMESLICE changes the clock a process runs before it is preempted.
+#ifndef MACHINE_WORDS
+#define MACHINE_WORDS		10000
+#endif
+#ifndef TIMESLICE
+#define TIMESLICE		200
+#endif
+#if MACHINE_WORDS < 10000 || MACHINE_WORDS % 1000 != 0
+#error "MACHINE_WORDS must be a multiple of 1000, at least 10000"
+#endif
+
+/*** VIRTUAL SYSTEM PARAMETERS ***/
+#define SYSTEM_MEMORY_SIZE      MACHINE_WORDS
+#define GPR_NUMBER              8	// PCB_GPR0 to PCB_GPR7
+#define LAST_OPCODE		27	// TestAndSet
+#define DEFAULT_PRIORITY	128
+#define DEFAULT_STACK_SIZE	20
+#define MAX_PROCESSES		128	// More PCBs than fit in OS memory
+#define ReadyState 1
+#define EndOfList -1
+
+/*** VIRTUAL MEMORY PARAMETERS ***/
+#define PAGE_SIZE		100
+#define MAX_VIRTUAL_MEMORY	(2 * MACHINE_WORDS - 1)	// Highest address of a paged process
+#define MAX_FRAMES		((MAX_USER_MEMORY + 1) / PAGE_SIZE)
+#define TLB_SIZE		16	// Entries, direct mapped by page number
+#define SWAP_PAGES		4096	// Host-side backing store
+#define PAGE_FAULT_TIME		100	// Clock charged for a page-in
+#define MIN_FRAMES		4	// Pages one instruction can touch
+#define NotResident		-1
+
+/*** IMAGE CACHE PARAMETERS ***/
+#define MAX_IMAGES		16	// Object modules kept parsed
+#define MAX_SHARED_SEGMENTS	64
+
+/*** MAILBOX PARAMETERS ***/
+#define MAILBOX_SLOTS		8	// Messages a mailbox holds
+#define MSG_SIZE		4	// Words per message slot
+#define MAILBOX_SIZE		(2 + MAILBOX_SLOTS * MSG_SIZE)
+
+/*** TIMER PARAMETERS ***/
+#define WHEEL_BITS		6
+#define WHEEL_SLOTS		(1 << WHEEL_BITS)	// Slots per wheel level
+#define WHEEL_LEVELS		3	// Deadlines up to 2^18 ticks ahead
+#define MAX_TIMERS		256
+
+/*** CONSOLE PARAMETERS ***/
+#define MAX_IO_BLOCK		256	// Words moved by one io_read or io_write
+
+/*** DISK PARAMETERS ***/
+#define DISK_BLOCK_SIZE		64	// Words per block
+#define DISK_BLOCKS		1024
+#define DISK_TRACK_BLOCKS	16	// Blocks per track, one per sector
+#define DISK_SECTOR_TIME	8	// Clock for a sector to pass under the head
+#define DISK_SEEK_TIME		2	// Clock per track crossed
+#define DISK_SETTLE_TIME	20	// Clock added to any seek
+#define MAX_DISK_REQUESTS	64
+
+/*** MAPPED FILE PARAMETERS ***/
+#define MAX_MAPPINGS		16	// Files mapped at once, by every process
+
+/*** STATISTICS PAGE PARAMETERS ***/
+#define STATS_VERSION		1	// Changes with struct StatsPage
+#define STATS_PERIOD		10000	// Clock between walks of the queues and free lists
+#define MAX_SYSTEM_CALL		21	// Munmap
+
+/*** LOCKSTEP PARAMETERS ***/
+#define MAX_LANES		65536
+#define LANE_GROUP		64		// Lanes stepped together
+#define LANE_CLOCK_LIMIT	100000000	// Clock after which a lane is stopped
+
+// The lane loops need 64-bit compares and blends, which SSE2 lacks: GCC
+// also builds them for AVX2 and AVX-512 and picks one when the program loads
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define LANE_TARGETS	__attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define LANE_TARGETS
+#endif
+
+/*** VALUE CONSTANTS ***/
+#define SCRIPT_INDICATOR_END	-1
+#define SCRIPT_INDICATOR_RELOCATE	-2	// "-2 address": word holds a program address
+#define MAX_FILENAME		128
+#define IMAGE_MAGIC		"HYPO"	// Binary image header (tools/hypothesize.c -b)
+
+// Simulator Execution Status
+#define SIMULATOR_STATUS_HALTED	0
+#define SIMULATOR_STATUS_OK	1
+
+// Machine PSR Modes
+#define MACHINE_MODE_USER	0
+#define MACHINE_MODE_OS		1
+
+// Condition flags in the PSR, set by Compare
+#define PSR_ZERO		2	// Op1 = Op2
+#define PSR_NEGATIVE		4	// Op1 < Op2
+#define PSR_FLAGS		(PSR_ZERO | PSR_NEGATIVE)
+
+
+// Memory Models
+#define MMU_FLAT		0	// Every process sees physical 0-3999
+#define MMU_SEGMENT		1	// Base/limit relocation per process
+#define MMU_PAGED		2	// Demand paging through a TLB
+
+// Page Replacement Policies
+#define PAGE_CLOCK		0	// Second chance on the referenced bit
+#define PAGE_LRU		1	// Least recently used, by reference aging
+
+// Disk Scheduling Policies
+#define DISK_FCFS		0	// Requests in arrival order
+#define DISK_LOOK		1	// Elevator: sweep to the last request, then reverse
+
+// Memory-Space Boundaries (non-inclusive), 3999, 6999 and 9999 in the
+// classic machine
+#define MAX_USER_MEMORY         (MACHINE_WORDS / 10 * 4 - 1)
+#define MAX_HEAP_MEMORY         (MACHINE_WORDS / 10 * 7 - 1)
+#define MAX_OS_MEMORY         	(MACHINE_WORDS - 1)
+
+/*** ERROR CODES ***/
+#define OK                      -1
+#define ErrorFileOpen           -2
+#define ErrorInvalidAddress     -3
+#define ErrorInvalidPCValue     -4
+#define ErrorNoEndOfProgram     -5
+#define ErrorInvalidInstruction -6
+#define ErrorInvalidOpcode      -7
+#define ErrorInvalidMode        -8
+#define ErrorImmediateMode      -9
+#define ErrorRuntime            -10
+#define ErrorStackOverflow      -11
+#define ErrorStackUnderflow     -12
+#define ErrorInvalidMemorySize  -13
+#define ErrorNoFreeMemory       -14
+#define ErrorPageFault          -15	// Page not resident, the instruction is restarted
+#define ErrorNoChild            -16	// Wait by a process without such a child
+#define ErrorMailboxFull        -17
+#define ErrorNoProcess          -18	// Message to a PID that does not exist
+#define ErrorNoTimer            -19	// Timer_wait without a periodic timer
+#define ErrorNoDevice           -20	// Disk request without a disk (-d)
+
+/*** EVENT CODES ***/
+// Event codes share the CPU return value with SIMULATOR_STATUS_HALTED (0)
+#define StartOfInput			1
+#define StartOfOutput			2
+#define InputCompletion			3
+#define OutputCompletion		4
+#define TimeSliceExpired		5
+#define WaitForChild			6	// Process_inquiry found no terminated child
+#define ChildTermination		7	// Reason of a process waiting for a child
+#define WaitForMessage			8	// Msg_receive found the mailbox empty
+#define MessageArrival			9	// Reason of a process waiting for a message
+#define WaitForTimer			10	// Sleep or timer_wait blocks the process
+#define TimerExpiry			11	// Reason of a process waiting for a timer
+#define StartOfBlockInput		12	// Io_read: the line is already in memory
+#define StartOfBlockOutput		13
+#define BlockInputCompletion		14
+#define BlockOutputCompletion		15
+#define StartOfDiskIO			16	// Disk_read or disk_write queued a request
+#define DiskCompletion			17	// Reason of a process waiting for the disk
+#define NativeFallback			18	// Native code hands the process to CPU
+
+/*** GLOBAL VARS ***/
+long mem[SYSTEM_MEMORY_SIZE], gpr[GPR_NUMBER];
+long mar, mbr, clock, ir, psr, pc, sp;
+long base, limit;	// Memory-protection unit: program segment of the running process
+long codebase, codelimit;	// Addresses below codelimit are relocated by codebase
+long stackbase, stacklimit;	// Stack of the running process, sp from stackbase - 1 to stacklimit
+long OSFreeList = EndOfList;
+long UserFreeList = EndOfList;
+long ProgramFreeList = EndOfList;	// Program segments in the user region
+long RQ = EndOfList;
+long WQ = EndOfList;	// Printed in main and must therefore be initialized
+long SysShutdownStatus;
+long NullProcessPtr = EndOfList;	// PCB of the process created by InitializeSystem
+long RunningPCB = EndOfList;	// PCB given the CPU by the Dispatcher
+long ContextPCB = EndOfList;	// PCB whose registers the CPU holds unsaved
+long ZombieQ = EndOfList;	// Terminated children whose parent has not waited
+
+// Simulator Run Options
+int InteractiveMode = 1;	// Prompt for interrupts on every scheduling pass
+int VerboseMode = 1;		// Dump queues, PCBs and memory while running
+int MemoryModel = MMU_SEGMENT;
+char *LaneInputs = NULL;	// Inputs file of a lockstep sweep, run without the OS
+
+/*** STATISTICS ***/
+long InstructionCount = 0;	// Instructions executed by every engine
+long ContextSwitchCount = 0;	// Processes given the CPU by the Dispatcher
+long ContextReuses = 0;		// Dispatches of the process the CPU still held
+long HostStartTime = 0;		// Host time (ns) when scheduling began
+long VerifiedCount = 0;		// Instructions run on the verified fast path
+
+long TLBHits = 0, TLBMisses = 0;
+long PageFaults = 0, PageEvictions = 0, PageWriteBacks = 0;
+long ImageHits = 0, ImageMisses = 0, CopiesOnWrite = 0;
+long ForkCount = 0;			// Processes created by process_create
+long MessagesSent = 0, MessagesReceived = 0;
+long MessageLatency = 0;		// Simulated clock from send to receive, summed
+long TimerExpiries = 0;
+long SystemCallCount = 0;
+long BlockTransfers = 0;		// Io_read and io_write requests
+long IdleClock = 0;			// Clock skipped while every process slept
+long DiskRequests = 0, DiskSeekTracks = 0;
+long DiskServiceClock = 0;		// Simulated clock from request to completion, summed
+long FilesMapped = 0, MappedWriteBacks = 0;	// Mmap calls and dirty pages written
+long SystemCallsByID[MAX_SYSTEM_CALL + 1];	// 0 counts invalid IDs
+
+/*** PAGED MEMORY ***/
+// Page tables live in the OS region, one PTE per virtual page. The base
+// register holds the page table address and limit the virtual size. Frames
+// are the pages of the user region; the frame table, TLB and backing store
+// are host-side hardware state.
+const int PTEsize = 2;
+const int PTE_Frame = 0;		// Frame number or NotResident
+const int PTE_Swap = 1;			// Backing store slot
+
+int ReplacementPolicy = PAGE_CLOCK;
+long FrameCount = MAX_FRAMES;
+long FrameOwner[MAX_FRAMES];		// Page table of the process using the frame
+long FramePage[MAX_FRAMES];
+unsigned char FrameReferenced[MAX_FRAMES], FrameDirty[MAX_FRAMES], FrameAge[MAX_FRAMES];
+long ClockHand = 0;
+long TLBPage[TLB_SIZE], TLBFrame[TLB_SIZE];
+long TLBOwner = EndOfList;		// Page table whose translations the TLB holds
+long SwapSpace[SWAP_PAGES][PAGE_SIZE];
+long SwapNext[SWAP_PAGES];
+long SwapFreeList = EndOfList;
+long FaultAddress;			// Virtual address of the last page fault
+long RestartPC, RestartGPR[GPR_NUMBER];
+
+/*** TIMER WHEEL ***/
+// Hierarchical timing wheel driven by clock. Level 0 has one slot per tick;
+// a slot of level n covers WHEEL_SLOTS^n ticks and is cascaded into the
+// level below when the wheel reaches it. Timers are host-side entries in
+// doubly linked slot lists, so starting, stopping and expiring one is O(1).
+long Wheel[WHEEL_LEVELS * WHEEL_SLOTS];	// First timer of each slot, by level
+long WheelTime = 0;			// Next tick to process
+long TimerNext[MAX_TIMERS], TimerPrev[MAX_TIMERS];
+long TimerDeadline[MAX_TIMERS];		// Clock at which the timer expires
+long TimerPeriod[MAX_TIMERS];		// 0 for a one-shot timer
+long TimerOwner[MAX_TIMERS];		// PCB of the process
+long TimerSlot[MAX_TIMERS];		// Level * WHEEL_SLOTS + slot, EndOfList when stopped
+long TimerFreeList = EndOfList;
+long TimersInUse = 0;
+long TimeOffset = 0;			// Time of day minus clock, set by time_set
+
+/*** DISK ***/
+// Block device backed by a host file. Requests are host-side entries in a
+// pending list; the controller serves one at a time, chosen by DiskPolicy,
+// and moves the block between the file and its heap buffer by DMA once the
+// seek, rotation and transfer time of the request has passed.
+int DiskFile = -1;			// Host file descriptor, -1 without a disk
+int DiskPolicy = DISK_LOOK;
+long DiskBlock[MAX_DISK_REQUESTS], DiskBuffer[MAX_DISK_REQUESTS];
+char DiskWrite[MAX_DISK_REQUESTS];
+long DiskOwner[MAX_DISK_REQUESTS];	// PCB of the process, EndOfList once it died
+long DiskQueued[MAX_DISK_REQUESTS];	// Clock of the request
+long DiskNext[MAX_DISK_REQUESTS];
+long DiskPending = EndOfList;		// Requests not started, in arrival order
+long DiskFreeList = EndOfList;
+long DiskActive = EndOfList;		// Request the controller is serving
+long DiskDone = 0;			// Clock at which it completes
+long DiskTrack = 0;			// Track under the head
+long DiskDirection = 1;			// Sweep of the elevator, 1 or -1
+
+/*** MAPPED FILES ***/
+// Host file regions mapped by mmap into heap blocks. A store into the heap
+// marks its page dirty; the dirty pages of a mapping are written back when
+// it is unmapped.
+int MapFile[MAX_MAPPINGS];		// Host file descriptor, -1 for a free entry
+long MapOwner[MAX_MAPPINGS];		// PCB of the process
+long MapAddress[MAX_MAPPINGS], MapSize[MAX_MAPPINGS];
+long MapOffset[MAX_MAPPINGS];		// Offset of the region in the file
+unsigned char HeapDirty[SYSTEM_MEMORY_SIZE / PAGE_SIZE];	// By physical page
+
+/*** STATISTICS PAGE ***/
+// With -p the statistics are published in a POSIX shared memory object,
+// for tools/hypotop.c to show while the system runs. The simulator is the
+// only writer and never waits for a reader: Sequence is odd while the page
+// is being written, and a reader retries a copy during which it changed (a
+// seqlock). The main counters are written on every scheduling pass, the
+// rest every STATS_PERIOD of clock.
+// tools/hypotop.c declares the same structure, so STATS_VERSION changes
+// with it.
+struct StatsProcess {
+	long Pid;				// 0 for a free process slot
+	long State, Reason, Priority;
+};
+struct StatsPage {
+	unsigned long Sequence;
+	long Version;
+	long Running;				// 0 once the OS has shut down
+	long MachineWords, Processes;		// MAX_PROCESSES
+	long Clock, Instructions, ContextSwitches;
+	long ReadyCount, WaitCount;
+	long UserFreeWords, UserFreeBlocks;
+	long OSFreeWords, OSFreeBlocks;
+	long ProgramFreeWords, ProgramFreeBlocks;	// Segment model only
+	long SystemCalls;
+	long SystemCallsByID[MAX_SYSTEM_CALL + 1];
+	struct StatsProcess Process[MAX_PROCESSES];	// By process slot
+};
+struct StatsPage *Stats = NULL;		// NULL unless publishing
+char *StatsName = NULL;			// Shared memory object given to -p
+long StatsWalkClock = 0;		// Clock of the next walk
+
+/*** DECODE TABLE ***/
+// An instruction word has at most six decimal digits, so every first word
+// is decoded once by BuildDecodeTable and the CPU decodes with one load.
+// Words outside the table, negative or of seven digits, are invalid.
+#define DECODE_WORDS		1000000
+struct DecodedWord {
+	unsigned int Opcode : 7;	// 0-99, only 0 to LAST_OPCODE execute
+	unsigned int Op1Mode : 4, Op1GPR : 4;
+	unsigned int Op2Mode : 4, Op2GPR : 4;
+	unsigned int Length : 2;	// Words, with operand and branch address words
+	unsigned int Valid : 1;		// Passes the CPU Decode Validation
+	unsigned int Branch : 1;	// Last word is a branch address
+	unsigned int Next : 1;		// May go on to the next instruction
+};
+struct DecodedWord DecodeTable[DECODE_WORDS];
+
+/*** LOCKSTEP LANES ***/
+// Copies of one program run in step, a lane per line of the -n inputs file.
+// Lanes run LANE_GROUP at a time. The state of the running group is
+// lane-minor, so that each phase of an instruction is a loop over
+// consecutive words: word a of lane l is GroupMem[a * LANE_GROUP + l]. A lane
+// has the program at address 0 and its stack right after it.
+long LaneCount = 0;			// 0 unless sweeping
+long LaneWords = 0;			// Program and stack words of a lane
+long LaneStackBase = 0;
+long LaneEntry = 0;
+long *LaneImage;			// Program, then an empty stack
+long *LaneGPR;				// GPR r of lane l at [l * GPR_NUMBER + r]
+long *LanePC, *LaneClock, *LaneStatus;	// Final state of each lane
+long LaneSteps = 0;			// Instructions issued to a group
+
+long *GroupMem;
+long GroupGPR[GPR_NUMBER][LANE_GROUP];
+long GroupPC[LANE_GROUP], GroupSP[LANE_GROUP], GroupClock[LANE_GROUP];
+long GroupPSR[LANE_GROUP];		// Condition flags of each lane
+long GroupStatus[LANE_GROUP];		// OK while running, then the CPU status
+long GroupOp1[LANE_GROUP], GroupOp2[LANE_GROUP];	// Operands of the step
+long GroupAddr[2][LANE_GROUP];		// Addresses of the operands
+long GroupMask[LANE_GROUP];		// 1 for the lanes issuing the step
+int GroupCodeWritten;			// A lane stored below its stack
+
+/*** NATIVE CODE ***/
+// Simulator -t translates an object module to C, with a label per
+// instruction and gotos for branches. Built as a shared object beside the
+// module (program.txt.so), it runs the processes of that image under the
+// native engine. The generated file declares this structure too, so
+// NATIVE_INTERFACE changes with it.
+#define NATIVE_INTERFACE	2
+struct NativeMachine {
+	long *mem, *gpr, *sp, *pc, *clock;
+	long *codebase, *codelimit, *base, *limit, *stackbase, *stacklimit, *psr;
+	long TimeLeft;				// Slice left when the native code returns
+	long Executed;				// Instructions it ran
+	long (*SystemCall)(long SystemCallID);
+	long (*StoreMemory)(long addr, long value);
+};
+void *ImageNative[MAX_IMAGES];		// Native code of the cached image, or NULL
+long HandoverTime = 0;			// Slice left when CPU takes over from native code
+long NativeCount = 0;			// Instructions run by native code
+char *TranslateOutput = NULL;		// C file written by -t
+
+/*** LOAD-TIME VERIFIER ***/
+// Marks the words of instructions the verifier proved safe. The CPU runs a
+// marked instruction without decode validation or address checks; only
+// push and pop still test the stack bounds. A store into a marked word
+// drops the mark, so modified code is checked again.
+#define VERIFIED_INSTRUCTION	1	// First word of a proven instruction
+#define VERIFIED_OPERAND	2	// Operand or branch address word of one
+unsigned char VerifiedCode[SYSTEM_MEMORY_SIZE];
+int VerifierEnabled = 1;
+
+/*** IMAGE CACHE ***/
+// Object modules parsed by AbsoluteLoader, by path and modification time.
+// Under the segment model a slot also names the code and data segments
+// shared by the processes running the image, EndOfList when none is. A
+// shared segment is read-only: a store into it goes to a private copy.
+char ImagePath[MAX_IMAGES][MAX_FILENAME];
+long ImageTime[MAX_IMAGES], ImageBytes[MAX_IMAGES];
+long *ImageWords[MAX_IMAGES];		// NULL for an empty slot
+char *ImageRelocate[MAX_IMAGES];
+long ImageSize[MAX_IMAGES], ImageEntry[MAX_IMAGES];
+long ImageCodeSize[MAX_IMAGES];		// Words in the code segment
+long ImageCodeBase[MAX_IMAGES], ImageDataBase[MAX_IMAGES];
+long ImageVictim = 0;			// Next slot considered for reuse
+
+/*** SHARED SEGMENTS ***/
+// Segments mapped by more than one process: image segments and the program
+// of a forked process. An entry is free when it has no users.
+long SharedStart[MAX_SHARED_SEGMENTS], SharedSize[MAX_SHARED_SEGMENTS];
+long SharedUsers[MAX_SHARED_SEGMENTS];
+unsigned char SharedMemory[SYSTEM_MEMORY_SIZE];	// Word of a shared program segment
+
+//long EndOfList = -1; //indicates end of OSFreeList or UserFreeList
+
+long ProcessID = 1;
+
+const int Ready = 1;
+const int Running = 2;
+const int Waiting = 3;
+
+/*** PCB ***/
+const long PCBsize = 31;
+int NextPtr = 0;
+const int PCB_Pid = 1;
+const int PCB_State = 2;
+const int PCB_Reason = 3;
+const int PCB_Priority = 4;
+const int PCB_StackSize = 5;
+const int PCB_StackStartAddr = 6;
+const int PCB_Base = 7;
+const int PCB_Limit = 8;
+const int PCB_CodeAddr = 9;		// Heap block of a relocated flat-model program
+const int PCB_CodeSize = 10;
+const int PCB_GPR0 = 11;
+const int PCB_GPR1 = 12;
+const int PCB_GPR2 = 13;
+const int PCB_GPR3 = 14;
+const int PCB_GPR4 = 15;
+const int PCB_GPR5 = 16;
+const int PCB_GPR6 = 17;
+const int PCB_GPR7 = 18;
+const int PCB_SP = 19;
+const int PCB_PC = 20;
+const int PCB_PSR = 21;
+const int PCB_CodeBase = 22;		// Code segment, may be shared
+const int PCB_CodeLimit = 23;
+const int PCB_Parent = 24;		// PID of the forking process, 0 for none
+const int PCB_ExitStatus = 25;
+const int PCB_Mailbox = 26;		// Mailbox in OS memory, or EndOfList
+const int PCB_MessageClock = 27;	// Send time of a message handed over while blocked
+const int PCB_SleepTimer = 28;		// Timers, or EndOfList
+const int PCB_PeriodTimer = 29;
+const int PCB_TimerPending = 30;	// Periodic expiries not yet waited for
+
+/*** PROCESS TABLE ***/
+// The scheduler fields of every PCB, by process slot, so that queue walks
+// stay in a few host cache lines and follow one load per PCB. The words
+// at NextPtr, PCB_Pid, PCB_State, PCB_Reason and PCB_Priority are only
+// written by SyncPCB, when the PCB is dumped.
+long ProcPCB[MAX_PROCESSES];		// PCB in the slot, or EndOfList
+long ProcNext[MAX_PROCESSES];		// Slot of the next PCB in its queue, or of
+					// the next free slot
+long ProcPid[MAX_PROCESSES];
+long ProcState[MAX_PROCESSES];
+long ProcReason[MAX_PROCESSES];
+long ProcPriority[MAX_PROCESSES];
+void *ProcNative[MAX_PROCESSES];	// Native code of the program, or NULL
+long ProcFreeList = EndOfList;
+unsigned char ProcSlot[MAX_OS_MEMORY - MAX_HEAP_MEMORY];	// Slot by PCB address
+
+/*** MAILBOX ***/
+// Ring buffer of messages, allocated on the first message to a process
+const int MB_Head = 0;			// Slot of the oldest message
+const int MB_Count = 1;
+const int MB_Slots = 2;			// MAILBOX_SLOTS slots of MSG_SIZE words
+const int MSG_Sender = 0;
+const int MSG_Buffer = 1;		// Heap block handed to the receiver
+const int MSG_Size = 2;
+const int MSG_Clock = 3;		// Simulated clock when sent
+
+/*** FUNCTION PROTOTYPES ***/
+void InitializeSystem();
+int main(int argc, char *argv[]);
+int AbsoluteLoader(char* filename, long PCBptr);
+int ReadObjectModule(char* filename, long *Image, char *Relocate, long *size);
+int ReadObjectRecord(FILE *fp, int binary, int *addr, int *word);
+void BuildDecodeTable();
+long CPU();
+long BlockInstruction(long opcode);
+int BlockInRange(long Address, long Length);
+long BlockRun(long Address, long Length, long *Physical);
+long AtomicInstruction(long opcode, long addr, long value);
+static inline long CompareFlags(long Op1, long Op2);
+static inline int FlagsTaken(long opcode, long flags);
+long SystemCall(long SystemCallID);
+long FetchOperand(long OpMode, long OpReg, long *OpAddress, long *OpValue);
+void DumpMemory(char* String, long StartAddress, long size);
+long CreateProcess(char *filename, long priority);
+long AllocateOSMemory(long RequestedSize);
+long FreeOSMemory(long *ptr, long size);
+long AllocatePCB();
+long FreePCB(long *PCBptr);
+static inline long PCBSlot(long PCBptr);
+static inline long NextPCB(long PCBptr);
+static inline void SetNextPCB(long PCBptr, long NextPCBptr);
+void SyncPCB(long PCBptr);
+long AllocateUserMemory(long size);
+long FreeUserMemory(long ptr, long size);
+long AllocateProgramMemory(long RequestedSize);
+long FreeProgramMemory(long ptr, long size);
+long MemAllocSystemCall();
+long MemFreeSystemCall();
+void InitializePCB();
+void PrintPCB(long PCBptr);
+long PrintQueue(long Qptr);
+long InsertIntoRQ(long *PCBptr);
+long InsertIntoWQ(long *PCBptr);
+long SelectProcessFromRQ();
+void SaveContext(long PCBptr);
+void Dispatcher(long PCBptr);
+void RestoreContext(long PCBptr);
+void TerminateProcess(long PCBptr);
+void CheckAndProcessInterrupt();
+void ISRrunProgramInterrupt();
+void ISRinputCompletionInterrupt();
+void ISRoutputCompletionInterrupt();
+void ISRshutdownSystem();
+long IOGetCSystemCall();
+long IOPutCSystemCall();
+long TranslateBuffer(long Address, long Length, long *Physical);
+long IOReadSystemCall();
+long IOWriteSystemCall();
+long SearchAndRemovePCBfromWQ(long ProcessID);
+void RaiseBatchInterrupts();
+void CompleteInputOperation(long PCBptr);
+void CompleteOutputOperation(long PCBptr);
+long HostTimeNanoseconds();
+void PrintStatistics();
+long OpenStatistics(char *name);
+void PublishStatistics(int Walk);
+void CloseStatistics();
+long FreeListWords(long List, long *Blocks);
+static inline long Translate(long Address);
+long TranslatePage(long Address);
+long LoadPages(long *Image, long size, long *Base, long *Limit);
+void FreePages(long PageTable, long Limit);
+void ISRpageFaultInterrupt(long PCBptr);
+long SelectVictimFrame();
+void AgeFrames();
+void FlushTLB();
+void RestartInstruction();
+long VerifyProgram(long CodeBase, long CodeLimit, long Base, long Limit, long EntryPC);
+void UnverifyWord(long addr);
+long StoreMemory(long addr, long value);
+long WritableWord(long addr);
+long LookupImage(char *filename, long time, long bytes);
+long CacheImage(char *filename, long time, long bytes, long *Image, char *Relocate,
+		long size, long EntryPC);
+long CodeSegmentSize(long *Image, long size, long EntryPC);
+long MapImage(long slot, long *CodeBase, long *Base, int *fresh);
+long LoadSegment(long slot, long start, long size);
+long ShareSegment(long segment, long size, long users);
+long FindSharedSegment(long segment);
+void UnshareSegment(long entry);
+long CopyOnWrite(long addr);
+void ReleaseProgram(long PCBptr);
+void ReleaseSegment(long segment, long size);
+static inline long SegmentAddress(long Address, long CodeBase, long CodeLimit, long Base);
+long ExecuteVerified();
+long RunLanes(char *filename, char *inputs);
+long LoadLanes(char *filename, char *inputs);
+void LoadGroup(long first);
+void SaveGroup(long first);
+void StepLanes(long pc);
+long LaneOperand(long mode, long reg, long *next, long *Value, long *Addr);
+void StopLanes(long status);
+void PrintLanes();
+long NativeCPU();
+void *LoadNative(char *filename, long *Image, long size);
+long TranslateProgram(char *filename, char *output);
+void TranslateInstruction(FILE *out, long *Image, char *Start, long addr, long size, long split);
+int TranslateOperand(long addr, int n, long mode, long reg, long word, long size, long split,
+		char *check, char *value);
+long ProcessCreateSystemCall();
+long ProcessDeleteSystemCall();
+long ProcessInquirySystemCall();
+long ProcessExecSystemCall();
+long ForkProgram(long ParentPtr, long ChildPtr);
+long CopyPages(long PageTable, long Limit, long *Base);
+long FindPCB(long Qptr, long ProcessID);
+long FindChild(long Qptr, long ParentID, long ProcessID);
+long RemoveFromQueue(long *Qptr, long PCBptr);
+long MsgSendSystemCall();
+long MsgReceiveSystemCall();
+int WaitingForIO(long PCBptr);
+long TimeGetSystemCall();
+long TimeSetSystemCall();
+long SleepSystemCall();
+long TimerSetSystemCall();
+long TimerWaitSystemCall();
+long StartTimer(long PCBptr, long Deadline, long Period);
+void InsertTimer(long timer);
+void StopTimer(long timer);
+void AdvanceTimers();
+void ExpireTimer(long timer);
+void WakeTimerWaiter(long PCBptr, long Expiries);
+int TimerWaiters();
+void SkipIdleTime();
+long OpenDisk(char *filename);
+long DiskRequestSystemCall(int Write);
+void StartDiskRequest(long Now);
+void ISRdiskCompletionInterrupt();
+void CancelDiskRequests(long PCBptr);
+int DiskWaiters();
+long MmapSystemCall();
+long MunmapSystemCall();
+long UnmapFile(long entry);
+
+/*** EXECUTION ENGINES ***/
+// An engine runs the dispatched process for one time slice and returns the
+// CPU completion status: an event code, SIMULATOR_STATUS_HALTED or an error.
+struct ExecutionEngine {
+	char *Name;
+	long (*Run)();
+};
+
+struct ExecutionEngine Engines[] = {
+	{ "interp",	CPU },		// Reference fetch/decode/execute loop
+	{ "native",	NativeCPU },	// Code translated by -t, else interp
+};
+#define ENGINE_COUNT	(sizeof(Engines) / sizeof(Engines[0]))
+struct ExecutionEngine *Engine = &Engines[0];
+
+/*******************************************************************************
+ * Function: InitializeSystem
+ *
+ * Description: Resets all Global Vars (Hardware) to an initial value 0
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+void InitializeSystem()
+{
+	char filename[MAX_FILENAME];
+	strcpy(filename, "nullprocess.txt");
+
+	BuildDecodeTable();
+
+	/* Initialize Memory Array and then GPR Register Array */
+	for (int i = 0; i < SYSTEM_MEMORY_SIZE; i++)
+		mem[i] = 0;
+	for (int i = 0; i < GPR_NUMBER; i++)
+		gpr[i] = 0;
+
+	/* Assigns value `0` to Each Individual Hardware Variable */
+	mar = mbr = clock = ir = psr = pc = sp = 0;
+
+	// Create user free list using the free block address and size given in the class
+	// This part has errors. "Next user free block pointer", "second location in free block"
+	UserFreeList = MAX_USER_MEMORY + 1;
+	mem[UserFreeList] = EndOfList;
+	mem[UserFreeList + 1] = MAX_HEAP_MEMORY - MAX_USER_MEMORY;
+
+	// Create OS free list using the free block address and size given in the class
+	// This part has errors. "Next OS free block pointer", "second location in free block"
+	OSFreeList = MAX_HEAP_MEMORY + 1;
+	mem[OSFreeList] = EndOfList;
+	mem[OSFreeList + 1] = MAX_OS_MEMORY - MAX_HEAP_MEMORY;
+
+	// Program segments are carved out of the user region
+	if (MemoryModel == MMU_SEGMENT) {
+		ProgramFreeList = 0;
+		mem[ProgramFreeList] = EndOfList;
+		mem[ProgramFreeList + 1] = MAX_USER_MEMORY + 1;
+	}
+
+	// Every frame and backing store slot starts free
+	for (long i = 0; i < MAX_FRAMES; i++)
+		FrameOwner[i] = EndOfList;
+	for (long i = SWAP_PAGES - 1; i >= 0; i--) {
+		SwapNext[i] = SwapFreeList;
+		SwapFreeList = i;
+	}
+	FlushTLB();
+
+	// Every timer is free and the wheel empty
+	for (long i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++)
+		Wheel[i] = EndOfList;
+	for (long i = MAX_TIMERS - 1; i >= 0; i--) {
+		TimerNext[i] = TimerFreeList;
+		TimerFreeList = i;
+	}
+
+	// Every process slot is free
+	for (long i = MAX_PROCESSES - 1; i >= 0; i--) {
+		ProcPCB[i] = EndOfList;
+		ProcNext[i] = ProcFreeList;
+		ProcFreeList = i;
+	}
+
+	// Every mapping is free
+	for (long i = 0; i < MAX_MAPPINGS; i++)
+		MapFile[i] = -1;
+
+	// Every disk request is free
+	for (long i = MAX_DISK_REQUESTS - 1; i >= 0; i--) {
+		DiskNext[i] = DiskFreeList;
+		DiskFreeList = i;
+	}
+
+	// No image has shared segments yet
+	for (long i = 0; i < MAX_IMAGES; i++)
+		ImageCodeBase[i] = ImageDataBase[i] = EndOfList;
+
+	// Call Create Process function passing Null Process executing file and priority zero as arguments
+	if (CreateProcess(filename, 0) == OK)
+		NullProcessPtr = RQ;		// Only process in RQ at start up
+	return;
+}
+
+/*******************************************************************************
+ * Function:Main
+ *
+ * Description: Creates a process for every program named on the command line
+ * and runs the MTOPS scheduling loop until the system is shut down.
+ *
+ * Usage: simulator [-b] [-q] [-u] [-m model] [-r policy] [-f frames]
+ *                  [-e engine] [-l] [-d disk] [-s policy] [-n inputs]
+ *                  [-t output] [-p name] [program ...]
+ *      -b				Batch mode. Interrupts are raised by the
+ *      				simulator and the system shuts down once
+ *      				every user process has terminated
+ *      -q				Quiet. No queue, PCB or memory dumps
+ *      -u				Unverified. Every instruction takes the
+ *      				checked path of the CPU
+ *      -m model			Memory model. "segment" (default) loads
+ *      				every program into its own base/limit
+ *      				segment, "flat" loads all of them at
+ *      				their absolute addresses, "paged" pages
+ *      				them in on demand
+ *      -r policy			Page replacement, "clock" or "lru"
+ *      -f frames			Page frames in the user region
+ *      -e engine			Execution engine running the CPU
+ *      -l				List the execution engines and exit
+ *      -d disk				Host file holding the blocks of the
+ *      				disk, created when missing
+ *      -s policy			Disk scheduling, "fcfs" or "look"
+ *      -n inputs			Lockstep sweep. The first program runs
+ *      				once per line of inputs, without the OS
+ *      				(see RunLanes)
+ *      -t output			Translate the first program to C in
+ *      				output and exit (see TranslateProgram)
+ *      -p name				Publish the statistics in the POSIX
+ *      				shared memory object name, e.g. /hypo,
+ *      				for tools/hypotop (see PublishStatistics)
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      OK				-on successful execution
+ *      ErrorFileOpen			-Cannot Open File
+ *      ExecutionCompletionStatus	-Returns code returned by CPU
+ ******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	/* Local Variables */
+	char filename[MAX_FILENAME];
+	int ExecutionCompletionStatus = OK;
+	long PCBPtr;
+	int option;
+
+
+	// Read Simulator Run Options
+	while ((option = getopt(argc, argv, "bqum:r:f:e:ld:s:n:t:p:")) != -1) {
+		switch (option) {
+			case 'b':
+				InteractiveMode = 0;
+				break;
+			case 'q':
+				VerboseMode = 0;
+				break;
+			case 'u':
+				VerifierEnabled = 0;
+				break;
+			case 'm':
+				if (strcmp(optarg, "flat") == 0)
+					MemoryModel = MMU_FLAT;
+				else if (strcmp(optarg, "segment") == 0)
+					MemoryModel = MMU_SEGMENT;
+				else if (strcmp(optarg, "paged") == 0)
+					MemoryModel = MMU_PAGED;
+				else {
+					printf("ERROR: Unknown memory model %s\n", optarg);
+					return ErrorRuntime;
+				}
+				break;
+			case 'r':
+				if (strcmp(optarg, "clock") == 0)
+					ReplacementPolicy = PAGE_CLOCK;
+				else if (strcmp(optarg, "lru") == 0)
+					ReplacementPolicy = PAGE_LRU;
+				else {
+					printf("ERROR: Unknown replacement policy %s\n", optarg);
+					return ErrorRuntime;
+				}
+				break;
+			case 'f':
+				FrameCount = atol(optarg);
+				if (FrameCount < MIN_FRAMES || FrameCount > MAX_FRAMES) {
+					printf("ERROR: Frames must be %d to %d\n", MIN_FRAMES, MAX_FRAMES);
+					return ErrorRuntime;
+				}
+				break;
+			case 'e':
+				Engine = NULL;
+				for (size_t i = 0; i < ENGINE_COUNT; i++)
+					if (strcmp(Engines[i].Name, optarg) == 0)
+						Engine = &Engines[i];
+				if (Engine == NULL) {
+					printf("ERROR: Unknown execution engine %s\n", optarg);
+					return ErrorRuntime;
+				}
+				break;
+			case 'l':
+				for (size_t i = 0; i < ENGINE_COUNT; i++)
+					printf("%s\n", Engines[i].Name);
+				return 0;
+			case 'd':
+				if (OpenDisk(optarg) != OK)
+					return ErrorFileOpen;
+				break;
+			case 's':
+				if (strcmp(optarg, "fcfs") == 0)
+					DiskPolicy = DISK_FCFS;
+				else if (strcmp(optarg, "look") == 0)
+					DiskPolicy = DISK_LOOK;
+				else {
+					printf("ERROR: Unknown disk policy %s\n", optarg);
+					return ErrorRuntime;
+				}
+				break;
+			case 'n':
+				LaneInputs = optarg;
+				break;
+			case 't':
+				TranslateOutput = optarg;
+				break;
+			case 'p':
+				StatsName = optarg;
+				break;
+			default:
+				printf("Usage: %s [-b] [-q] [-u] [-m model] [-r policy] "
+						"[-f frames] [-e engine] [-l] [-d disk] [-s policy] "
+						"[-n inputs] [-t output] [-p name] [program ...]\n", argv[0]);
+				return ErrorRuntime;
+		}
+	}
+
+	// A lockstep sweep needs only the decode table
+	if (LaneInputs != NULL) {
+		if (optind >= argc) {
+			printf("ERROR: Lockstep sweep requires a program\n");
+			return ErrorFileOpen;
+		}
+		BuildDecodeTable();
+		return RunLanes(argv[optind], LaneInputs);
+	}
+
+	// So does a translation
+	if (TranslateOutput != NULL) {
+		if (optind >= argc) {
+			printf("ERROR: Translation requires a program\n");
+			return ErrorFileOpen;
+		}
+		BuildDecodeTable();
+		return TranslateProgram(argv[optind], TranslateOutput);
+	}
+
+	// Ready System
+	InitializeSystem();
+
+	//Prompt User to load Machine Code Program
+	if (optind >= argc) {
+		if (!InteractiveMode) {
+			printf("ERROR: Batch mode requires a program\n");
+			return ErrorFileOpen;
+		}
+		printf("Enter Machine Code Program Filename >>");
+		fgets(filename, MAX_FILENAME, stdin);		// fgets is buffer-safe
+		strtok(filename, "\n");
+		CreateProcess(filename, DEFAULT_PRIORITY);
+	}
+	else {
+		for (int i = optind; i < argc; i++)
+			if (CreateProcess(argv[i], DEFAULT_PRIORITY) != OK)
+				return ErrorFileOpen;
+	}
+
+	if (StatsName != NULL && OpenStatistics(StatsName) != OK)
+		return ErrorFileOpen;
+	HostStartTime = HostTimeNanoseconds();
+
+	while (SysShutdownStatus != 1){
+
+		// Publish what the last pass did
+		if (Stats != NULL)
+			PublishStatistics(0);
+
+		// Expire the timers and complete the disk requests that fell due
+		// while the last process ran
+		AdvanceTimers();
+		ISRdiskCompletionInterrupt();
+
+		// Check and process interrupt
+		if (InteractiveMode)
+			CheckAndProcessInterrupt();
+		else
+			RaiseBatchInterrupts();
+		if (SysShutdownStatus == 1)
+			break;
+
+		// Only the null process is ready: let the clock run to the next timer
+		// or disk completion
+		if ((RQ == EndOfList || RQ == NullProcessPtr) && (TimerWaiters() || DiskWaiters()))
+			SkipIdleTime();
+
+		// Dump RQ and WQ
+		if (VerboseMode) {
+			printf("RQ: Before CPU scheduling\n");
+			PrintQueue(RQ);
+			printf("WQ: Before CPU scheduling\n");
+			PrintQueue(WQ);
+			DumpMemory("Dynamic Memory Area before CPU scheduling", 0, 99);
+		}
+
+		// Select next process from RQ to give CPU
+		PCBPtr = SelectProcessFromRQ();
+		if (PCBPtr == EndOfList)
+			continue;		// Nothing to run until the next interrupt
+
+		// Perform restore context using Dispatcher
+		Dispatcher(PCBPtr);
+		ContextSwitchCount++;
+
+		// Dump RQ
+		if (VerboseMode) {
+			printf("RQ: After selecting process from RQ \n");
+			PrintQueue(RQ);
+		}
+
+		// Execute instructions of the running process using the CPU
+		ExecutionCompletionStatus = Engine->Run();
+		if (MemoryModel == MMU_PAGED)
+			AgeFrames();
+
+		// Dump dynamic memory area
+		if (VerboseMode)
+			DumpMemory("After executing program", MAX_USER_MEMORY, MAX_USER_MEMORY);
+
+		// Check return status
+		if (ExecutionCompletionStatus == TimeSliceExpired) {
+			// The registers stay in the CPU until another process is
+			// dispatched (see Dispatcher)
+			ContextPCB = PCBPtr;
+			InsertIntoRQ(&PCBPtr);
+			PCBPtr = EndOfList;
+		}
+		else if (ExecutionCompletionStatus == ErrorPageFault) {
+			RestartInstruction();
+			SaveContext(PCBPtr);
+			ISRpageFaultInterrupt(PCBPtr);
+			InsertIntoRQ(&PCBPtr);		// Retries the instruction when next dispatched
+			PCBPtr = EndOfList;
+		}
+		else if (ExecutionCompletionStatus == SIMULATOR_STATUS_HALTED || ExecutionCompletionStatus < 0) {
+			SaveContext(PCBPtr);		// Segments may have moved on a copy on write
+			if (ExecutionCompletionStatus < 0)
+				mem[PCBPtr + PCB_ExitStatus] = ExecutionCompletionStatus;
+			TerminateProcess(PCBPtr);
+			PCBPtr = EndOfList;
+		}
+		else if (ExecutionCompletionStatus == WaitForChild) {
+			SaveContext(PCBPtr);
+			ProcReason[PCBSlot(PCBPtr)] = ChildTermination;
+			InsertIntoWQ(&PCBPtr);
+			PCBPtr = EndOfList;
+		}
+		else if (ExecutionCompletionStatus == WaitForMessage) {
+			SaveContext(PCBPtr);
+			ProcReason[PCBSlot(PCBPtr)] = MessageArrival;
+			InsertIntoWQ(&PCBPtr);
+			PCBPtr = EndOfList;
+		}
+		else if (ExecutionCompletionStatus == WaitForTimer) {
+			SaveContext(PCBPtr);
+			ProcReason[PCBSlot(PCBPtr)] = TimerExpiry;
+			InsertIntoWQ(&PCBPtr);
+			PCBPtr = EndOfList;
+		}
+		else if (ExecutionCompletionStatus == StartOfInput) {
+			SaveContext(PCBPtr);
+			ProcReason[PCBSlot(PCBPtr)] = InputCompletion;
+			InsertIntoWQ(&PCBPtr);
+			PCBPtr = EndOfList;
+		}
+		else if (ExecutionCompletionStatus == StartOfOutput) {
+			SaveContext(PCBPtr);
+			ProcReason[PCBSlot(PCBPtr)] = OutputCompletion;
+			InsertIntoWQ(&PCBPtr);
+			PCBPtr = EndOfList;
+		}
+		else if (ExecutionCompletionStatus == StartOfBlockInput) {
+			SaveContext(PCBPtr);
+			ProcReason[PCBSlot(PCBPtr)] = BlockInputCompletion;
+			InsertIntoWQ(&PCBPtr);
+			PCBPtr = EndOfList;
+		}
+		else if (ExecutionCompletionStatus == StartOfBlockOutput) {
+			SaveContext(PCBPtr);
+			ProcReason[PCBSlot(PCBPtr)] = BlockOutputCompletion;
+			InsertIntoWQ(&PCBPtr);
+			PCBPtr = EndOfList;
+		}
+		else if (ExecutionCompletionStatus == StartOfDiskIO) {
+			SaveContext(PCBPtr);
+			ProcReason[PCBSlot(PCBPtr)] = DiskCompletion;
+			InsertIntoWQ(&PCBPtr);
+			PCBPtr = EndOfList;
+		}
+		else{
+			printf("Unknown programming error");
+		}
+	}
+
+	// Print OS is shutting down message
+	printf("OS shutting down\n");
+	if (Stats != NULL)
+		CloseStatistics();
+	PrintStatistics();
+	return(ExecutionCompletionStatus); // Terminate operating system
+
+	/* // From Homework 1
+	// Check for Negative Error Code
+	if (pc < 0) {
+	printf("FILE ERROR: %d\n", pc);
+	return pc;
+	}
+
+	//Dump Memory, Execute, and Dump Memory
+	DumpMemory("Program Loaded into System", 0, 99);
+	ExecutionCompletionStatus = CPU();
+	printf("Execution Status: %d\n", ExecutionCompletionStatus);
+	DumpMemory("Program Execution Stopped System", 0, 99);
+	return(ExecutionCompletionStatus);
+	*/
+
+}
+
+
+/*******************************************************************************
+ * Function: AbsoluteLoader
+ * Description: Loads a file that contains HYPO-machine code (user program)
+ * into the HYPO machine memory for the process whose PCB is given, and sets
+ * the segment fields of that PCB. The file is parsed once: later loads of the
+ * same file (same path and modification time) take the image from the image
+ * cache.
+ * The addresses in the file are relative to the program segment. Under the
+ * segment memory model the image is split into a code segment, the prefix
+ * holding the reachable instructions, and a data segment. Processes running
+ * the same image share both segments read-only; the first write to a shared
+ * segment gives the process a private copy of it (see CopyOnWrite). Under
+ * the flat model the program segment is the whole user region at 0. Under
+ * the paged model the program goes to the backing store, may reach
+ * MAX_VIRTUAL_MEMORY, and must leave the heap addresses free.
+ * A relocatable module lists every word that holds a program address (direct
+ * operands, branch targets, label constants) in "-2 address" records. Under
+ * the flat model such a module is placed in a block from AllocateUserMemory()
+ * and those words and the PC are patched by the block address, so many
+ * programs can be resident at once. The segment and paged models relocate in
+ * the MMU and ignore the records.
+ * Code that is loaded is checked by VerifyProgram when the verifier is on.
+ * On a successful file load the function returns the value in the `End of
+ * Program` line (Indicates PC Value).
+ * On failure to load then the function displays the appropriate error message
+ * and returns the appropriate error code.
+ *
+ *
+ * Input Parameters
+ *      filename			-Name of the Machine Code File
+ *      PCBptr				-PCB of the process being created
+ *
+ * Output Parameters
+ *      mem[PCBptr + PCB_Base]		Data segment, relocated so that address
+ *      				PCB_CodeLimit maps to its first word
+ *      				(page table when paged)
+ *      mem[PCBptr + PCB_Limit]		Size of the program
+ *      mem[PCBptr + PCB_CodeBase]	Physical start of the code segment
+ *      mem[PCBptr + PCB_CodeLimit]	Size of the code segment
+ *      mem[PCBptr + PCB_CodeAddr]	Heap block of a relocated program, or
+ *      				EndOfList
+ *      mem[PCBptr + PCB_CodeSize]	Size of that block
+ *
+ * Function Return Value
+ *      ErrorFileOpen			-Unable to open the file
+ *      ErrorInvalidAddress		-Invalid address error
+ *      ErrorNoEndOfProgram		-Missing end of program indicator
+ *      ErrorInvalidPCValue		-Invalid PC value
+ *      ErrorNoFreeMemory		-No room for the program segment
+ *      0 to Valid address range	-Successful Load, valid PC value
+ ******************************************************************************/
+
+int AbsoluteLoader(char* filename, long PCBptr)
+{
+	static long Image[MAX_VIRTUAL_MEMORY + 1];
+	static char Relocate[MAX_VIRTUAL_MEMORY + 1];
+	long *words = Image;
+	char *relocate = Relocate;
+	long size, EntryPC, Base, Limit, CodeBase, CodeLimit;
+	int fresh = 1;		// Code words were just stored and need verifying
+	struct stat info;
+
+	if (stat(filename, &info) != 0) {
+		printf("ERROR: Unable to open file.\n");
+		return ErrorFileOpen;
+	}
+
+	// Parse the module unless the image cache has it
+	long slot = LookupImage(filename, info.st_mtime, info.st_size);
+	if (slot == EndOfList) {
+		ImageMisses++;
+		EntryPC = ReadObjectModule(filename, Image, Relocate, &size);
+		if (EntryPC < 0)
+			return EntryPC;
+		slot = CacheImage(filename, info.st_mtime, info.st_size, Image, Relocate,
+				size, EntryPC);
+	}
+	else
+		ImageHits++;
+	if (slot != EndOfList) {
+		words = ImageWords[slot];
+		relocate = ImageRelocate[slot];
+		size = ImageSize[slot];
+		EntryPC = ImageEntry[slot];
+	}
+
+	mem[PCBptr + PCB_CodeAddr] = EndOfList;
+	mem[PCBptr + PCB_CodeSize] = 0;
+
+	if (MemoryModel == MMU_PAGED) {
+		if (LoadPages(words, size, &Base, &Limit) != OK)
+			return ErrorNoFreeMemory;
+		CodeBase = Base;
+		CodeLimit = Limit;
+		fresh = 0;		// Pages have no fixed frame
+	}
+	else if (MemoryModel == MMU_FLAT) {
+		long relocatable = 0;
+		for (long i = 0; i < size && !relocatable; i++)
+			relocatable = relocate[i];
+		CodeBase = Base = 0;
+		CodeLimit = Limit = MAX_USER_MEMORY + 1;
+
+		// Relocate into the heap when every process shares address 0
+		if (relocatable) {
+			long block = AllocateUserMemory(size);
+			if (block < 0)
+				return ErrorNoFreeMemory;
+			for (long i = 0; i < size; i++)
+				StoreMemory(block + i, relocate[i] ? words[i] + block : words[i]);
+			mem[PCBptr + PCB_CodeAddr] = block;
+			mem[PCBptr + PCB_CodeSize] = size < 2 ? 2 : size;	// AllocateUserMemory minimum
+			EntryPC += block;
+			if (VerifierEnabled)	// Absolute heap addresses
+				VerifyProgram(0, 0, 0, block + size, EntryPC);
+			fresh = 0;
+		}
+		else
+			for (long i = 0; i < size; i++)
+				StoreMemory(i, words[i]);
+	}
+	else if (slot != EndOfList) {
+		if (MapImage(slot, &CodeBase, &Base, &fresh) != OK)
+			return ErrorNoFreeMemory;
+		CodeLimit = ImageCodeSize[slot];
+		Limit = size;
+	}
+	else {
+		// Image cache full: a private segment
+		CodeBase = Base = AllocateProgramMemory(size);
+		CodeLimit = Limit = size;
+		if (Base < 0)
+			return ErrorNoFreeMemory;
+		for (long i = 0; i < size; i++)
+			StoreMemory(Base + i, words[i]);
+	}
+
+	mem[PCBptr + PCB_Base] = Base;
+	mem[PCBptr + PCB_Limit] = Limit;
+	mem[PCBptr + PCB_CodeBase] = CodeBase;
+	mem[PCBptr + PCB_CodeLimit] = CodeLimit;
+	if (VerifierEnabled && fresh)
+		VerifyProgram(CodeBase, CodeLimit, Base, Limit, EntryPC);
+	ProcNative[PCBSlot(PCBptr)] = MemoryModel == MMU_SEGMENT && slot != EndOfList ?
+		ImageNative[slot] : NULL;
+	return EntryPC;
+}
+
+/*******************************************************************************
+ * Function: ReadObjectModule
+ * Description: Parses a text object module or a binary image into a program
+ * image.
+ *
+ * Input Parameters
+ *      filename			-Name of the Machine Code File
+ *
+ * Output Parameters
+ *      Image				Words by program address, gaps zeroed
+ *      Relocate			Non-zero for words named by "-2" records
+ *      size				Highest address + 1
+ *
+ * Function Return Value
+ *      ErrorFileOpen			-Unable to open the file
+ *      ErrorInvalidAddress		-Invalid address error
+ *      ErrorNoEndOfProgram		-Missing end of program indicator
+ *      ErrorInvalidPCValue		-Invalid PC value
+ *      0 to Valid address range	-Valid PC value
+ ******************************************************************************/
+
+int ReadObjectModule(char* filename, long *Image, char *Relocate, long *size)
+{
+	long MaxAddress = MemoryModel == MMU_PAGED ? MAX_VIRTUAL_MEMORY : MAX_USER_MEMORY;
+
+	FILE *fp;
+	fp = fopen(filename, "r"); //open file in READ mode
+	if (fp == NULL) {
+		printf("ERROR: Unable to open file.\n");
+		return ErrorFileOpen;
+	}
+
+	// Binary images start with IMAGE_MAGIC, text modules with a number
+	char magic[4];
+	int binary = fread(magic, 1, 4, fp) == 4 && memcmp(magic, IMAGE_MAGIC, 4) == 0;
+	if (!binary)
+		rewind(fp);
+
+	// Parse File
+	int addr, word;
+	memset(Image, 0, (MAX_VIRTUAL_MEMORY + 1) * sizeof(long));
+	memset(Relocate, 0, MAX_VIRTUAL_MEMORY + 1);
+	*size = 0;
+	while (ReadObjectRecord(fp, binary, &addr, &word)) {
+		// If Address indicates EOP, Word is PC Value
+		if (addr == SCRIPT_INDICATOR_END) {
+			fclose(fp);
+			if (word < 0 || word >= *size) {
+				printf("ERROR: PC value Invalid\n");    //Error
+				return ErrorInvalidPCValue;
+			}
+			return word;                    //Success
+		}
+		else if (addr == SCRIPT_INDICATOR_RELOCATE) {
+			if (word < 0 || word > MaxAddress) {
+				fclose(fp);
+				printf("ERROR: Relocation Address in Invalid Range\n");
+				return ErrorInvalidAddress;
+			}
+			Relocate[word] = 1;
+		}
+		else if (addr >= 0 && addr <= MaxAddress && (MemoryModel != MMU_PAGED ||
+					addr <= MAX_USER_MEMORY || addr > MAX_HEAP_MEMORY)) {
+			Image[addr] = word;
+			if (addr >= *size)
+				*size = addr + 1;
+		}
+		else {
+			fclose(fp);
+			printf("ERROR: Address Location in Invalid Range\n");
+			return ErrorInvalidAddress;
+		}
+	}
+	fclose(fp);
+	printf("ERROR: No End of Program Indicator\n");         //Error
+	return ErrorNoEndOfProgram;
+}
+
+/*******************************************************************************
+ * Function: ReadObjectRecord
+ * Description: Reads the next (address, word) pair of an object module.
+ * Binary records are two 32-bit integers in host byte order.
+ *
+ * Input Parameters
+ *      fp				Open object module
+ *      binary				Non-zero for a binary image
+ *
+ * Output Parameters
+ *      addr				Address field
+ *      word				Word field
+ *
+ * Function Return Value
+ *      1				-Record read
+ *      0				-End of file or malformed record
+ ******************************************************************************/
+
+int ReadObjectRecord(FILE *fp, int binary, int *addr, int *word)
+{
+	int32_t record[2];
+
+	if (!binary)
+		return fscanf(fp, "%d %d", addr, word) == 2;
+
+	if (fread(record, sizeof(record), 1, fp) != 1)
+		return 0;
+	*addr = record[0];
+	*word = record[1];
+	return 1;
+}
+
+/*******************************************************************************
+ * Function: LookupImage
+ *
+ * Description: Finds a parsed object module in the image cache.
+ *
+ * Input Parameters
+ *      filename			Path the program was loaded from
+ *      time				Modification time of the file
+ *      bytes				Size of the file
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Image cache slot
+ *      EndOfList			-Not cached, or the file has changed
+ ******************************************************************************/
+
+long LookupImage(char *filename, long time, long bytes)
+{
+	for (long slot = 0; slot < MAX_IMAGES; slot++)
+		if (ImageWords[slot] != NULL && ImageTime[slot] == time &&
+				ImageBytes[slot] == bytes && strcmp(ImagePath[slot], filename) == 0)
+			return slot;
+	return EndOfList;
+}
+
+/*******************************************************************************
+ * Function: CacheImage
+ *
+ * Description: Keeps a copy of a parsed object module in the image cache.
+ * An empty slot is used first, then one holding an older version of the
+ * same file, then any slot whose segments no process is sharing.
+ *
+ * Input Parameters
+ *      filename			Path the program was loaded from
+ *      time				Modification time of the file
+ *      bytes				Size of the file
+ *      Image				Words by program address
+ *      Relocate			Relocation marks
+ *      size				Words in the image
+ *      EntryPC				Address of the first instruction
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Image cache slot
+ *      EndOfList			-Every slot is in use, or out of host memory
+ ******************************************************************************/
+
+long CacheImage(char *filename, long time, long bytes, long *Image, char *Relocate,
+		long size, long EntryPC)
+{
+	long slot = EndOfList;
+
+	for (long i = 0; i < MAX_IMAGES && slot == EndOfList; i++)
+		if (ImageWords[i] == NULL)
+			slot = i;
+	for (long i = 0; i < MAX_IMAGES && slot == EndOfList; i++)
+		if (ImageCodeBase[i] == EndOfList && ImageDataBase[i] == EndOfList &&
+				strcmp(ImagePath[i], filename) == 0)
+			slot = i;
+	for (long i = 0; i < MAX_IMAGES && slot == EndOfList; i++) {
+		long victim = (ImageVictim + i) % MAX_IMAGES;
+		if (ImageCodeBase[victim] == EndOfList && ImageDataBase[victim] == EndOfList)
+			slot = victim;
+	}
+	if (slot == EndOfList)
+		return EndOfList;
+	ImageVictim = (slot + 1) % MAX_IMAGES;
+
+	free(ImageWords[slot]);
+	free(ImageRelocate[slot]);
+	ImageWords[slot] = malloc(size * sizeof(long));
+	ImageRelocate[slot] = malloc(size);
+	if (ImageWords[slot] == NULL || ImageRelocate[slot] == NULL) {
+		free(ImageWords[slot]);
+		free(ImageRelocate[slot]);
+		ImageWords[slot] = NULL;
+		ImageRelocate[slot] = NULL;
+		return EndOfList;
+	}
+	memcpy(ImageWords[slot], Image, size * sizeof(long));
+	memcpy(ImageRelocate[slot], Relocate, size);
+
+	snprintf(ImagePath[slot], MAX_FILENAME, "%s", filename);
+	ImageTime[slot] = time;
+	ImageBytes[slot] = bytes;
+	ImageSize[slot] = size;
+	ImageEntry[slot] = EntryPC;
+	ImageCodeSize[slot] = CodeSegmentSize(Image, size, EntryPC);
+	ImageNative[slot] = Engine->Run == NativeCPU && MemoryModel == MMU_SEGMENT ?
+		LoadNative(filename, Image, size) : NULL;
+	return slot;
+}
+
+/*******************************************************************************
+ * Function: CodeSegmentSize
+ *
+ * Description: Follows the instructions reachable from the entry point and
+ * returns the length of the prefix of the image they cover without a gap.
+ * That prefix is the code segment; the rest of the image is data. An image
+ * that does not start with code is kept as one segment.
+ *
+ * Input Parameters
+ *      Image				Words by program address
+ *      size				Words in the image
+ *      EntryPC				Address of the first instruction
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Words in the code segment, 1 to size
+ ******************************************************************************/
+
+long CodeSegmentSize(long *Image, long size, long EntryPC)
+{
+	static long Pending[2 * (MAX_VIRTUAL_MEMORY + 1) + 1];	// Two successors per visit
+	static char Code[MAX_VIRTUAL_MEMORY + 1];
+	long top = 0, split = 0;
+
+	memset(Code, 0, size);
+	Pending[top++] = EntryPC;
+	while (top > 0) {
+		long addr = Pending[--top];
+		if (addr < 0 || addr >= size || Code[addr])
+			continue;
+
+		// Same instruction lengths as VerifyProgram
+		long word = Image[addr];
+		if (word < 0 || word >= DECODE_WORDS || DecodeTable[word].Opcode > LAST_OPCODE)
+			continue;
+		long next = addr + DecodeTable[word].Length;
+		if (DecodeTable[word].Branch && next - 1 < size)
+			Pending[top++] = Image[next - 1];
+		for (long i = addr; i < next && i < size; i++)
+			Code[i] = 1;
+		if (DecodeTable[word].Next)
+			Pending[top++] = next;
+	}
+
+	while (split < size && Code[split])
+		split++;
+	return split == 0 ? size : split;
+}
+
+/*******************************************************************************
+ * Function: MapImage
+ *
+ * Description: Gives a process the shared code and data segments of a
+ * cached image, storing them in the user region when no process has them.
+ *
+ * Input Parameters
+ *      slot				Image cache slot
+ *
+ * Output Parameters
+ *      CodeBase			Physical start of the code segment
+ *      Base				Data segment, relocated by the code size
+ *      fresh				Non-zero when the code was just stored
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorNoFreeMemory
+ ******************************************************************************/
+
+long MapImage(long slot, long *CodeBase, long *Base, int *fresh)
+{
+	long split = ImageCodeSize[slot], size = ImageSize[slot];
+	long code = ImageCodeBase[slot], data = ImageDataBase[slot];
+
+	if (code == EndOfList && (code = LoadSegment(slot, 0, split)) < 0)
+		return ErrorNoFreeMemory;
+	if (split < size && data == EndOfList &&
+			(data = LoadSegment(slot, split, size - split)) < 0) {
+		if (ImageCodeBase[slot] == EndOfList)
+			FreeProgramMemory(code, split);
+		return ErrorNoFreeMemory;
+	}
+
+	// The slot keeps the segments for the next process while they are shared
+	*fresh = ImageCodeBase[slot] == EndOfList;
+	if (ShareSegment(code, split, 1) != OK ||
+			(split < size && ShareSegment(data, size - split, 1) != OK)) {
+		ReleaseSegment(code, split);
+		if (split < size && ImageDataBase[slot] == EndOfList)
+			FreeProgramMemory(data, size - split);
+		return ErrorNoFreeMemory;
+	}
+	ImageCodeBase[slot] = code;
+	*CodeBase = code;
+	*Base = code;
+	if (split < size) {
+		ImageDataBase[slot] = data;
+		*Base = data - split;
+	}
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: LoadSegment
+ *
+ * Description: Stores part of a cached image in a new program segment.
+ *
+ * Input Parameters
+ *      slot				Image cache slot
+ *      start				First program address of the segment
+ *      size				Words in the segment
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Address of the segment
+ *      ErrorNoFreeMemory
+ ******************************************************************************/
+
+long LoadSegment(long slot, long start, long size)
+{
+	long segment = AllocateProgramMemory(size);
+	if (segment < 0)
+		return ErrorNoFreeMemory;
+	for (long i = 0; i < size; i++)
+		StoreMemory(segment + i, ImageWords[slot][start + i]);
+	return segment;
+}
+
+/*******************************************************************************
+ * Function: ShareSegment
+ *
+ * Description: Adds users to a shared segment, entering it in the shared
+ * segment table when it has none yet. Words of a shared program segment
+ * are marked in SharedMemory, so that writes to them are copied; heap
+ * blocks are shared writable, as the flat model has no protection.
+ *
+ * Input Parameters
+ *      segment				Physical start of the segment
+ *      size				Words in the segment
+ *      users				Users to add
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorNoFreeMemory		-Shared segment table full
+ ******************************************************************************/
+
+long ShareSegment(long segment, long size, long users)
+{
+	long entry = FindSharedSegment(segment);
+
+	if (entry == EndOfList) {
+		for (entry = 0; entry < MAX_SHARED_SEGMENTS; entry++)
+			if (SharedUsers[entry] == 0)
+				break;
+		if (entry == MAX_SHARED_SEGMENTS) {
+			printf("ERROR: Shared segment table full\n");
+			return ErrorNoFreeMemory;
+		}
+		SharedStart[entry] = segment;
+		SharedSize[entry] = size;
+		if (segment <= MAX_USER_MEMORY)
+			memset(&SharedMemory[segment], 1, size);
+	}
+	SharedUsers[entry] += users;
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: FindSharedSegment
+ *
+ * Description: Looks a segment up in the shared segment table.
+ *
+ * Input Parameters
+ *      segment				Physical start of the segment
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Table entry
+ *      EndOfList			-Segment is private
+ ******************************************************************************/
+
+long FindSharedSegment(long segment)
+{
+	for (long entry = 0; entry < MAX_SHARED_SEGMENTS; entry++)
+		if (SharedUsers[entry] > 0 && SharedStart[entry] == segment)
+			return entry;
+	return EndOfList;
+}
+
+/*******************************************************************************
+ * Function: UnshareSegment
+ *
+ * Description: Removes a segment from the shared segment table and from the
+ * image cache. Its last user keeps it as a private segment.
+ *
+ * Input Parameters
+ *      entry				Shared segment table entry
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void UnshareSegment(long entry)
+{
+	long segment = SharedStart[entry];
+
+	if (segment <= MAX_USER_MEMORY)
+		memset(&SharedMemory[segment], 0, SharedSize[entry]);
+	for (long slot = 0; slot < MAX_IMAGES; slot++) {
+		if (ImageCodeBase[slot] == segment)
+			ImageCodeBase[slot] = EndOfList;
+		if (ImageDataBase[slot] == segment)
+			ImageDataBase[slot] = EndOfList;
+	}
+	SharedUsers[entry] = 0;
+}
+
+/*******************************************************************************
+ * Function: CopyOnWrite
+ *
+ * Description: Called by StoreMemory for a write to a shared segment of the
+ * running process. The process gets a private copy of the segment, or
+ * simply takes it over when no other process shares it, and the code or
+ * data base is moved to it. Verifier marks are copied with the words. Native
+ * code no longer matches a code segment that is written, so the process
+ * drops it.
+ *
+ * Input Parameters
+ *      addr				Physical address being written
+ *
+ * Output Parameters
+ *      codebase, base			Moved to the private copy
+ *      ProcNative			NULL for the running process on a code write
+ *
+ * Function Return Value
+ *      Physical address of the word in the private copy
+ *      ErrorNoFreeMemory
+ ******************************************************************************/
+
+long CopyOnWrite(long addr)
+{
+	int code = addr >= codebase && addr < codebase + codelimit;
+	long start = code ? codebase : base + codelimit;
+	long size = code ? codelimit : limit - codelimit;
+	long entry = FindSharedSegment(start);
+	long copy = start;
+
+	if (entry != EndOfList && SharedUsers[entry] > 1) {
+		copy = AllocateProgramMemory(size);
+		if (copy < 0)
+			return ErrorNoFreeMemory;
+		memcpy(&mem[copy], &mem[start], size * sizeof(long));
+		memcpy(&VerifiedCode[copy], &VerifiedCode[start], size);
+		SharedUsers[entry]--;
+		CopiesOnWrite++;
+	}
+	else if (entry != EndOfList)
+		UnshareSegment(entry);		// Last user keeps it
+
+	if (code) {
+		codebase = copy;
+		ProcNative[PCBSlot(RunningPCB)] = NULL;
+	}
+	else
+		base = copy - codelimit;
+	return copy + addr - start;
+}
+
+/*******************************************************************************
+ * Function: ReleaseProgram
+ *
+ * Description: Returns the memory holding the program of a process.
+ *
+ * Input Parameters
+ *      PCBptr				PCB of the process
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void ReleaseProgram(long PCBptr)
+{
+	long Base = mem[PCBptr + PCB_Base], Limit = mem[PCBptr + PCB_Limit];
+	long CodeBase = mem[PCBptr + PCB_CodeBase], CodeLimit = mem[PCBptr + PCB_CodeLimit];
+
+	if (MemoryModel == MMU_PAGED)
+		FreePages(Base, Limit);
+	else if (MemoryModel == MMU_SEGMENT) {
+		ReleaseSegment(CodeBase, CodeLimit);
+		if (CodeLimit < Limit)
+			ReleaseSegment(Base + CodeLimit, Limit - CodeLimit);
+	}
+	if (mem[PCBptr + PCB_CodeSize] > 0)
+		ReleaseSegment(mem[PCBptr + PCB_CodeAddr], mem[PCBptr + PCB_CodeSize]);
+}
+
+/*******************************************************************************
+ * Function: ReleaseSegment
+ *
+ * Description: Drops one user of a shared segment, freeing it with the last
+ * one, or frees a private segment. Program segments go back to
+ * ProgramFreeList, heap blocks to UserFreeList.
+ *
+ * Input Parameters
+ *      segment				Physical start of the segment
+ *      size				Words in the segment
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void ReleaseSegment(long segment, long size)
+{
+	long entry = FindSharedSegment(segment);
+
+	if (entry != EndOfList) {
+		if (--SharedUsers[entry] > 0)
+			return;
+		UnshareSegment(entry);
+	}
+	if (segment <= MAX_USER_MEMORY)
+		FreeProgramMemory(segment, size);
+	else
+		FreeUserMemory(segment, size);
+}
+
+/*******************************************************************************
+ * Function: Translate
+ *
+ * Description: Memory-protection unit. Maps an address used by the running
+ * process to a physical address. The program, 0 to limit - 1, is relocated
+ * by SegmentAddress, or paged by TranslatePage. The heap is shared by every
+ * process at its physical addresses, since stacks and mem_alloc blocks are
+ * handed out from there.
+ *
+ * Input Parameters
+ *      Address				Address used by the program
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      ErrorInvalidAddress		-Outside every segment
+ *      ErrorPageFault			-Page not resident
+ *      Physical address
+ ******************************************************************************/
+
+static inline long Translate(long Address)
+{
+	if (Address >= 0 && Address < limit)
+		return MemoryModel == MMU_PAGED ? TranslatePage(Address) :
+			SegmentAddress(Address, codebase, codelimit, base);
+	if (Address > MAX_USER_MEMORY && Address <= MAX_HEAP_MEMORY)
+		return Address;
+	return ErrorInvalidAddress;
+}
+
+/*******************************************************************************
+ * Function: SegmentAddress
+ *
+ * Description: Relocates a program address by the code segment below the
+ * code limit and by the data segment from there on. A program kept in one
+ * segment has the same code and data base.
+ *
+ * Input Parameters
+ *      Address				Program address, 0 to limit - 1
+ *      CodeBase			Physical start of the code segment
+ *      CodeLimit			Size of the code segment
+ *      Base				Data segment, relocated by CodeLimit
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Physical address
+ ******************************************************************************/
+
+static inline long SegmentAddress(long Address, long CodeBase, long CodeLimit, long Base)
+{
+	return (Address < CodeLimit ? CodeBase : Base) + Address;
+}
+
+/*******************************************************************************
+ * Function: VerifyProgram
+ *
+ * Description: Decodes every instruction reachable from the entry point,
+ * following both sides of conditional branches, and marks in VerifiedCode
+ * the ones that are safe without run-time checks: valid opcode, modes and
+ * GPRs, every word, direct address and branch target inside the program
+ * segment, and only register, direct and immediate operands. Halt,
+ * SystemCall, the block and atomic instructions and Divide by anything
+ * but a non-zero immediate stay on the checked path. When the code and
+ * data segments are apart, only instructions wholly inside the code
+ * segment are marked, since the fast path fetches instruction words
+ * through the code base.
+ *
+ * Input Parameters
+ *      CodeBase			Physical start of the code segment
+ *      CodeLimit			Size of the code segment
+ *      Base				Data segment (see SegmentAddress)
+ *      Limit				Size of the program
+ *      EntryPC				Address of the first instruction
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Number of instructions marked verified
+ ******************************************************************************/
+
+long VerifyProgram(long CodeBase, long CodeLimit, long Base, long Limit, long EntryPC)
+{
+	static long Pending[2 * SYSTEM_MEMORY_SIZE + 1];	// Two successors per visit
+	static unsigned char Visited[SYSTEM_MEMORY_SIZE];
+	long count = 0, reachable = 0, invalid = 0, top = 0;
+	long CodeEnd = CodeBase == Base ? Limit : CodeLimit;	// Instructions marked below
+
+	memset(Visited, 0, sizeof(Visited));
+	Pending[top++] = EntryPC;
+
+	while (top > 0) {
+		long addr = Pending[--top];
+		if (addr < 0 || addr >= Limit || Visited[addr])
+			continue;			// The CPU reports it if reached
+		Visited[addr] = 1;
+		reachable++;
+
+		long word = mem[SegmentAddress(addr, CodeBase, CodeLimit, Base)];
+		if (word < 0 || word >= DECODE_WORDS || !DecodeTable[word].Valid ||
+				DecodeTable[word].Opcode > LAST_OPCODE) {
+			invalid++;
+			continue;
+		}
+		long opcode = DecodeTable[word].Opcode;
+		long mode[2] = { DecodeTable[word].Op1Mode, DecodeTable[word].Op2Mode };
+
+		// Operand words follow the instruction, then the branch address.
+		// Branch, Call and the flag branches have no operand and the
+		// conditional branches only Op1, the address word is read by the
+		// CPU whatever the mode says.
+		int safe = opcode != 0 && opcode != 12 && (opcode < 13 || opcode > 15) && opcode < 25;
+		int operands = (opcode >= 1 && opcode <= 5) || opcode == 18 || opcode == 25 ||
+			opcode == 26 ? 2 : opcode == 6 || (opcode > 12 && opcode < 25) ? 0 : 1;
+		long next = addr + 1;
+		for (int i = 0; i < operands; i++) {
+			if (mode[i] == 5 || mode[i] == 6) {
+				if (next >= Limit) {
+					safe = 0;
+					break;
+				}
+				long address = mem[SegmentAddress(next, CodeBase, CodeLimit, Base)];
+				if (mode[i] == 5 && (address < 0 || address >= Limit))
+					safe = 0;
+				next++;
+			}
+			else if (mode[i] != 0 && mode[i] != 1)
+				safe = 0;
+		}
+
+		// Operands each opcode needs; Op1 of arithmetic and Move is written
+		if (opcode >= 1 && opcode <= 5)
+			safe = safe && mode[0] != 0 && mode[0] != 6 && mode[1] != 0;
+		else if (opcode >= 7 && opcode <= 10)
+			safe = safe && mode[0] != 0;
+		else if (opcode == 11)
+			safe = safe && mode[0] != 6;	// Pop without Op1 discards
+		else if (opcode == 18)
+			safe = safe && mode[0] != 0 && mode[1] != 0;
+		if (opcode == 4)
+			safe = safe && mode[1] == 6 && mem[SegmentAddress(next - 1, CodeBase, CodeLimit, Base)] != 0;
+
+		if (DecodeTable[word].Branch) {
+			if (next >= Limit) {
+				invalid++;
+				continue;
+			}
+			long target = mem[SegmentAddress(next++, CodeBase, CodeLimit, Base)];
+			if (target < 0 || target >= Limit)
+				safe = 0;
+			Pending[top++] = target;
+		}
+		if (DecodeTable[word].Next && next < Limit)
+			Pending[top++] = next;
+
+		if (safe && next <= CodeEnd) {
+			VerifiedCode[SegmentAddress(addr, CodeBase, CodeLimit, Base)] = VERIFIED_INSTRUCTION;
+			for (long i = addr + 1; i < next; i++)
+				VerifiedCode[SegmentAddress(i, CodeBase, CodeLimit, Base)] = VERIFIED_OPERAND;
+			count++;
+		}
+	}
+
+	if (VerboseMode)
+		printf("Verifier: %ld of %ld reachable instructions proven safe, "
+				"%ld invalid\n", count, reachable, invalid);
+	return count;
+}
+
+/*******************************************************************************
+ * Function: UnverifyWord
+ *
+ * Description: Drops the verifier mark of the instruction a word belongs to.
+ *
+ * Input Parameters
+ *      addr				Address of a marked word
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void UnverifyWord(long addr)
+{
+	long start = addr;
+
+	while (start > 0 && VerifiedCode[start] == VERIFIED_OPERAND)
+		start--;
+	if (VerifiedCode[start] == VERIFIED_INSTRUCTION)
+		VerifiedCode[start++] = 0;
+	while (start < SYSTEM_MEMORY_SIZE && (start <= addr ||
+				VerifiedCode[start] == VERIFIED_OPERAND))
+		VerifiedCode[start++] = 0;
+}
+
+/*******************************************************************************
+ * Function: StoreMemory
+ *
+ * Description: Writes a word on behalf of the running program or loader.
+ * A write to a shared segment goes to the process's private copy of it,
+ * overwriting verified code sends it back to the checked path, and a write
+ * to a page frame marks it dirty.
+ *
+ * Input Parameters
+ *      addr				Address already checked by the caller
+ *      value				Word to store
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorNoFreeMemory		-No room for a copy of a shared segment
+ ******************************************************************************/
+
+long StoreMemory(long addr, long value)
+{
+	addr = WritableWord(addr);
+	if (addr < 0)
+		return addr;
+	mem[addr] = value;
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: WritableWord
+ *
+ * Description: Does the work of StoreMemory before a word is written, for
+ * the instructions that write it themselves: the copy of a shared segment,
+ * the verifier and the dirty marks.
+ *
+ * Input Parameters
+ *      addr				Address already checked by the caller
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Physical address to write, moved to a private copy of a shared
+ *      segment
+ *      ErrorNoFreeMemory		-No room for a copy of a shared segment
+ ******************************************************************************/
+
+long WritableWord(long addr)
+{
+	if (SharedMemory[addr]) {
+		addr = CopyOnWrite(addr);
+		if (addr < 0)
+			return addr;
+	}
+	if (VerifiedCode[addr])
+		UnverifyWord(addr);
+	if (MemoryModel == MMU_PAGED && addr <= MAX_USER_MEMORY)
+		FrameDirty[addr / PAGE_SIZE] = 1;
+	else if (addr > MAX_USER_MEMORY)
+		HeapDirty[addr / PAGE_SIZE] = 1;	// For mapped files
+	return addr;
+}
+
+/*******************************************************************************
+ * Function: BuildDecodeTable
+ *
+ * Description: Decodes every possible instruction word into DecodeTable.
+ * The instruction length follows the same rules as VerifyProgram: add to
+ * move, compare, compare and swap and fetch and add have two operands,
+ * branch, call, return, the flag branches and the block instructions none
+ * and the other opcodes one, a direct or immediate operand takes a word,
+ * and the branches and call end with their address word. Halt, branch and
+ * return do not go on to the next instruction.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      DecodeTable
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void BuildDecodeTable()
+{
+	struct DecodedWord *decoded = DecodeTable;
+
+	// Digits in word order, so no word is divided
+	for (int opcode = 0; opcode < 100; opcode++) {
+		int operands = (opcode >= 1 && opcode <= 5) || opcode == 18 || opcode == 25 ||
+			opcode == 26 ? 2 : opcode == 6 || (opcode > 12 && opcode < 25) ? 0 : 1;
+		int branch = (opcode >= 6 && opcode <= 9) || opcode == 16 ||
+			(opcode >= 19 && opcode <= 24);
+		int next = opcode != 0 && opcode != 6 && opcode != 17;
+		for (int mode1 = 0; mode1 < 10; mode1++)
+		for (int gpr1 = 0; gpr1 < 10; gpr1++)
+		for (int mode2 = 0; mode2 < 10; mode2++)
+		for (int gpr2 = 0; gpr2 < 10; gpr2++)
+			*decoded++ = (struct DecodedWord) {
+				.Opcode = opcode,
+				.Op1Mode = mode1, .Op1GPR = gpr1,
+				.Op2Mode = mode2, .Op2GPR = gpr2,
+				.Length = 1 + branch +
+					(operands >= 1 && (mode1 == 5 || mode1 == 6)) +
+					(operands == 2 && (mode2 == 5 || mode2 == 6)),
+				.Valid = mode1 <= 6 && mode2 <= 6 &&
+					gpr1 < GPR_NUMBER && gpr2 < GPR_NUMBER,
+				.Branch = branch,
+				.Next = next,
+			};
+	}
+}
+
+/*******************************************************************************
+ * Function: CPU
+ *
+ * Description: CPU Execution is divided into 2 phases.
+ * Decode: Parses the composite instruction into constituent parts. Validation
+ * is done on individual components and an error is returned should any
+ * instruction component is invalid.
+ * Execute: The validity of the instruction (whole and in context) is
+ * performed. Error is returned on an invalid instruction. Given a valid
+ * instruction, a call is made to FetchOperand() and the result of it's
+ * execution defines the state of the machine status (PSR).
+ *
+ * Notes:
+ * Instructions marked by VerifyProgram skip decode validation and run in
+ * ExecuteVerified instead. When native code hands over an instruction it
+ * did not translate, HandoverTime holds the rest of its slice: CPU runs
+ * that one instruction and leaves what remains in HandoverTime.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      OK				-on successful execution
+ *      psr				-Returns Error given by FetchOperand()
+ *      ErrorInvalidAddress		-Payload address not valid
+ *      ErrorRuntime			-Unbound address during runtime
+ *      ErrorInvalidInstruction		-Instruction not valid
+ *      ErrorInvalidOpcode		-Opcode not valid
+ *      ErrorStackOverflow		-Attempted to allocate beyond stack
+ *      ErrorStackUnderflow		-Attempted to allocate beneath stack
+ *
+ * Initial Implementation done by Ykaro Rocha
+ ******************************************************************************/
+
+long CPU()
+{
+	/* Local Variables */
+	long opcode, op1mode, op1gpr, op2mode, op2gpr, op1addr, op1val,
+	     op2addr, op2val, result, SystemCallID, cycles;
+	struct DecodedWord decoded;
+	long status = OK;
+	long TimeLeft = HandoverTime > 0 ? HandoverTime : TIMESLICE;
+	long LastInstruction = HandoverTime > 0 ? InstructionCount + 1 : LONG_MAX;
+	HandoverTime = 0;
+
+	// Run CPU until HALT state or the time slice expires
+	while (status == OK && TimeLeft > 0 && InstructionCount < LastInstruction) {
+
+		// A page fault restarts the instruction from this state
+		if (MemoryModel == MMU_PAGED) {
+			RestartPC = pc;
+			memcpy(RestartGPR, gpr, sizeof(gpr));
+		}
+
+		// Fetch Cycle
+		InstructionCount++;
+		mar = Translate(pc);
+		if (mar >= 0) {
+			pc++;
+			mbr = mem[mar];
+		}
+		else if (mar == ErrorPageFault)
+			return ErrorPageFault;
+		else {
+			printf("ERROR: Invalid Runtime Address: %ld\n", pc);          // Error
+			return(ErrorInvalidAddress);
+		}
+
+		ir = mbr;
+
+		// Instructions proven by VerifyProgram skip every check below
+		if (VerifiedCode[mar] == VERIFIED_INSTRUCTION) {
+			cycles = ExecuteVerified();
+			if (cycles < 0)
+				return cycles;
+			clock += cycles;
+			TimeLeft -= cycles;
+			continue;
+		}
+
+		// Decode Cycle and Decode Validation, one load from DecodeTable
+		if (ir < 0 || ir >= DECODE_WORDS || !DecodeTable[ir].Valid) {
+			printf("ERROR: Invalid Instruction on line %d\n", mar); // Error
+			return ErrorInvalidInstruction;
+		}
+		decoded = DecodeTable[ir];
+		opcode = decoded.Opcode;        //[65]4321
+		op1mode = decoded.Op1Mode;      //[4]321
+		op1gpr = decoded.Op1GPR;        //[3]21
+		op2mode = decoded.Op2Mode;      //[2]1
+		op2gpr = decoded.Op2GPR;        //[1]
+		op1addr = op2addr = -1;
+		op1val = op2val = 0;
+
+
+		// Execute Cycle
+
+		switch (opcode) {
+			case 0:                 //halt
+				if (VerboseMode)
+					printf("Machine is Halting\n");
+				return SIMULATOR_STATUS_HALTED;
+				clock += 12;
+				TimeLeft -= 12;
+				break;
+			case 1:                 //add
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {                //Return ERROR value to Main
+					return status;
+				}
+
+				status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
+				if (status != OK) {
+					return status;
+				}
+
+				//Add Operand Values
+				result = op1val + op2val;
+
+				// If op1mode is Register Mode
+				if (op1mode == 1) {
+					gpr[op1gpr] = result;
+				}
+				else if (op1mode == 6) {
+					printf("ERROR: Line %d Destination cannot be immediate\n", pc);
+					return ErrorImmediateMode;
+				}
+				else {        //Store result in op1address
+					if (StoreMemory(op1addr, result) != OK)
+						return ErrorNoFreeMemory;
+				}
+				clock += 3;
+				TimeLeft -= 3;
+				break;
+			case 2:                 //subtract
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {                //Return ERROR value to Main
+					return status;
+				}
+
+				status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
+				if (status != OK) {
+					return status;
+				}
+
+				//Subtract Operand Values
+				result = op1val - op2val;
+
+				// If op1mode is Register Mode
+				if (op1mode == 1) {
+					gpr[op1gpr] = result;
+				}
+				else if (op1mode == 6) {
+					printf("ERROR: Line %d Destination cannot be immediate\n", pc);
+					return ErrorImmediateMode;
+				}
+				else {        //Store result in op1address
+					if (StoreMemory(op1addr, result) != OK)
+						return ErrorNoFreeMemory;
+				}
+				clock += 3;
+				TimeLeft -= 3;
+				break;
+			case 3:                 //multiply
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {                //Return ERROR value to Main
+					return status;
+				}
+
+				status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
+				if (status != OK) {
+					return status;
+				}
+
+				//Multiply Operand Values
+				result = op1val * op2val;
+
+				// If op1mode is Register Mode
+				if (op1mode == 1) {
+					gpr[op1gpr] = result;
+				}
+				else if (op1mode == 6) {
+					printf("ERROR: Line %d Destination cannot be immediate\n", pc);
+					return ErrorImmediateMode;
+				}
+				else {        //Store result in op1address
+					if (StoreMemory(op1addr, result) != OK)
+						return ErrorNoFreeMemory;
+				}
+				clock += 6;
+				TimeLeft -= 6;
+				break;
+			case 4:                 //divide
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {                //Return ERROR value to Main
+					return status;
+				}
+
+				status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
+				if (status != OK) {
+					return status;
+				}
+
+				//Divide Operand Values
+				if (op2val != 0)		// Division by Zero Check
+					result = op1val / op2val;
+				else {
+					printf("ERROR: Line %d Division by Zero\n", pc);
+					return ErrorRuntime;
+				}
+
+
+				// If op1mode is Register Mode
+				if (op1mode == 1) {
+					gpr[op1gpr] = result;
+				}
+				else if (op1mode == 6) {
+					printf("ERROR: Line %d Destination cannot be immediate\n", pc);
+					return ErrorImmediateMode;
+				}
+				else {        //Store result in op1address
+					if (StoreMemory(op1addr, result) != OK)
+						return ErrorNoFreeMemory;
+				}
+				clock += 6;
+				TimeLeft -= 6;
+				break;
+			case 5:                 //move (op1 <- op2)
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {                //Return ERROR value to Main
+					return status;
+				}
+
+				status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
+				if (status != OK) {
+					return status;
+				}
+
+				// If op1mode is Register Mode
+				if (op1mode == 1) {
+					gpr[op1gpr] = op2val;
+				}
+				else if (op1mode == 6) {
+					printf("ERROR: Line %d Destination cannot be immediate\n", pc);
+					return ErrorImmediateMode;
+				}
+				else {        //Store result in op1address
+					if (StoreMemory(op1addr, op2val) != OK)
+						return ErrorNoFreeMemory;
+				}
+				clock += 2;
+				TimeLeft -= 2;
+				break;
+			case 6:                 //branch
+				if ((mar = Translate(pc)) >= 0)
+					pc = mem[mar];
+				else if (mar == ErrorPageFault)
+					return ErrorPageFault;
+				else {
+					printf("ERROR: Invalid Branch Address at Runtime\n");
+					return ErrorRuntime;
+				}
+				clock += 2;
+				TimeLeft -= 2;
+				break;
+			case 7:                 //branch on minus
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {                //Return ERROR value to Main
+					return status;
+				}
+
+				if (op1val < 0) {
+					if ((mar = Translate(pc)) >= 0) {
+						pc = mem[mar];
+					}
+					else if (mar == ErrorPageFault)
+						return ErrorPageFault;
+					else {
+						printf("ERROR: Invalid Branch Address at Runtime\n");
+						return ErrorRuntime;
+					}
+				}
+				else {
+					pc++;	//Skip Branch and advance
+				}
+				clock += 4;
+				TimeLeft -= 4;
+				break;
+			case 8:                 //branch on plus
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {                //Return ERROR value to Main
+					return status;
+				}
+
+				if (op1val > 0) {
+					if ((mar = Translate(pc)) >= 0) {
+						pc = mem[mar];
+					}
+					else if (mar == ErrorPageFault)
+						return ErrorPageFault;
+					else {
+						printf("ERROR: Invalid Branch Address at Runtime\n");
+						return ErrorRuntime;
+					}
+				}
+				else {
+					pc++;	//Skip Branch and advance
+				}
+				clock += 4;
+				TimeLeft -= 4;
+				break;
+			case 9:                 //branch on zero
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {                //Return ERROR value to Main
+					return status;
+				}
+
+				if (op1val == 0) {
+					if ((mar = Translate(pc)) >= 0) {
+						pc = mem[mar];
+					}
+					else if (mar == ErrorPageFault)
+						return ErrorPageFault;
+					else {
+						printf("ERROR: Invalid Branch Address at Runtime\n");
+						return ErrorRuntime;
+					}
+				}
+				else {
+					pc++;	//Skip Branch and advance
+				}
+				clock += 4;
+				TimeLeft -= 4;
+				break;
+			case 10:                //push
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {                //Return ERROR value to Main
+					return status;
+				}
+
+				// Stack of the process, in the heap, grows upward
+				if (sp >= stacklimit) {
+					printf("ERROR: Stack Address Overflow\n");
+					return ErrorStackOverflow;
+				}
+
+				// Push to Stack
+				sp++;
+				mem[sp] = op1val;
+				clock += 2;
+				TimeLeft -= 2;
+				break;
+			case 11:                //pop
+				if (sp < stackbase) {
+					printf("ERROR: Stack Address Underflow\n");
+					return ErrorStackUnderflow;
+				}
+
+				// Pop Stack into Op1, an omitted Op1 discards the value
+				if (op1mode != 0) {
+					status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+					if (status != OK) {                //Return ERROR value to Main
+						return status;
+					}
+				}
+
+				if (op1mode == 1) {
+					gpr[op1gpr] = mem[sp];
+				}
+				else if (op1mode == 6) {
+					printf("ERROR: Line %ld Destination cannot be immediate\n", pc);
+					return ErrorImmediateMode;
+				}
+				else if (op1mode != 0) {
+					if (StoreMemory(op1addr, mem[sp]) != OK)
+						return ErrorNoFreeMemory;
+				}
+				sp--;
+				clock += 2;
+				TimeLeft -= 2;
+				break;
+			case 12:                //system call
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {
+					printf("ERROR: Systemcall to Invalid Address\n");
+					return ErrorRuntime;
+				}
+				SystemCallID = op1val;          //Immediate operand is the ID
+				status = SystemCall(SystemCallID);
+				clock += 12;
+				TimeLeft -= 12;
+
+				// Events (I/O requests and waits), exit and faults give up
+				// the CPU, other results are in GPR0
+				if (status >= SIMULATOR_STATUS_HALTED || status == ErrorPageFault)
+					return status;
+				status = OK;
+				break;
+			case 13:                //block move
+			case 14:                //block fill
+			case 15:                //block compare
+				cycles = BlockInstruction(opcode);
+				if (cycles < 0)
+					return cycles;
+				clock += cycles;
+				TimeLeft -= cycles;
+				break;
+			case 16:                //call
+				if (sp >= stacklimit) {
+					printf("ERROR: Stack Address Overflow\n");
+					return ErrorStackOverflow;
+				}
+
+				// Return address is past the call address word
+				if ((mar = Translate(pc)) >= 0) {
+					mem[++sp] = pc + 1;
+					pc = mem[mar];
+				}
+				else if (mar == ErrorPageFault)
+					return ErrorPageFault;
+				else {
+					printf("ERROR: Invalid Call Address at Runtime\n");
+					return ErrorRuntime;
+				}
+				clock += 4;
+				TimeLeft -= 4;
+				break;
+			case 17:                //return
+				if (sp < stackbase) {
+					printf("ERROR: Stack Address Underflow\n");
+					return ErrorStackUnderflow;
+				}
+				pc = mem[sp--];
+				clock += 2;
+				TimeLeft -= 2;
+				break;
+			case 18:                //compare, sets the PSR flags only
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {                //Return ERROR value to Main
+					return status;
+				}
+
+				status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
+				if (status != OK) {
+					return status;
+				}
+
+				psr = (psr & ~PSR_FLAGS) | CompareFlags(op1val, op2val);
+				clock += 3;
+				TimeLeft -= 3;
+				break;
+			case 19:                //branch on equal
+			case 20:                //branch on not equal
+			case 21:                //branch on less
+			case 22:                //branch on less or equal
+			case 23:                //branch on greater
+			case 24:                //branch on greater or equal
+				if (FlagsTaken(opcode, psr)) {
+					if ((mar = Translate(pc)) >= 0) {
+						pc = mem[mar];
+					}
+					else if (mar == ErrorPageFault)
+						return ErrorPageFault;
+					else {
+						printf("ERROR: Invalid Branch Address at Runtime\n");
+						return ErrorRuntime;
+					}
+				}
+				else {
+					pc++;	//Skip Branch and advance
+				}
+				clock += 4;
+				TimeLeft -= 4;
+				break;
+			case 25:                //compare and swap
+			case 26:                //fetch and add
+			case 27:                //test and set
+				status = FetchOperand(op1mode, op1gpr, &op1addr, &op1val);
+				if (status != OK) {                //Return ERROR value to Main
+					return status;
+				}
+
+				if (opcode != 27) {
+					status = FetchOperand(op2mode, op2gpr, &op2addr, &op2val);
+					if (status != OK) {
+						return status;
+					}
+				}
+
+				// The word is shared with other processes, so it is in memory
+				if (op1mode == 6) {
+					printf("ERROR: Line %ld Destination cannot be immediate\n", pc);
+					return ErrorImmediateMode;
+				}
+				else if (op1mode < 2) {
+					printf("ERROR: Line %ld Atomic operand must be in memory\n", pc);
+					return ErrorInvalidMode;
+				}
+				if (AtomicInstruction(opcode, op1addr, opcode == 27 ? 1 : op2val) != OK)
+					return ErrorNoFreeMemory;
+				clock += 4;
+				TimeLeft -= 4;
+				break;
+			default:                //Invalid Opcode
+				printf("ERROR: Invalid opcode on line %d\n", mar);         // Error
+				return ErrorInvalidOpcode;
+		}
+	}
+	if (status != OK)
+		return status;
+	if (TimeLeft > 0) {
+		HandoverTime = TimeLeft;	// Back to the native code
+		return OK;
+	}
+	return TimeSliceExpired;
+}
+
+/*******************************************************************************
+ * Function: BlockInstruction
+ *
+ * Description: Executes Block Move (13), Block Fill (14) and Block Compare
+ * (15). They have no operands and work on whole runs of words with
+ * memmove, a fill loop and memcmp instead of a fetch and dispatch a word:
+ * R1 is the destination, R2 the source (the value, for Block Fill) and R3
+ * the count. Words are taken in ascending order, so a move to a higher
+ * address that overlaps its source repeats the first words, as a Move
+ * loop would. When the instruction is done R1 and R2 point past the last
+ * word and R3 is 0; Block Compare stops at the first difference instead,
+ * leaving R1 and R2 at it, the words left in R3 and in R0 -1, 0 or 1 as
+ * the destination word is below, equal to or above the source word.
+ * Both ranges are checked before anything is written. A page fault part
+ * way keeps the progress in the restart state, so the instruction resumes
+ * where it stopped.
+ *
+ * Input Parameters
+ *      opcode				13, 14 or 15
+ *
+ * Output Parameters
+ *      gpr[0] to gpr[3]
+ *
+ * Function Return Value
+ *      Clock cycles, 4 and one per word
+ *      ErrorInvalidAddress		-Range outside the program and heap
+ *      ErrorPageFault
+ *      ErrorNoFreeMemory		-No room for a copy of a shared segment
+ ******************************************************************************/
+
+long BlockInstruction(long opcode)
+{
+	long done = 0, status = OK;
+
+	if (opcode == 15)
+		gpr[0] = 0;
+	if (!BlockInRange(gpr[1], gpr[3]) || (opcode != 14 && !BlockInRange(gpr[2], gpr[3]))) {
+		printf("ERROR: Invalid block of %ld words at %ld\n", gpr[3], gpr[1]);
+		return ErrorInvalidAddress;
+	}
+
+	while (gpr[3] > 0) {
+		long dst, src = 0;
+		long run = BlockRun(gpr[1], gpr[3], &dst);
+		if (run < 0) {
+			status = run;
+			break;
+		}
+
+		// Every word written goes through the checks of StoreMemory
+		if (opcode != 15) {
+			if (memchr(&SharedMemory[dst], 1, run) != NULL) {
+				if (StoreMemory(dst, mem[dst]) != OK)
+					return ErrorNoFreeMemory;
+				continue;	// Moved to the private copy
+			}
+			for (long i = 0; i < run; i++)
+				if (VerifiedCode[dst + i])
+					UnverifyWord(dst + i);
+			for (long page = dst / PAGE_SIZE; page <= (dst + run - 1) / PAGE_SIZE; page++)
+				if (MemoryModel == MMU_PAGED && dst <= MAX_USER_MEMORY)
+					FrameDirty[page] = 1;
+				else if (dst > MAX_USER_MEMORY)
+					HeapDirty[page] = 1;
+		}
+		if (opcode != 14) {
+			run = BlockRun(gpr[2], run, &src);
+			if (run < 0) {
+				status = run;
+				break;
+			}
+		}
+
+		if (opcode == 13 && src < dst && dst < src + run)
+			for (long i = 0; i < run; i++)
+				mem[dst + i] = mem[src + i];
+		else if (opcode == 13)
+			memmove(&mem[dst], &mem[src], run * sizeof(long));
+		else if (opcode == 14)
+			for (long i = 0; i < run; i++)
+				mem[dst + i] = gpr[2];
+		else if (memcmp(&mem[dst], &mem[src], run * sizeof(long)) != 0) {
+			long i = 0;
+			while (mem[dst + i] == mem[src + i])
+				i++;
+			gpr[0] = mem[dst + i] < mem[src + i] ? -1 : 1;
+			run = i;
+		}
+
+		gpr[1] += run;
+		if (opcode != 14)
+			gpr[2] += run;
+		gpr[3] -= run;
+		done += run;
+		if (gpr[0] != 0 && opcode == 15) {
+			done++;		// The differing words were read
+			break;
+		}
+	}
+
+	if (status == ErrorPageFault) {
+		memcpy(RestartGPR, gpr, sizeof(gpr));
+		clock += done;
+	}
+	return status == OK ? 4 + done : status;
+}
+
+/*******************************************************************************
+ * Function: BlockInRange
+ *
+ * Description: Checks that every word of a block is an address the
+ * running process may use, as Translate would find it.
+ *
+ * Input Parameters
+ *      Address				First program address
+ *      Length				Words in the block
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Non-zero when the block is inside the program and heap
+ ******************************************************************************/
+
+int BlockInRange(long Address, long Length)
+{
+	if (Address < 0 || Length < 0 || Length > MAX_VIRTUAL_MEMORY + 1)
+		return 0;
+
+	// Program addresses, then the heap above the user region
+	long start = Address < limit ? limit : Address;
+	long end = Address + Length;
+	return start >= end || (start > MAX_USER_MEMORY && end <= MAX_HEAP_MEMORY + 1);
+}
+
+/*******************************************************************************
+ * Function: BlockRun
+ *
+ * Description: Translates the start of a block checked by BlockInRange and
+ * finds how many of its words follow it in physical memory: up to the end
+ * of the heap, of the page, or of the code or data segment.
+ *
+ * Input Parameters
+ *      Address				First program address
+ *      Length				Words left in the block
+ *
+ * Output Parameters
+ *      Physical			Physical address of the first word
+ *
+ * Function Return Value
+ *      Words in the run, 1 to Length
+ *      ErrorPageFault
+ ******************************************************************************/
+
+long BlockRun(long Address, long Length, long *Physical)
+{
+	long end;
+
+	*Physical = Translate(Address);
+	if (*Physical < 0)
+		return *Physical;
+	if (Address > MAX_USER_MEMORY && Address <= MAX_HEAP_MEMORY)
+		end = MAX_HEAP_MEMORY + 1;
+	else if (MemoryModel == MMU_PAGED)
+		end = (Address / PAGE_SIZE + 1) * PAGE_SIZE;
+	else if (Address < codelimit)
+		end = codelimit;
+	else
+		end = limit;
+	return Length < end - Address ? Length : end - Address;
+}
+
+/*******************************************************************************
+ * Function: AtomicInstruction
+ *
+ * Description: Executes Compare And Swap (25), Fetch And Add (26) and Test
+ * And Set (27) on a memory word, in one host atomic operation so that the
+ * update stays whole if processes ever run on several host threads; a
+ * time slice only ends between instructions. Compare And Swap stores the
+ * value when the word equals R0, Fetch And Add adds the value to the word
+ * and Test And Set stores 1. The word as it was goes to R0 and sets the
+ * PSR flags as Compare would against R0 for Compare And Swap and against
+ * 0 for the others, so Z tells that the swap was made or the lock was
+ * free.
+ *
+ * Input Parameters
+ *      opcode				25, 26 or 27
+ *      addr				Physical address of Op1
+ *      value				Op2, or 1 for Test And Set
+ *
+ * Output Parameters
+ *      gpr[0], psr
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorNoFreeMemory		-No room for a copy of a shared segment
+ ******************************************************************************/
+
+long AtomicInstruction(long opcode, long addr, long value)
+{
+	long old, expected = opcode == 25 ? gpr[0] : 0;
+
+	addr = WritableWord(addr);
+	if (addr < 0)
+		return addr;
+
+	if (opcode == 25) {
+		old = expected;
+		__atomic_compare_exchange_n(&mem[addr], &old, value, 0,
+				__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	}
+	else if (opcode == 26)
+		old = __atomic_fetch_add(&mem[addr], value, __ATOMIC_SEQ_CST);
+	else
+		old = __atomic_exchange_n(&mem[addr], value, __ATOMIC_SEQ_CST);
+
+	gpr[0] = old;
+	psr = (psr & ~PSR_FLAGS) | CompareFlags(old, expected);
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: CompareFlags
+ *
+ * Description: PSR condition flags Compare sets for its operands.
+ *
+ * Input Parameters
+ *      Op1, Op2			Operand values
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      PSR_ZERO, PSR_NEGATIVE or 0
+ ******************************************************************************/
+
+static inline long CompareFlags(long Op1, long Op2)
+{
+	return (Op1 == Op2 ? PSR_ZERO : 0) | (Op1 < Op2 ? PSR_NEGATIVE : 0);
+}
+
+/*******************************************************************************
+ * Function: FlagsTaken
+ *
+ * Description: Tests the condition of a flag branch, opcodes 19 to 24,
+ * against the flags of the last Compare.
+ *
+ * Input Parameters
+ *      opcode				Branch opcode
+ *      flags				PSR
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Non-zero when the branch is taken
+ ******************************************************************************/
+
+static inline int FlagsTaken(long opcode, long flags)
+{
+	int zero = (flags & PSR_ZERO) != 0, negative = (flags & PSR_NEGATIVE) != 0;
+
+	switch (opcode) {
+		case 19:                //equal
+			return zero;
+		case 20:                //not equal
+			return !zero;
+		case 21:                //less
+			return negative;
+		case 22:                //less or equal
+			return negative | zero;
+		case 23:                //greater
+			return !negative & !zero;
+		default:                //greater or equal
+			return !negative;
+	}
+}
+
+/*******************************************************************************
+ * Function: ExecuteVerified
+ *
+ * Description: Executes the instruction in ir, fetched from an address
+ * marked by VerifyProgram. Modes are register, direct or immediate and
+ * every address was proven inside the program, so translation is just
+ * SegmentAddress, instruction words come from the code segment, and
+ * nothing is checked here but the stack bounds of push, pop, call and
+ * return.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Clock cycles used by the instruction
+ *      ErrorNoFreeMemory		-No room for a copy on write
+ *      ErrorStackOverflow
+ *      ErrorStackUnderflow
+ ******************************************************************************/
+
+long ExecuteVerified()
+{
+	struct DecodedWord decoded = DecodeTable[ir];
+	long opcode = decoded.Opcode;
+	long op1mode = decoded.Op1Mode, op1gpr = decoded.Op1GPR;
+	long op2mode = decoded.Op2Mode, op2gpr = decoded.Op2GPR;
+	long op1addr = -1, op1val = 0, op2val = 0, result, cycles;
+
+	VerifiedCount++;
+
+	// Branch, Call, Return and the flag branches have no operands, the
+	// conditional branches, Push and Pop Op1 only
+	if (opcode == 6 || (opcode >= 16 && opcode != 18))
+		op1mode = op2mode = 0;
+	else if (opcode >= 7 && opcode <= 11)
+		op2mode = 0;
+
+	if (op1mode == 1)
+		op1val = gpr[op1gpr];
+	else if (op1mode == 5)
+		op1val = mem[op1addr = SegmentAddress(mem[codebase + pc++], codebase, codelimit, base)];
+	else if (op1mode == 6)
+		op1val = mem[codebase + pc++];
+
+	if (op2mode == 1)
+		op2val = gpr[op2gpr];
+	else if (op2mode == 5)
+		op2val = mem[SegmentAddress(mem[codebase + pc++], codebase, codelimit, base)];
+	else if (op2mode == 6)
+		op2val = mem[codebase + pc++];
+
+	switch (opcode) {
+		case 1:                 //add
+			result = op1val + op2val;
+			cycles = 3;
+			break;
+		case 2:                 //subtract
+			result = op1val - op2val;
+			cycles = 3;
+			break;
+		case 3:                 //multiply
+			result = op1val * op2val;
+			cycles = 6;
+			break;
+		case 4:                 //divide, by a non-zero immediate
+			result = op1val / op2val;
+			cycles = 6;
+			break;
+		case 5:                 //move
+			result = op2val;
+			cycles = 2;
+			break;
+		case 6:                 //branch
+			pc = mem[codebase + pc];
+			return 2;
+		case 7:                 //branch on minus
+			pc = op1val < 0 ? mem[codebase + pc] : pc + 1;
+			return 4;
+		case 8:                 //branch on plus
+			pc = op1val > 0 ? mem[codebase + pc] : pc + 1;
+			return 4;
+		case 9:                 //branch on zero
+			pc = op1val == 0 ? mem[codebase + pc] : pc + 1;
+			return 4;
+		case 10:                //push
+			if (sp >= stacklimit) {
+				printf("ERROR: Stack Address Overflow\n");
+				return ErrorStackOverflow;
+			}
+			mem[++sp] = op1val;
+			return 2;
+		case 16:                //call
+			if (sp >= stacklimit) {
+				printf("ERROR: Stack Address Overflow\n");
+				return ErrorStackOverflow;
+			}
+			mem[++sp] = pc + 1;
+			pc = mem[codebase + pc];
+			return 4;
+		case 17:                //return, to a PC checked by the next fetch
+			if (sp < stackbase) {
+				printf("ERROR: Stack Address Underflow\n");
+				return ErrorStackUnderflow;
+			}
+			pc = mem[sp--];
+			return 2;
+		case 18:                //compare
+			psr = (psr & ~PSR_FLAGS) | CompareFlags(op1val, op2val);
+			return 3;
+		case 19:                //branch on equal
+		case 20:                //branch on not equal
+		case 21:                //branch on less
+		case 22:                //branch on less or equal
+		case 23:                //branch on greater
+		case 24:                //branch on greater or equal
+			pc = FlagsTaken(opcode, psr) ? mem[codebase + pc] : pc + 1;
+			return 4;
+		default:                //pop
+			if (sp < stackbase) {
+				printf("ERROR: Stack Address Underflow\n");
+				return ErrorStackUnderflow;
+			}
+			result = mem[sp--];
+			if (op1mode == 0)
+				return 2;
+			cycles = 2;
+			break;
+	}
+
+	if (op1mode == 1)
+		gpr[op1gpr] = result;
+	else if (StoreMemory(op1addr, result) != OK)
+		return ErrorNoFreeMemory;
+	return cycles;
+}
+
+/*******************************************************************************
+ * Function: RunLanes
+ *
+ * Description: Runs a program once for every line of an inputs file and
+ * prints the final state of each run. A line holds the starting values of
+ * GPR 0 up, missing ones being 0. The runs, or lanes, go LANE_GROUP at a
+ * time, the lanes of a group in step: each step issues the instruction at
+ * the lowest PC to every lane there, so lanes that took a branch ahead
+ * wait for the others to reach them. There is no OS: a lane stops at Halt,
+ * at an error, at a System Call, block or atomic instruction (ErrorRuntime)
+ * or at LANE_CLOCK_LIMIT (TimeSliceExpired).
+ *
+ * Input Parameters
+ *      filename			Object module of the program
+ *      inputs				Inputs file, a line per lane
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      OK
+ *      Error from LoadLanes
+ ******************************************************************************/
+
+LANE_TARGETS long RunLanes(char *filename, char *inputs)
+{
+	long status = LoadLanes(filename, inputs);
+	if (status != OK)
+		return status;
+
+	HostStartTime = HostTimeNanoseconds();
+	for (long first = 0; first < LaneCount; first += LANE_GROUP) {
+		LoadGroup(first);
+		for (;;) {
+			long pc = LONG_MAX, running = 0;
+			for (int lane = 0; lane < LANE_GROUP; lane++) {
+				long live = GroupStatus[lane] == OK;
+				pc = live && GroupPC[lane] < pc ? GroupPC[lane] : pc;
+				running += live;
+			}
+			if (!running)
+				break;
+			StepLanes(pc);
+			LaneSteps++;
+		}
+		SaveGroup(first);
+	}
+
+	for (long lane = 0; lane < LaneCount; lane++)
+		if (LaneClock[lane] > clock)
+			clock = LaneClock[lane];
+	PrintStatistics();
+	PrintLanes();
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: LoadLanes
+ *
+ * Description: Reads the program and the inputs of a sweep. Every lane gets
+ * the program at address 0, as in the segment model, and an empty stack
+ * of DEFAULT_STACK_SIZE words after it.
+ *
+ * Input Parameters
+ *      filename			Object module of the program
+ *      inputs				Inputs file, a line per lane
+ *
+ * Output Parameters
+ *      LaneCount, LaneWords, LaneImage and the GPRs of every lane
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorFileOpen
+ *      ErrorRuntime			-No lines, or more than MAX_LANES
+ *      ErrorNoFreeMemory		-Out of host memory
+ *      Error from ReadObjectModule
+ ******************************************************************************/
+
+long LoadLanes(char *filename, char *inputs)
+{
+	static long Image[MAX_VIRTUAL_MEMORY + 1];
+	static char Relocate[MAX_VIRTUAL_MEMORY + 1];
+	char line[256];
+	long size, lane = 0;
+
+	LaneEntry = ReadObjectModule(filename, Image, Relocate, &size);
+	if (LaneEntry < 0)
+		return LaneEntry;
+
+	FILE *fp = fopen(inputs, "r");
+	if (fp == NULL) {
+		printf("ERROR: Unable to open file.\n");
+		return ErrorFileOpen;
+	}
+	while (fgets(line, sizeof(line), fp) != NULL)
+		if (line[strspn(line, " \t\r\n")] != '\0')	// Blank lines are skipped
+			LaneCount++;
+	if (LaneCount == 0 || LaneCount > MAX_LANES) {
+		fclose(fp);
+		printf("ERROR: Inputs must have 1 to %d lines\n", MAX_LANES);
+		return ErrorRuntime;
+	}
+
+	LaneStackBase = size;
+	LaneWords = size + DEFAULT_STACK_SIZE;
+	LaneImage = calloc(LaneWords, sizeof(long));
+	LaneGPR = calloc(LaneCount * GPR_NUMBER, sizeof(long));
+	LanePC = malloc(LaneCount * sizeof(long));
+	LaneClock = malloc(LaneCount * sizeof(long));
+	LaneStatus = malloc(LaneCount * sizeof(long));
+	GroupMem = malloc(LaneWords * LANE_GROUP * sizeof(long));
+	if (LaneImage == NULL || LaneGPR == NULL || LanePC == NULL || LaneClock == NULL ||
+			LaneStatus == NULL || GroupMem == NULL) {
+		fclose(fp);
+		printf("ERROR: No host memory for %ld lanes\n", LaneCount);
+		return ErrorNoFreeMemory;
+	}
+	memcpy(LaneImage, Image, size * sizeof(long));
+
+	rewind(fp);
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		char *next = line, *end;
+		if (line[strspn(line, " \t\r\n")] == '\0')
+			continue;
+		for (int reg = 0; reg < GPR_NUMBER; reg++) {
+			long value = strtol(next, &end, 10);
+			if (end == next)
+				break;
+			LaneGPR[lane * GPR_NUMBER + reg] = value;
+			next = end;
+		}
+		lane++;
+	}
+	fclose(fp);
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: LoadGroup
+ *
+ * Description: Starts the lanes of a group. Slots of the last group past
+ * the last lane are stopped from the start.
+ *
+ * Input Parameters
+ *      first				First lane of the group
+ *
+ * Output Parameters
+ *      Group state
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void LoadGroup(long first)
+{
+	for (long addr = 0; addr < LaneWords; addr++)
+		for (int lane = 0; lane < LANE_GROUP; lane++)
+			GroupMem[addr * LANE_GROUP + lane] = LaneImage[addr];
+
+	for (int lane = 0; lane < LANE_GROUP; lane++) {
+		int used = first + lane < LaneCount;
+		for (int reg = 0; reg < GPR_NUMBER; reg++)
+			GroupGPR[reg][lane] = used ? LaneGPR[(first + lane) * GPR_NUMBER + reg] : 0;
+		GroupPC[lane] = LaneEntry;
+		GroupSP[lane] = LaneStackBase - 1;	// Empty, push increments SP first
+		GroupClock[lane] = 0;
+		GroupPSR[lane] = 0;
+		GroupStatus[lane] = used ? OK : SIMULATOR_STATUS_HALTED;
+	}
+	GroupCodeWritten = 0;
+}
+
+/*******************************************************************************
+ * Function: SaveGroup
+ *
+ * Description: Keeps the final state of the lanes of a group for PrintLanes.
+ *
+ * Input Parameters
+ *      first				First lane of the group
+ *
+ * Output Parameters
+ *      LaneGPR, LanePC, LaneClock, LaneStatus
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void SaveGroup(long first)
+{
+	for (int lane = 0; lane < LANE_GROUP && first + lane < LaneCount; lane++) {
+		for (int reg = 0; reg < GPR_NUMBER; reg++)
+			LaneGPR[(first + lane) * GPR_NUMBER + reg] = GroupGPR[reg][lane];
+		LanePC[first + lane] = GroupPC[lane];
+		LaneClock[first + lane] = GroupClock[lane];
+		LaneStatus[first + lane] = GroupStatus[lane];
+	}
+}
+
+/*******************************************************************************
+ * Function: StepLanes
+ *
+ * Description: Issues one instruction to the running lanes of the group at
+ * a PC. Once a lane has stored into its program, lanes whose word there
+ * differs from that of the first of them wait for a later step. The
+ * lanes taking part are marked in GroupMask, and each phase of the
+ * instruction is a loop over the group, masked by it, without branches
+ * where the phase allows, so that the compiler can vectorize it. An
+ * error stops only the lanes it occurs in.
+ *
+ * Input Parameters
+ *      pc				PC of the lanes to step
+ *
+ * Output Parameters
+ *      Group state
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+LANE_TARGETS void StepLanes(long pc)
+{
+	long next = pc + 1, cycles = 0, issued = 0, ir = 0;
+	long *Word = &GroupMem[pc * LANE_GROUP], *Result = GroupOp1, *Target, *Op1GPR;
+	int branched = 0, stored = 0, first = 0;
+
+	if (pc < 0 || pc >= LaneWords) {
+		for (int lane = 0; lane < LANE_GROUP; lane++)
+			GroupMask[lane] = GroupStatus[lane] == OK && GroupPC[lane] == pc;
+		StopLanes(ErrorInvalidAddress);
+		return;
+	}
+	while (GroupStatus[first] != OK || GroupPC[first] != pc)
+		first++;
+	ir = Word[first];
+	if (GroupCodeWritten)
+		for (int lane = 0; lane < LANE_GROUP; lane++) {
+			GroupMask[lane] = (GroupStatus[lane] == OK) & (GroupPC[lane] == pc) & (Word[lane] == ir);
+			issued += GroupMask[lane];
+		}
+	else
+		for (int lane = 0; lane < LANE_GROUP; lane++) {
+			GroupMask[lane] = (GroupStatus[lane] == OK) & (GroupPC[lane] == pc);
+			issued += GroupMask[lane];
+		}
+	InstructionCount += issued;
+
+	// Decode once for the group
+	if (ir < 0 || ir >= DECODE_WORDS || !DecodeTable[ir].Valid) {
+		StopLanes(ErrorInvalidInstruction);
+		return;
+	}
+	struct DecodedWord decoded = DecodeTable[ir];
+	long opcode = decoded.Opcode, op1mode = decoded.Op1Mode, op2mode = decoded.Op2Mode;
+	Op1GPR = GroupGPR[decoded.Op1GPR];
+
+	switch (opcode) {
+		case 0:                 //halt
+			StopLanes(SIMULATOR_STATUS_HALTED);
+			return;
+		case 1:                 //add
+		case 2:                 //subtract
+		case 3:                 //multiply
+		case 4:                 //divide
+		case 5:                 //move
+			cycles = opcode <= 2 ? 3 : opcode <= 4 ? 6 : 2;
+
+			// Register from register or immediate: one pass over the group
+			if (op1mode == 1 && (op2mode == 1 || op2mode == 6) && opcode != 4) {
+				if (op2mode == 6 && next >= LaneWords) {
+					StopLanes(ErrorRuntime);
+					return;
+				}
+				long *Source = op2mode == 1 ? GroupGPR[decoded.Op2GPR] :
+					&GroupMem[next++ * LANE_GROUP];
+				if (opcode == 1)
+					for (int lane = 0; lane < LANE_GROUP; lane++)
+						Op1GPR[lane] = GroupMask[lane] ? Op1GPR[lane] + Source[lane] : Op1GPR[lane];
+				else if (opcode == 2)
+					for (int lane = 0; lane < LANE_GROUP; lane++)
+						Op1GPR[lane] = GroupMask[lane] ? Op1GPR[lane] - Source[lane] : Op1GPR[lane];
+				else if (opcode == 3)
+					for (int lane = 0; lane < LANE_GROUP; lane++)
+						Op1GPR[lane] = GroupMask[lane] ? Op1GPR[lane] * Source[lane] : Op1GPR[lane];
+				else
+					for (int lane = 0; lane < LANE_GROUP; lane++)
+						Op1GPR[lane] = GroupMask[lane] ? Source[lane] : Op1GPR[lane];
+				stored = 1;
+				break;
+			}
+
+			if (LaneOperand(op1mode, decoded.Op1GPR, &next, GroupOp1, GroupAddr[0]) != OK ||
+					LaneOperand(op2mode, decoded.Op2GPR, &next, GroupOp2, GroupAddr[1]) != OK)
+				return;
+			if (op1mode == 6) {
+				StopLanes(ErrorImmediateMode);
+				return;
+			}
+			if (opcode == 1)
+				for (int lane = 0; lane < LANE_GROUP; lane++)
+					GroupOp1[lane] += GroupOp2[lane];
+			else if (opcode == 2)
+				for (int lane = 0; lane < LANE_GROUP; lane++)
+					GroupOp1[lane] -= GroupOp2[lane];
+			else if (opcode == 3)
+				for (int lane = 0; lane < LANE_GROUP; lane++)
+					GroupOp1[lane] *= GroupOp2[lane];
+			else if (opcode == 4) {
+				for (int lane = 0; lane < LANE_GROUP; lane++) {
+					long zero = GroupMask[lane] & (GroupOp2[lane] == 0);	// Division by zero
+					GroupStatus[lane] = zero ? ErrorRuntime : GroupStatus[lane];
+					GroupMask[lane] &= !zero;
+				}
+				for (int lane = 0; lane < LANE_GROUP; lane++)
+					if (GroupMask[lane])
+						GroupOp1[lane] /= GroupOp2[lane];
+			}
+			else
+				Result = GroupOp2;
+			break;
+		case 6:                 //branch
+			if (next >= LaneWords) {
+				StopLanes(ErrorRuntime);
+				return;
+			}
+			Target = &GroupMem[next * LANE_GROUP];
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				GroupPC[lane] = GroupMask[lane] ? Target[lane] : GroupPC[lane];
+			branched = 1;
+			cycles = 2;
+			break;
+		case 7:                 //branch on minus
+		case 8:                 //branch on plus
+		case 9:                 //branch on zero
+			if (LaneOperand(op1mode, decoded.Op1GPR, &next, GroupOp1, GroupAddr[0]) != OK)
+				return;
+			for (int lane = 0; lane < LANE_GROUP; lane++) {
+				long value = GroupOp1[lane];
+				GroupOp2[lane] = opcode == 7 ? value < 0 : opcode == 8 ? value > 0 : value == 0;
+			}
+			if (next >= LaneWords) {	// No branch address word
+				for (int lane = 0; lane < LANE_GROUP; lane++) {
+					long taken = GroupMask[lane] & GroupOp2[lane];
+					GroupStatus[lane] = taken ? ErrorRuntime : GroupStatus[lane];
+					GroupMask[lane] &= !taken;
+				}
+				Target = GroupOp1;	// Not taken by any lane
+			}
+			else
+				Target = &GroupMem[next * LANE_GROUP];
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				GroupPC[lane] = !GroupMask[lane] ? GroupPC[lane] :
+					GroupOp2[lane] ? Target[lane] : next + 1;
+			branched = 1;
+			cycles = 4;
+			break;
+		case 10:                //push
+			if (LaneOperand(op1mode, decoded.Op1GPR, &next, GroupOp1, GroupAddr[0]) != OK)
+				return;
+			for (int lane = 0; lane < LANE_GROUP; lane++) {
+				long full = GroupMask[lane] & (GroupSP[lane] >= LaneWords - 1);
+				GroupStatus[lane] = full ? ErrorStackOverflow : GroupStatus[lane];
+				GroupMask[lane] &= !full;
+			}
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				if (GroupMask[lane])
+					GroupMem[++GroupSP[lane] * LANE_GROUP + lane] = GroupOp1[lane];
+			cycles = 2;
+			break;
+		case 11:                //pop
+			for (int lane = 0; lane < LANE_GROUP; lane++) {
+				long empty = GroupMask[lane] & (GroupSP[lane] < LaneStackBase);
+				GroupStatus[lane] = empty ? ErrorStackUnderflow : GroupStatus[lane];
+				GroupMask[lane] &= !empty;
+			}
+			if (op1mode == 6) {
+				StopLanes(ErrorImmediateMode);
+				return;
+			}
+			if (op1mode != 0 &&
+					LaneOperand(op1mode, decoded.Op1GPR, &next, GroupOp1, GroupAddr[0]) != OK)
+				return;
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				if (GroupMask[lane])
+					GroupOp2[lane] = GroupMem[GroupSP[lane]-- * LANE_GROUP + lane];
+			if (op1mode == 0)
+				op1mode = 6;		// Value discarded
+			Result = GroupOp2;
+			cycles = 2;
+			break;
+		case 12:                //system call, needs the OS
+			LaneOperand(op1mode, decoded.Op1GPR, &next, GroupOp1, GroupAddr[0]);
+			StopLanes(ErrorRuntime);
+			return;
+		case 13:                //block and atomic instructions, run by CPU only
+		case 14:
+		case 15:
+		case 25:
+		case 26:
+		case 27:
+			StopLanes(ErrorRuntime);
+			return;
+		case 16:                //call
+			if (next >= LaneWords) {
+				StopLanes(ErrorRuntime);
+				return;
+			}
+			for (int lane = 0; lane < LANE_GROUP; lane++) {
+				long full = GroupMask[lane] & (GroupSP[lane] >= LaneWords - 1);
+				GroupStatus[lane] = full ? ErrorStackOverflow : GroupStatus[lane];
+				GroupMask[lane] &= !full;
+			}
+			Target = &GroupMem[next * LANE_GROUP];
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				if (GroupMask[lane]) {
+					GroupMem[++GroupSP[lane] * LANE_GROUP + lane] = next + 1;
+					GroupPC[lane] = Target[lane];
+				}
+			branched = 1;
+			cycles = 4;
+			break;
+		case 17:                //return
+			for (int lane = 0; lane < LANE_GROUP; lane++) {
+				long empty = GroupMask[lane] & (GroupSP[lane] < LaneStackBase);
+				GroupStatus[lane] = empty ? ErrorStackUnderflow : GroupStatus[lane];
+				GroupMask[lane] &= !empty;
+			}
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				if (GroupMask[lane])
+					GroupPC[lane] = GroupMem[GroupSP[lane]-- * LANE_GROUP + lane];
+			branched = 1;
+			cycles = 2;
+			break;
+		case 18:                //compare
+			if (LaneOperand(op1mode, decoded.Op1GPR, &next, GroupOp1, GroupAddr[0]) != OK ||
+					LaneOperand(op2mode, decoded.Op2GPR, &next, GroupOp2, GroupAddr[1]) != OK)
+				return;
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				GroupPSR[lane] = GroupMask[lane] ?
+					CompareFlags(GroupOp1[lane], GroupOp2[lane]) : GroupPSR[lane];
+			stored = 1;		// No result
+			cycles = 3;
+			break;
+		case 19:                //branch on equal
+		case 20:                //branch on not equal
+		case 21:                //branch on less
+		case 22:                //branch on less or equal
+		case 23:                //branch on greater
+		case 24:                //branch on greater or equal
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				GroupOp2[lane] = FlagsTaken(opcode, GroupPSR[lane]);
+			if (next >= LaneWords) {	// No branch address word
+				for (int lane = 0; lane < LANE_GROUP; lane++) {
+					long taken = GroupMask[lane] & GroupOp2[lane];
+					GroupStatus[lane] = taken ? ErrorRuntime : GroupStatus[lane];
+					GroupMask[lane] &= !taken;
+				}
+				Target = GroupOp1;	// Not taken by any lane
+			}
+			else
+				Target = &GroupMem[next * LANE_GROUP];
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				GroupPC[lane] = !GroupMask[lane] ? GroupPC[lane] :
+					GroupOp2[lane] ? Target[lane] : next + 1;
+			branched = 1;
+			cycles = 4;
+			break;
+		default:                //Invalid Opcode
+			StopLanes(ErrorInvalidOpcode);
+			return;
+	}
+
+	// Add to Move and Pop store their result in Op1; Compare has none
+	if (!branched && !stored && opcode != 10) {
+		if (op1mode == 1)
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				Op1GPR[lane] = GroupMask[lane] ? Result[lane] : Op1GPR[lane];
+		else if (op1mode != 6)
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				if (GroupMask[lane]) {
+					GroupMem[GroupAddr[0][lane] * LANE_GROUP + lane] = Result[lane];
+					GroupCodeWritten |= GroupAddr[0][lane] < LaneStackBase;
+				}
+	}
+
+	for (int lane = 0; lane < LANE_GROUP; lane++) {
+		long mask = GroupMask[lane];
+		GroupPC[lane] = mask & !branched ? next : GroupPC[lane];
+		GroupClock[lane] += mask * cycles;
+		GroupStatus[lane] = mask && GroupClock[lane] >= LANE_CLOCK_LIMIT ?
+			TimeSliceExpired : GroupStatus[lane];
+	}
+}
+
+/*******************************************************************************
+ * Function: LaneOperand
+ *
+ * Description: Fetches an operand for the lanes in GroupMask, as
+ * FetchOperand does for the CPU. Every address must be in the program or
+ * stack of the lane; a lane with a bad address stops. Direct and immediate
+ * operands come from the word at next, the same address for every lane.
+ *
+ * Input Parameters
+ *      mode				Operand mode
+ *      reg				Operand GPR
+ *      next				Address of the next instruction word
+ *
+ * Output Parameters
+ *      next				Past an operand word
+ *      Value				Operand of each lane
+ *      Addr				Operand address of each lane, for the
+ *      				memory modes
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorInvalidMode		-Every lane is stopped
+ *      ErrorRuntime			-No operand word; every lane is stopped
+ ******************************************************************************/
+
+LANE_TARGETS long LaneOperand(long mode, long reg, long *next, long *Value, long *Addr)
+{
+	long *Reg = GroupGPR[reg], *Word;
+
+	switch (mode) {
+		case 1:         //Register Mode
+			memcpy(Value, Reg, LANE_GROUP * sizeof(long));
+			return OK;
+		case 2:         //Register deferred mode
+		case 3:         //Autoincrement mode
+		case 4:         //Autodecrement mode
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				Reg[lane] -= mode == 4 && GroupMask[lane];
+			memcpy(Addr, Reg, LANE_GROUP * sizeof(long));
+			for (int lane = 0; lane < LANE_GROUP; lane++)
+				Reg[lane] += mode == 3 && GroupMask[lane];
+			break;
+		case 5:         //Direct mode
+		case 6:         //Immediate mode
+			if (*next >= LaneWords) {
+				StopLanes(ErrorRuntime);
+				return ErrorRuntime;
+			}
+			Word = &GroupMem[(*next)++ * LANE_GROUP];
+			if (mode == 6) {
+				memcpy(Value, Word, LANE_GROUP * sizeof(long));
+				return OK;
+			}
+			memcpy(Addr, Word, LANE_GROUP * sizeof(long));
+			break;
+		default:        //Invalid mode
+			StopLanes(ErrorInvalidMode);
+			return ErrorInvalidMode;
+	}
+
+	// Memory modes: stop the lanes with a bad address, load for the others
+	for (int lane = 0; lane < LANE_GROUP; lane++) {
+		long bad = GroupMask[lane] & (Addr[lane] < 0 || Addr[lane] >= LaneWords);
+		GroupStatus[lane] = bad ? ErrorInvalidAddress : GroupStatus[lane];
+		GroupMask[lane] &= !bad;
+	}
+	for (int lane = 0; lane < LANE_GROUP; lane++)
+		if (GroupMask[lane])
+			Value[lane] = GroupMem[Addr[lane] * LANE_GROUP + lane];
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: StopLanes
+ *
+ * Description: Stops the lanes in GroupMask.
+ *
+ * Input Parameters
+ *      status				Final status of the lanes
+ *
+ * Output Parameters
+ *      GroupStatus, GroupMask
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+LANE_TARGETS void StopLanes(long status)
+{
+	for (int lane = 0; lane < LANE_GROUP; lane++) {
+		GroupStatus[lane] = GroupMask[lane] ? status : GroupStatus[lane];
+		GroupMask[lane] = 0;
+	}
+}
+
+/*******************************************************************************
+ * Function: PrintLanes
+ *
+ * Description: Prints the status, clock, PC and GPRs of every lane.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void PrintLanes()
+{
+	for (long lane = 0; lane < LaneCount; lane++) {
+		printf("Lane %ld: status %ld, clock %ld, PC %ld, GPR", lane, LaneStatus[lane],
+				LaneClock[lane], LanePC[lane]);
+		for (int reg = 0; reg < GPR_NUMBER; reg++)
+			printf(" %ld", LaneGPR[lane * GPR_NUMBER + reg]);
+		printf("\n");
+	}
+}
+
+/*******************************************************************************
+ * Function: NativeCPU
+ *
+ * Description: Execution engine running the processes of a translated
+ * image (see TranslateProgram) as host code. The native code returns after
+ * a system call, and on a write to its code segment, so the process is
+ * looked up again: exec may have loaded another image, and a written code
+ * segment drops its native code (see CopyOnWrite). An instruction the
+ * native code did not translate, or one that would fail, runs on CPU.
+ * Processes without native code, and every process outside the segment
+ * model, run on CPU for the whole slice.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Same as CPU
+ ******************************************************************************/
+
+long NativeCPU()
+{
+	struct NativeMachine machine = { mem, gpr, &sp, &pc, &clock,
+		&codebase, &codelimit, &base, &limit, &stackbase, &stacklimit, &psr,
+		0, 0, SystemCall, StoreMemory };
+	long status = OK, TimeLeft = TIMESLICE;
+
+	while (status == OK && TimeLeft > 0) {
+		long (*Run)(struct NativeMachine *machine) = NULL;
+		if (MemoryModel == MMU_SEGMENT)
+			Run = ProcNative[PCBSlot(RunningPCB)];
+		if (Run == NULL && TimeLeft == TIMESLICE)
+			return CPU();
+
+		if (Run != NULL) {
+			machine.TimeLeft = TimeLeft;
+			machine.Executed = 0;
+			status = Run(&machine);
+			InstructionCount += machine.Executed;
+			NativeCount += machine.Executed;
+			TimeLeft = machine.TimeLeft;
+		}
+
+		// One instruction on CPU, which hands back the rest of the slice
+		if (Run == NULL || status == NativeFallback) {
+			HandoverTime = TimeLeft;
+			status = CPU();
+			TimeLeft = HandoverTime;
+			HandoverTime = 0;
+		}
+	}
+	if (status != OK)
+		return status;
+	return TimeSliceExpired;
+}
+
+/*******************************************************************************
+ * Function: LoadNative
+ *
+ * Description: Opens the shared object built from the translation of a
+ * program, named after the object module with ".so" appended. Its copy of
+ * the image must match the module, so a stale build is not run. The
+ * object stays open while the simulator runs, as processes may be running
+ * its code.
+ *
+ * Input Parameters
+ *      filename			Object module of the program
+ *      Image				Words by program address
+ *      size				Words in the image
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Entry point of the native code
+ *      NULL				-Not translated, or out of date
+ ******************************************************************************/
+
+void *LoadNative(char *filename, long *Image, long size)
+{
+	char path[MAX_FILENAME + 8];
+
+	snprintf(path, sizeof(path), "%s%s.so", strchr(filename, '/') ? "" : "./", filename);
+	void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (handle == NULL)
+		return NULL;
+
+	long *version = dlsym(handle, "NativeInterface");
+	long *words = dlsym(handle, "NativeImage");
+	long *count = dlsym(handle, "NativeSize");
+	void *run = dlsym(handle, "NativeRun");
+	if (version == NULL || *version != NATIVE_INTERFACE || words == NULL || count == NULL ||
+			*count != size || memcmp(words, Image, size * sizeof(long)) != 0 || run == NULL) {
+		printf("ERROR: %s does not match %s\n", path, filename);
+		dlclose(handle);
+		return NULL;
+	}
+	return run;
+}
+
+/*******************************************************************************
+ * Function: TranslateProgram
+ *
+ * Description: Translates an object module to a C file defining NativeRun,
+ * for the native engine under the segment model. Every instruction
+ * reachable from the entry point inside the code segment gets a label;
+ * branches with a target in the program become gotos, and a process
+ * enters at its PC through a switch over the labels, as does a return.
+ * Registers, SP, PC and the clock are host locals. Each instruction
+ * checks the time slice first, then every address and the divisor, and
+ * hands itself to CPU (NativeFallback) before changing any state when a
+ * check fails, so CPU raises the error exactly as it would have. Halt,
+ * invalid words and operands CPU would refuse are handed over the same
+ * way. The file also holds the image, checked by LoadNative.
+ *
+ * Input Parameters
+ *      filename			Object module of the program
+ *      output				C file to write
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorFileOpen
+ *      Error from ReadObjectModule
+ ******************************************************************************/
+
+long TranslateProgram(char *filename, char *output)
+{
+	static long Image[MAX_VIRTUAL_MEMORY + 1];
+	static char Relocate[MAX_VIRTUAL_MEMORY + 1];
+	static long Pending[2 * (MAX_VIRTUAL_MEMORY + 1) + 1];	// Two successors per visit
+	static char Start[MAX_VIRTUAL_MEMORY + 1];
+	long size, top = 0;
+
+	long EntryPC = ReadObjectModule(filename, Image, Relocate, &size);
+	if (EntryPC < 0)
+		return EntryPC;
+	long split = CodeSegmentSize(Image, size, EntryPC);
+
+	// Instruction starts inside the code segment, by the rules of CodeSegmentSize
+	memset(Start, 0, size);
+	Pending[top++] = EntryPC;
+	while (top > 0) {
+		long addr = Pending[--top];
+		if (addr < 0 || addr >= split || Start[addr])
+			continue;
+		Start[addr] = 1;
+
+		long word = Image[addr];
+		if (word < 0 || word >= DECODE_WORDS || !DecodeTable[word].Valid)
+			continue;
+		long opcode = DecodeTable[word].Opcode;
+		long next = addr + DecodeTable[word].Length;
+		if (opcode > LAST_OPCODE || next > split)
+			continue;
+		if (DecodeTable[word].Branch)
+			Pending[top++] = Image[next - 1];
+		if (DecodeTable[word].Next)
+			Pending[top++] = next;
+	}
+
+	FILE *out = fopen(output, "w");
+	if (out == NULL) {
+		printf("ERROR: Unable to open file.\n");
+		return ErrorFileOpen;
+	}
+
+	fprintf(out, "/* %s translated by simulator -t. Build it beside the module:\n"
+			" *     cc -O2 -shared -fPIC -o %s.so %s\n */\n\n",
+			filename, filename, output);
+	fprintf(out, "struct NativeMachine {\n"
+			"\tlong *mem, *gpr, *sp, *pc, *clock;\n"
+			"\tlong *codebase, *codelimit, *base, *limit, *stackbase, *stacklimit, *psr;\n"
+			"\tlong TimeLeft, Executed;\n"
+			"\tlong (*SystemCall)(long SystemCallID);\n"
+			"\tlong (*StoreMemory)(long addr, long value);\n"
+			"};\n\n");
+	fprintf(out, "#define OK\t\t\t%d\n#define HALTED\t\t\t%d\n#define ErrorNoFreeMemory\t%d\n"
+			"#define ErrorPageFault\t\t%d\n#define TimeSliceExpired\t%d\n"
+			"#define NativeFallback\t\t%d\n"
+			"#define PSR_ZERO\t\t%d\n#define PSR_NEGATIVE\t\t%d\n",
+			OK, SIMULATOR_STATUS_HALTED, ErrorNoFreeMemory, ErrorPageFault,
+			TimeSliceExpired, NativeFallback, PSR_ZERO, PSR_NEGATIVE);
+	fprintf(out, "#define SPLIT\t\t\t%ld\n#define LIMIT\t\t\t%ld\n\n", split, size);
+	fprintf(out, "#define FALLBACK(a)\tdo { pc = (a); status = NativeFallback; goto leave; } while (0)\n"
+			"#define EXPIRE(a)\tdo { pc = (a); status = TimeSliceExpired; goto leave; } while (0)\n"
+			"#define RESUME(a)\tdo { pc = (a); status = OK; goto leave; } while (0)\n"
+			"#define TICK(c)\t\tdo { clock += (c); left -= (c); } while (0)\n"
+			"#define STORE(p, v, next) do { \\\n"
+			"\twrote = (p) >= cb && (p) < cb + SPLIT; \\\n"
+			"\tif (m->StoreMemory(p, v) != OK) { \\\n"
+			"\t\tpc = (next); status = ErrorNoFreeMemory; goto leave; \\\n"
+			"\t} \\\n"
+			"\tcb = *m->codebase; b = *m->base; \\\n"
+			"} while (0)\n\n");
+
+	fprintf(out, "long NativeInterface = %d;\nlong NativeSize = %ld;\nlong NativeImage[] = {",
+			NATIVE_INTERFACE, size);
+	for (long addr = 0; addr < size; addr++)
+		fprintf(out, "%s%ld,", addr % 8 ? " " : "\n\t", Image[addr]);
+	fprintf(out, "\n};\n\n");
+
+	fprintf(out, "static inline long Xlate(long x, long cb, long b)\n{\n"
+			"\tif (x >= 0 && x < SPLIT)\n\t\treturn cb + x;\n"
+			"\tif (x >= 0 && x < LIMIT)\n\t\treturn b + x;\n"
+			"\tif (x > %d && x <= %d)\n\t\treturn x;\n"
+			"\treturn -1;\n}\n\n", MAX_USER_MEMORY, MAX_HEAP_MEMORY);
+
+	fprintf(out, "long NativeRun(struct NativeMachine *m)\n{\n\tlong *mem = m->mem;\n");
+	for (int reg = 0; reg < GPR_NUMBER; reg++)
+		fprintf(out, "\tlong G%d = m->gpr[%d];\n", reg, reg);
+	fprintf(out, "\tlong sp = *m->sp, pc = *m->pc, clock = *m->clock, psr = *m->psr;\n"
+			"\tlong cb = *m->codebase, b = *m->base;\n"
+			"\tlong stackbase = *m->stackbase, stacklimit = *m->stacklimit;\n"
+			"\tlong left = m->TimeLeft, count = 0, status = OK;\n"
+			"\tlong p0 = 0, p1 = 0, r = 0;\n\tint wrote = 0;\n\n"
+			"\tif (*m->limit != LIMIT || *m->codelimit != SPLIT)\n"
+			"\t\tFALLBACK(pc);\n"
+			"dispatch:\n\tswitch (pc) {\n");
+	for (long addr = 0; addr < size; addr++)
+		if (Start[addr])
+			fprintf(out, "\t\tcase %ld: goto L%ld;\n", addr, addr);
+	fprintf(out, "\t\tdefault: FALLBACK(pc);\n\t}\n\n");
+
+	for (long addr = 0; addr < size; addr++)
+		if (Start[addr])
+			TranslateInstruction(out, Image, Start, addr, size, split);
+
+	fprintf(out, "leave:\n");
+	for (int reg = 0; reg < GPR_NUMBER; reg++)
+		fprintf(out, "\tm->gpr[%d] = G%d;\n", reg, reg);
+	fprintf(out, "\t*m->sp = sp;\n\t*m->pc = pc;\n\t*m->clock = clock;\n\t*m->psr = psr;\n"
+			"\tm->TimeLeft = left;\n\tm->Executed = count;\n\treturn status;\n}\n");
+	fclose(out);
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: TranslateInstruction
+ *
+ * Description: Writes the C of one instruction for TranslateProgram, in
+ * the order CPU runs it: address and value checks, which hand the
+ * instruction to CPU when they fail, then the autoincrements and
+ * autodecrements, the result and its store. A store to the code segment
+ * ends the native code after the instruction, as the segment no longer
+ * matches the translation. A system call saves the machine state around
+ * SystemCall and returns.
+ *
+ * Input Parameters
+ *      out				C file being written
+ *      Image				Words by program address
+ *      Start				Instruction starts given a label
+ *      addr				Address of the instruction
+ *      size				Words in the image
+ *      split				Words in the code segment
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void TranslateInstruction(FILE *out, long *Image, char *Start, long addr, long size, long split)
+{
+	static const char *Operator[] = { "", "+", "-", "*", "/" };
+	static const long Cycles[] = { 0, 3, 3, 6, 6, 2, 2, 4, 4, 4, 2, 2, 12, 0, 0, 0,
+		4, 2, 3, 4, 4, 4, 4, 4, 4 };
+	static const char *Condition[] = { "", "", "", "", "", "", "", "r < 0", "r > 0", "r == 0",
+		"", "", "", "", "", "", "", "", "", "psr & PSR_ZERO", "!(psr & PSR_ZERO)",
+		"psr & PSR_NEGATIVE", "psr & (PSR_ZERO | PSR_NEGATIVE)",
+		"!(psr & (PSR_ZERO | PSR_NEGATIVE))", "!(psr & PSR_NEGATIVE)" };
+	char check[2][96], value[2][32];
+	long word = Image[addr];
+
+	fprintf(out, "L%ld:\tif (left <= 0)\n\t\tEXPIRE(%ld);\n", addr, addr);
+	if (word < 0 || word >= DECODE_WORDS || !DecodeTable[word].Valid) {
+		fprintf(out, "\tFALLBACK(%ld);\n", addr);
+		return;
+	}
+
+	struct DecodedWord decoded = DecodeTable[word];
+	long opcode = decoded.Opcode;
+	long mode[2] = { decoded.Op1Mode, decoded.Op2Mode };
+	long reg[2] = { decoded.Op1GPR, decoded.Op2GPR };
+	long next = addr + decoded.Length, operand = addr + 1;
+	int operands = (opcode >= 1 && opcode <= 5) || opcode == 18 || opcode == 25 ||
+		opcode == 26 ? 2 : opcode == 6 || opcode == 11 || opcode > 12 ? 0 : 1;
+	int translated = ((opcode >= 1 && opcode <= 12) || (opcode >= 16 && opcode <= 24)) &&
+		next <= split;
+
+	// Operands in fetch order; the destination of pop is fetched on its own
+	for (int n = 0; n < operands && translated; n++) {
+		translated = TranslateOperand(addr, n, mode[n], reg[n], Image[operand],
+				size, split, check[n], value[n]);
+		if (mode[n] == 5 || mode[n] == 6)
+			operand++;
+	}
+	if (opcode == 11 && mode[0] != 0 && translated)
+		translated = TranslateOperand(addr, 0, mode[0], reg[0], Image[operand],
+				size, split, check[0], value[0]);
+
+	// CPU refuses an immediate destination, and an autoincrement or
+	// autodecrement moving the register of the second operand is left to it
+	int destination = (opcode >= 1 && opcode <= 5) || (opcode == 11 && mode[0] != 0);
+	if (destination && mode[0] == 6)
+		translated = 0;
+	if (operands == 2 && (mode[0] == 3 || mode[0] == 4) && mode[1] >= 1 && mode[1] <= 4 &&
+			reg[0] == reg[1])
+		translated = 0;
+	if (!translated) {
+		fprintf(out, "\tFALLBACK(%ld);\n", addr);
+		return;
+	}
+
+	// Checks
+	if (opcode == 11)
+		fprintf(out, "\tif (sp < stackbase)\n\t\tFALLBACK(%ld);\n", addr);
+	if (operands >= 1 || (opcode == 11 && mode[0] != 0))
+		fprintf(out, "%s", check[0]);
+	if (operands == 2)
+		fprintf(out, "%s", check[1]);
+	if (opcode == 4)
+		fprintf(out, "\tif (%s == 0)\n\t\tFALLBACK(%ld);\n", value[1], addr);
+	if (opcode == 10 || opcode == 16)
+		fprintf(out, "\tif (sp >= stacklimit)\n\t\tFALLBACK(%ld);\n", addr);
+	if (opcode == 17)
+		fprintf(out, "\tif (sp < stackbase)\n\t\tFALLBACK(%ld);\n", addr);
+	fprintf(out, "\tcount++;\n");
+
+	// Result, from the operands as fetched
+	if (opcode >= 1 && opcode <= 4)
+		fprintf(out, "\tr = %s %s %s;\n", value[0], Operator[opcode], value[1]);
+	else if (opcode == 5)
+		fprintf(out, "\tr = %s;\n", value[1]);
+	else if (opcode == 11)
+		fprintf(out, "\tr = mem[sp];\n");
+	else if (opcode == 18)
+		fprintf(out, "\tpsr = (psr & ~(PSR_ZERO | PSR_NEGATIVE)) | (%s == %s ? PSR_ZERO : 0)"
+				" | (%s < %s ? PSR_NEGATIVE : 0);\n", value[0], value[1], value[0], value[1]);
+	else if (operands == 1)
+		fprintf(out, "\tr = %s;\n", value[0]);
+
+	// Autoincrements and autodecrements
+	for (int n = 0; n < 2; n++) {
+		if (n >= operands && !(n == 0 && opcode == 11))
+			continue;
+		if (mode[n] == 3)
+			fprintf(out, "\tG%ld++;\n", reg[n]);
+		else if (mode[n] == 4)
+			fprintf(out, "\tG%ld--;\n", reg[n]);
+	}
+
+	// Effect
+	if (destination && mode[0] == 1)
+		fprintf(out, "\tG%ld = r;\n", reg[0]);
+	else if (destination)
+		fprintf(out, "\tSTORE(p0, r, %ld);\n", next);
+	if (opcode == 10)
+		fprintf(out, "\tmem[++sp] = r;\n");
+	else if (opcode == 11)
+		fprintf(out, "\tsp--;\n");
+	else if (opcode == 16)
+		fprintf(out, "\tmem[++sp] = %ld;\n", next);
+	else if (opcode == 17)
+		fprintf(out, "\tpc = mem[sp--];\n");
+
+	if (opcode == 12) {
+		for (int reg = 0; reg < GPR_NUMBER; reg++)
+			fprintf(out, "\tm->gpr[%d] = G%d;\n", reg, reg);
+		fprintf(out, "\t*m->sp = sp;\n\t*m->pc = %ld;\n\t*m->clock = clock;\n\t*m->psr = psr;\n"
+				"\tstatus = m->SystemCall(r);\n", next);
+		for (int reg = 0; reg < GPR_NUMBER; reg++)
+			fprintf(out, "\tG%d = m->gpr[%d];\n", reg, reg);
+		fprintf(out, "\tsp = *m->sp;\n\tpc = *m->pc;\n\tclock = *m->clock;\n\tpsr = *m->psr;\n"
+				"\tTICK(12);\n"
+				"\tif (status < HALTED && status != ErrorPageFault)\n"
+				"\t\tstatus = OK;\n"
+				"\tgoto leave;\n");
+		return;
+	}
+	fprintf(out, "\tTICK(%ld);\n", Cycles[opcode]);
+
+	// A store to the code segment stops the translation
+	if (destination && mode[0] == 5 && Image[addr + 1] >= 0 && Image[addr + 1] < split) {
+		fprintf(out, "\tRESUME(%ld);\n", next);
+		return;
+	}
+	if (destination && mode[0] >= 2 && mode[0] <= 4)
+		fprintf(out, "\tif (wrote)\n\t\tRESUME(%ld);\n", next);
+
+	// Next instruction; a return goes through the switch over the labels
+	long target = Image[next - 1];
+	if (opcode == 17) {
+		fprintf(out, "\tgoto dispatch;\n");
+		return;
+	}
+	if (decoded.Branch) {
+		if (opcode != 6 && opcode != 16)
+			fprintf(out, "\tif (%s)\n\t", Condition[opcode]);
+		if (target >= 0 && target < size && Start[target])
+			fprintf(out, "\tgoto L%ld;\n", target);
+		else
+			fprintf(out, "\tFALLBACK(%ld);\n", target);
+	}
+	if (decoded.Next && opcode != 16) {
+		if (next < size && Start[next])
+			fprintf(out, "\tgoto L%ld;\n", next);
+		else
+			fprintf(out, "\tFALLBACK(%ld);\n", next);
+	}
+}
+
+/*******************************************************************************
+ * Function: TranslateOperand
+ *
+ * Description: Gives the C checking an operand for TranslateInstruction
+ * and the expression of its value. A memory operand puts its physical
+ * address in p0 or p1; an address outside the program and the heap hands
+ * the instruction to CPU. Direct addresses are relocated at translation.
+ *
+ * Input Parameters
+ *      addr				Address of the instruction
+ *      n				0 for the first operand, 1 for the second
+ *      mode, reg			Mode and GPR of the operand
+ *      word				Word following the instruction for it
+ *      size				Words in the image
+ *      split				Words in the code segment
+ *
+ * Output Parameters
+ *      check				C run before the instruction changes state
+ *      value				C expression of the operand value
+ *
+ * Function Return Value
+ *      1				-Translated
+ *      0				-Left to CPU
+ ******************************************************************************/
+
+int TranslateOperand(long addr, int n, long mode, long reg, long word, long size, long split,
+		char *check, char *value)
+{
+	check[0] = '\0';
+	sprintf(value, "mem[p%d]", n);
+	switch (mode) {
+		case 1:
+			sprintf(value, "G%ld", reg);
+			return 1;
+		case 2:
+		case 3:
+			sprintf(check, "\tp%d = Xlate(G%ld, cb, b);\n\tif (p%d < 0)\n\t\tFALLBACK(%ld);\n",
+					n, reg, n, addr);
+			return 1;
+		case 4:
+			sprintf(check, "\tp%d = Xlate(G%ld - 1, cb, b);\n\tif (p%d < 0)\n\t\tFALLBACK(%ld);\n",
+					n, reg, n, addr);
+			return 1;
+		case 5:
+			if (word >= 0 && word < size)
+				sprintf(check, "\tp%d = %s + %ld;\n", n, word < split ? "cb" : "b", word);
+			else if (word > MAX_USER_MEMORY && word <= MAX_HEAP_MEMORY)
+				sprintf(check, "\tp%d = %ld;\n", n, word);
+			else
+				return 0;
+			return 1;
+		case 6:
+			sprintf(value, "%ldL", word);
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+/*******************************************************************************
+ * Function: SystemCall
+ *
+ * Description: Processes SystemCall Instructions
+ *
+ * Input Parameters
+ *      OpValue
+ *
+ * Output Parameters
+ *
+ *
+ * Function Return Value
+ *      OK				-Successful Fetch
+ *      ErrorInvalidAddress		-Oprand address not valid
+ *      ErrorInvalidMode		-Mode not correct
+ *      ErrorInvalidPCValue		-Direct Mode PC out of bounds
+ *
+ * Initial Implementation done by Ykaro Rocha
+ ******************************************************************************/
+
+long SystemCall(long SystemCallID)
+{
+	psr = (psr & PSR_FLAGS) | MACHINE_MODE_OS;	// Set system mode to OS mode
+	if (VerboseMode)
+		printf("MACHINE STATUS SET >>> OS");
+
+	long status = OK;
+
+	SystemCallCount++;
+	SystemCallsByID[SystemCallID >= 1 && SystemCallID <= MAX_SYSTEM_CALL ? SystemCallID : 0]++;
+	switch (SystemCallID) {
+		case 1:                 //process_create
+			// Fork: the child continues here with GPR1 = 0
+			status = ProcessCreateSystemCall();
+			break;
+		case 2:                 //process_delete
+			// Exit with the status in GPR1
+			status = ProcessDeleteSystemCall();
+			break;
+		case 3:                 //process_inquiry
+			// Wait for a child to terminate
+			status = ProcessInquirySystemCall();
+			break;
+		case 4:                 //mem_alloc
+			//Dynamic memory allocation: Allocate user free memory system call
+			status = MemAllocSystemCall();
+			break;
+		case 5:                 //mem_free
+			// Free dynamically allocated user memory system call
+			status = MemFreeSystemCall();
+			break;
+		case 6:                 //msg_send
+			status = MsgSendSystemCall();
+			break;
+		case 7:                 //msg_recieve
+			status = MsgReceiveSystemCall();
+			break;
+		case 8:                 //io_getc
+			status = IOGetCSystemCall();
+			break;
+		case 9:                 //io_putc
+			status = IOPutCSystemCall();
+			break;
+		case 10:                //time_get
+			status = TimeGetSystemCall();
+			break;
+		case 11:                //time_set
+			status = TimeSetSystemCall();
+			break;
+		case 12:                //process_exec
+			status = ProcessExecSystemCall();
+			break;
+		case 13:                //sleep
+			status = SleepSystemCall();
+			break;
+		case 14:                //timer_set
+			// Periodic timer for a real-time task
+			status = TimerSetSystemCall();
+			break;
+		case 15:                //timer_wait
+			status = TimerWaitSystemCall();
+			break;
+		case 16:                //io_read
+			// A line into a buffer, one request
+			status = IOReadSystemCall();
+			break;
+		case 17:                //io_write
+			status = IOWriteSystemCall();
+			break;
+		case 18:                //disk_read
+			// Queued; the disk interrupt wakes the process
+			status = DiskRequestSystemCall(0);
+			break;
+		case 19:                //disk_write
+			status = DiskRequestSystemCall(1);
+			break;
+		case 20:                //mmap
+			// A file region into a heap block
+			status = MmapSystemCall();
+			break;
+		case 21:                //munmap
+			status = MunmapSystemCall();
+			break;
+		default:
+			printf("Invalid system call ID");
+			break;
+	}
+	psr = (psr & PSR_FLAGS) | MACHINE_MODE_USER;	// Restore to User Mode
+	return status;
+}
+
+/*******************************************************************************
+ * Function: FetchOperand
+ *
+ * Description: Depending on the Addressing Mode, function checks if address
+ * refered to by the instruction is in valid memory space and performs actions
+ * on the instruction. The result is returned.
+ * The result is intended to define the status of the machine (psr).
+ * Addresses are translated by the memory-protection unit, OpAddress is the
+ * physical address.
+ *
+ * Input Parameters
+ *      OpMode				Operand Mode Value
+ *      OpReg				Operand GPR Value
+ *
+ * Output Parameters
+ *      OpAddress			Address of Operand
+ *      OpValue				Value of Operand when GPR and mode are valid
+ *
+ * Function Return Value
+ *      OK				-Successful Fetch
+ *      ErrorInvalidAddress		-Oprand address not valid
+ *      ErrorInvalidMode		-Mode not correct
+ *      ErrorInvalidPCValue		-Direct Mode PC out of bounds
+ ******************************************************************************/
+
+long FetchOperand(
+		long OpMode,
+		long OpReg,
+		long *OpAddress,
+		long *OpValue)
+{
+	//Fetch value based on value based on the operand mode
+	switch (OpMode) {
+		case 1:         //Register Mode
+			*OpAddress = -1;         //Set to Invalid Address
+			*OpValue = gpr[OpReg];
+			break;
+		case 2:         //Register deferred mode
+			*OpAddress = Translate(gpr[OpReg]);         //Grab OPAddress from Register
+
+			if (*OpAddress >= 0) {
+				*OpValue = mem[*OpAddress];         //Grab OpValue in Mem
+			}
+			else if (*OpAddress == ErrorPageFault)
+				return ErrorPageFault;
+			else {
+				printf("ERROR: Invalid Fetch Operand Address\n");
+				return ErrorInvalidAddress;
+			}
+
+			break;
+		case 3:         //Autoincrement mode -> ADDR in GPR, OPVAL in MEM
+			*OpAddress = Translate(gpr[OpReg]);                //Op Address is in Register
+
+			if (*OpAddress >= 0) {
+				*OpValue = mem[*OpAddress];         //Grab OpValue in Mem
+			}
+			else if (*OpAddress == ErrorPageFault)
+				return ErrorPageFault;
+			else {
+				printf("ERROR: Invalid Fetch Operand Address\n");
+				return ErrorInvalidAddress;
+			}
+			gpr[OpReg]++;
+
+			break;
+		case 4:         //Autodecrement mode
+			--gpr[OpReg];
+			*OpAddress = Translate(gpr[OpReg]);
+			if (*OpAddress >= 0) {
+				*OpValue = mem[*OpAddress];         //Grab OpValue in Mem
+			}
+			else if (*OpAddress == ErrorPageFault)
+				return ErrorPageFault;
+			else {
+				printf("ERROR: Invalid Fetch Operand Address\n");
+				return ErrorInvalidAddress;
+			}
+
+			break;
+		case 5:         //Direct mode -> OP Address is mem[pc]
+
+			if ((*OpAddress = Translate(pc)) == ErrorPageFault)
+				return ErrorPageFault;
+			else if (*OpAddress < 0) {
+				printf("ERROR: Invalid PC Address at Runtime\n");
+				return ErrorRuntime;
+			}
+			pc++;
+			*OpAddress = Translate(mem[*OpAddress]);
+			if (*OpAddress >= 0) {
+				*OpValue = mem[*OpAddress];
+			}
+			else if (*OpAddress == ErrorPageFault)
+				return ErrorPageFault;
+			else {
+				printf("ERROR: Invalid Address\n");
+				return ErrorInvalidAddress;
+			}
+
+			break;
+		case 6:         //Immediate mode -> Opvalue in Instruction
+			if ((*OpAddress = Translate(pc)) == ErrorPageFault)
+				return ErrorPageFault;
+			else if (*OpAddress < 0) {
+				printf("ERROR: Invalid PC Address at Runtime\n");
+				return ErrorRuntime;
+			}
+			pc++;
+			*OpValue = mem[*OpAddress];
+			*OpAddress = -1;                        //Set to Invalid Address
+
+			break;
+		default:        //Invalid mode
+			printf("ERROR: Invalid mode at line %d\n", mbr);
+			return ErrorInvalidMode;
+	}
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: DumpMemory
+ *
+ * Description: Displays the current state of all GeneralPurposeRegisters(GPR),
+ * the StackPointer (SP), ProgramCounter(PC), ProcessorStatusRegister(PSR),
+ * system Clock, and a dump of the system memory up-to a given memory address.
+ *
+ * Input Parameters
+ *      String			String header displayed above Status Table
+ *      StartAddress			Memory location from which to begin dump
+ *      Size				Offset from StartAddress
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void DumpMemory(
+		char* String,
+		long StartAddress,
+		long size)
+{
+	/* Print String Header */
+	printf("%s\n", String);
+
+	/* Returns Error */
+	if (StartAddress + size > SYSTEM_MEMORY_SIZE || StartAddress < 0) {
+		printf("ERROR: Invalid Dump-Memory Range\n");
+		return;
+	}
+
+	/* PCBs in the range get their scheduler fields from the process table */
+	for (long slot = 0; slot < MAX_PROCESSES; slot++)
+		if (ProcPCB[slot] != EndOfList && ProcPCB[slot] + PCBsize > StartAddress &&
+				ProcPCB[slot] < StartAddress + size)
+			SyncPCB(ProcPCB[slot]);
+
+	/* Print Register Table Header + Status */
+	for (int register_number = 0; register_number < GPR_NUMBER; register_number++)
+		printf("\tG%d", register_number);
+	printf("\tSP\tPC\n");
+
+	for (int register_number = 0; register_number < GPR_NUMBER; register_number++)
+		printf("\t%d", gpr[register_number]);
+	printf("\t%d\t%d\n", sp, pc);
+
+	/* Memory Table Header */
+	printf("Address");
+	for (int num = 0; num < 10; num++)
+		printf("\t+%d", num);
+	printf("\n");
+
+	/* Operational Variables */
+	long addr = (StartAddress / 10) * 10; //Rounds down to Nearest 10 (Integer Math)
+	long endAddress = StartAddress + size;
+
+	/* Dump Memory */
+	while (addr < endAddress) {
+		printf("%d\t", addr);
+		for (int i = 0; i < 10; i++)
+			printf("%d\t", mem[addr + i]);
+		printf("\n");
+		addr += 10;
+	}
+	printf("System-Clock >> %d\n", clock);
+	printf("Processor Status Register (PSR) >> %d\n", psr);
+}
+
+/*******************************************************************************
+ * Function: CreateProcess
+ *
+ * Description: Creates a PCB in Dyanamic Memory and populates the PCB indecies
+ * with the values.
+ *
+ * Input Parameters
+ *      String (pointer)		Name of the file associated with the process
+ * 	Long				An interger value defining priority
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ * 	OK
+ * 	ErrorInvalidAddress
+ *
+ * Initial Implementation done by Ykaro Rocha
+ ******************************************************************************/
+long CreateProcess(char* filename, long priority)
+{
+	// Note to Professor: Team believed that CreateProcess was not to be implemented
+	// This section was originally written but commented out and bugs appeared.
+	// Now this section is implemented again.
+
+	// Allocate space for Process Control Block
+	long PCBptr = AllocatePCB();
+
+	//Check for Error
+	if (PCBptr < 0){
+		printf("ERROR: Could not allocate memory");
+		return(ErrorInvalidAddress);
+	}
+
+
+	// Initialize PCB: Set nextPCBlink to end of list, default priority, Ready state, and PID
+	InitializePCB(PCBptr);
+
+	// Load the program
+	long EntryPC = AbsoluteLoader(filename, PCBptr);
+	if (EntryPC >= 0)
+		mem[PCBptr + PCB_PC] = EntryPC; 	// Store PC value in the PCB of the process
+	else {
+		FreePCB(&PCBptr);
+		return ErrorFileOpen;
+	}
+
+	// Allocate stack space from user free list
+	long StackPtr = AllocateUserMemory(DEFAULT_STACK_SIZE);
+	if (StackPtr < 0)			// Check for error
+	{  				// User memory allocation failed
+		ReleaseProgram(PCBptr);
+		FreePCB(&PCBptr);
+		return(ErrorInvalidMemorySize);  		// return error code
+	}
+
+	// Store stack information in the PCB . SP, ptr, and size
+	mem[PCBptr + PCB_SP] = StackPtr - 1;		// empty stack, push increments SP first
+	mem[PCBptr + PCB_StackStartAddr] = StackPtr;
+	mem[PCBptr + PCB_StackSize] = DEFAULT_STACK_SIZE;
+	ProcPriority[PCBSlot(PCBptr)] = priority;	// Set priority
+
+	if (VerboseMode) {
+		DumpMemory("PCB Created", PCBptr, PCBsize);				// Dump PCB stack
+		PrintPCB(PCBptr);
+	}
+
+	// Insert PCB into Ready Queue according to the scheduling algorithm
+	InsertIntoRQ(&PCBptr);
+
+	return(OK);
+}
+/*******************************************************************************
+ * Function: TerminateProcess
+ *
+ * Description: Deallocates the reference of the PCB from the lists in Dynamic
+ * Memory and OS Memory
+ * The exit status goes to the parent: a parent waiting for this child is
+ * woken with it, a live parent that has not waited yet finds the PCB in
+ * ZombieQ, and the PCB is freed otherwise. Zombie children of the process
+ * are freed with it.
+ *
+ * Input Parameters
+ * 	- PCBptr			Address of the PCB that is to be deallocated
+ *
+ * Output Parameters
+ * 	- None
+ *
+ * Function Return Value
+ * 	- None
+ *
+ * Initial Implementation done by Ykaro Rocha
+ ******************************************************************************/
+
+void TerminateProcess(long PCBptr)
+{
+	// Segments may have moved since a save left to the Dispatcher
+	if (PCBptr == ContextPCB)
+		SaveContext(PCBptr);
+
+	// Return stack memory using stack start address and stack size in the given PCB
+	FreeUserMemory(mem[PCBptr + PCB_StackStartAddr], mem[PCBptr + PCB_StackSize]);
+
+	// Return the program segments
+	ReleaseProgram(PCBptr);
+
+	// Timers die with the process
+	if (mem[PCBptr + PCB_SleepTimer] != EndOfList)
+		StopTimer(mem[PCBptr + PCB_SleepTimer]);
+	if (mem[PCBptr + PCB_PeriodTimer] != EndOfList)
+		StopTimer(mem[PCBptr + PCB_PeriodTimer]);
+
+	// Queued disk requests are dropped, mapped files written back
+	CancelDiskRequests(PCBptr);
+	for (long entry = 0; entry < MAX_MAPPINGS; entry++)
+		if (MapFile[entry] >= 0 && MapOwner[entry] == PCBptr)
+			UnmapFile(entry);
+
+	// Messages left in the mailbox are dropped
+	long Mailbox = mem[PCBptr + PCB_Mailbox];
+	if (Mailbox != EndOfList)
+		FreeOSMemory(&Mailbox, MAILBOX_SIZE);
+
+	// Children that terminated are never waited for now
+	long pid = ProcPid[PCBSlot(PCBptr)];
+	long ZombiePtr;
+	while ((ZombiePtr = FindChild(ZombieQ, pid, 0)) != EndOfList) {
+		RemoveFromQueue(&ZombieQ, ZombiePtr);
+		FreePCB(&ZombiePtr);
+	}
+
+	// Report the exit status to the parent
+	long parent = mem[PCBptr + PCB_Parent];
+	long ParentPtr = FindPCB(WQ, parent);
+	if (parent != 0 && ParentPtr != EndOfList &&
+			ProcReason[PCBSlot(ParentPtr)] == ChildTermination &&
+			(mem[ParentPtr + PCB_GPR1] == 0 || mem[ParentPtr + PCB_GPR1] == pid)) {
+		SearchAndRemovePCBfromWQ(parent);
+		mem[ParentPtr + PCB_GPR0] = OK;
+		mem[ParentPtr + PCB_GPR1] = pid;
+		mem[ParentPtr + PCB_GPR2] = mem[PCBptr + PCB_ExitStatus];
+		ProcState[PCBSlot(ParentPtr)] = Ready;
+		InsertIntoRQ(&ParentPtr);
+	}
+	else if (parent != 0 && (ParentPtr != EndOfList || FindPCB(RQ, parent) != EndOfList)) {
+		SetNextPCB(PCBptr, ZombieQ);
+		ZombieQ = PCBptr;
+		return;
+	}
+
+	// Return PCB memory using the PCBptr
+	FreePCB(&PCBptr);			// Free Process from PCB Stack
+
+	return;
+
+} //End of TerminateProcess function
+
+/*******************************************************************************
+ * Function: AllocateOSMemory
+ *
+ * Description: Displays the current state of all GeneralPurposeRegisters(GPR),
+ * the StackPointer (SP), ProgramCounter(PC), ProcessorStatusRegister(PSR),
+ * system Clock, and a dump of the system memory up-to a given memory address.
+ *
+ * Input Parameters
+ *      String			String header displayed above Status Table
+ *      StartAddress			Memory location from which to begin dump
+ *      Size				Offset from StartAddress
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ *
+ * Initial Implementation done by Ykaro Rocha
+ ******************************************************************************/
+
+long AllocateOSMemory(long RequestedSize)  // return value contains address or error
+{
+	// Allocate memory from OS free space, which is organized as link
+	if (OSFreeList == EndOfList)
+	{
+		printf("ERROR: No Free OS Memory");
+		return(ErrorNoFreeMemory);   // ErrorNoFreeMemory is constant set to < 0
+	}
+	if (RequestedSize < 0)
+	{
+		printf("ERROR: Invalide Memory Size");
+		return(ErrorInvalidMemorySize);  // ErrorInvalidMemorySize is constant < 0
+	}
+	if (RequestedSize == 1)
+		RequestedSize = 2;  // Minimum allocated memory is 2 locations
+
+	long CurrentPtr = OSFreeList;
+	long PreviousPtr = EndOfList;
+	while (CurrentPtr != EndOfList)
+	{
+		// Check each block in the link list until block with requested memory size is found
+		if (mem[CurrentPtr + 1] == RequestedSize)
+		{  // Found block with requested size.  Adjust pointers
+			if (CurrentPtr == OSFreeList)  // first block
+			{
+				OSFreeList = mem[CurrentPtr];  // first entry is pointer to next block
+				mem[CurrentPtr] = EndOfList;  // reset next pointer in the allocated block
+				return(CurrentPtr);	// return memory address
+			}
+			else  // not first black
+			{
+				mem[PreviousPtr] = mem[CurrentPtr];  // point to next block
+				mem[CurrentPtr] = EndOfList;  // reset next pointer in the allocated block
+				return(CurrentPtr);    // return memory address
+			}
+		}
+		else if (mem[CurrentPtr + 1] > RequestedSize)
+		{  // Found block with size greater than requested size
+			if (CurrentPtr == OSFreeList)  // first block
+			{
+				mem[CurrentPtr + RequestedSize] = mem[CurrentPtr];  // move next block ptr
+				mem[CurrentPtr + RequestedSize + 1] = mem[CurrentPtr + 1] - RequestedSize;
+				OSFreeList = CurrentPtr + RequestedSize;  // address of reduced block
+				mem[CurrentPtr] = EndOfList;  // reset next pointer in the allocated block
+				return(CurrentPtr);	// return memory address
+			}
+			else  // not first black
+			{
+				mem[CurrentPtr + RequestedSize] = mem[CurrentPtr];  // move next block ptr
+				mem[CurrentPtr + RequestedSize + 1] = mem[CurrentPtr + 1] - RequestedSize;
+				mem[PreviousPtr] = CurrentPtr + RequestedSize;  // address of reduced block
+				mem[CurrentPtr] = EndOfList;  // reset next pointer in the allocated block
+				return(CurrentPtr);	// return memory address
+			}
+		}
+		else  // small block
+		{  // look at next block
+			PreviousPtr = CurrentPtr;
+			CurrentPtr = mem[CurrentPtr];
+		}
+	} // end of while CurrentPtr loop
+
+	printf("ERROR: No Free OS Memory");
+	return(ErrorNoFreeMemory);   // ErrorNoFreeMemory is constant set to < 0
+}
+
+
+/*******************************************************************************
+ * Function: FreeOSMemory
+ *
+ * Description: Sets the allocated free list to a new value such that the
+ * system expands the block of memory in free list. The memory that is no
+ * longer allocated is considered to be free memory
+ *
+ * Input Parameters
+ * 	- *ptr			A ptr to the block of memory considered 'free'
+ * 				by the system
+ * 	- size			Size by which to increase the free list
+ *
+ * Output Parameters
+ * 	- None
+ *
+ * Function Return Value
+ * 	- OK
+ * 	- ErrorInvalidAddress
+ ******************************************************************************/
+
+long FreeOSMemory(long *ptr, long size)
+{
+	if (*ptr <= MAX_HEAP_MEMORY || *ptr > MAX_OS_MEMORY)
+	{
+		printf("ERROR: Invalid Adress");
+		return(ErrorInvalidAddress);
+	}
+
+	if (size == 1)
+	{
+		size = 2; //minimum allocated size
+	}
+
+	else if (size < 1 || (*ptr + size) >= MAX_OS_MEMORY)
+	{
+		//invalid size
+		printf("ERROR: Invalid size or Invalid Address");
+		return(ErrorInvalidAddress);
+	}
+
+	mem[*ptr] = OSFreeList;
+	mem[*ptr + 1] = size;
+	OSFreeList = *ptr;
+
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: AllocatePCB
+ *
+ * Description: Allocates a PCB in OS memory and gives it a process slot.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Address of the PCB
+ *      ErrorNoFreeMemory		-No free OS memory or process slot
+ ******************************************************************************/
+
+long AllocatePCB()
+{
+	if (ProcFreeList == EndOfList) {
+		printf("ERROR: Process table full\n");
+		return ErrorNoFreeMemory;
+	}
+	long PCBptr = AllocateOSMemory(PCBsize);
+	if (PCBptr < 0)
+		return ErrorNoFreeMemory;
+
+	long slot = ProcFreeList;
+	ProcFreeList = ProcNext[slot];
+	ProcPCB[slot] = PCBptr;
+	ProcNative[slot] = NULL;
+	ProcSlot[PCBptr - MAX_HEAP_MEMORY - 1] = slot;
+	return PCBptr;
+}
+
+/*******************************************************************************
+ * Function: FreePCB
+ *
+ * Description: Returns a PCB to OS memory and its process slot to the
+ * process table.
+ *
+ * Input Parameters
+ *      PCBptr				PCB to free
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorInvalidAddress
+ ******************************************************************************/
+
+long FreePCB(long *PCBptr)
+{
+	long slot = PCBSlot(*PCBptr);
+
+	ProcPCB[slot] = EndOfList;
+	ProcNext[slot] = ProcFreeList;
+	ProcFreeList = slot;
+	return FreeOSMemory(PCBptr, PCBsize);
+}
+
+/*******************************************************************************
+ * Function: PCBSlot
+ *
+ * Description: Finds the process slot holding the scheduler fields of a PCB.
+ *
+ * Input Parameters
+ *      PCBptr				PCB allocated by AllocatePCB
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Process slot
+ ******************************************************************************/
+
+static inline long PCBSlot(long PCBptr)
+{
+	return ProcSlot[PCBptr - MAX_HEAP_MEMORY - 1];
+}
+
+/*******************************************************************************
+ * Function: NextPCB
+ *
+ * Description: Follows the queue link of a PCB.
+ *
+ * Input Parameters
+ *      PCBptr				PCB in a queue
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Next PCB in the queue
+ *      EndOfList
+ ******************************************************************************/
+
+static inline long NextPCB(long PCBptr)
+{
+	long next = ProcNext[PCBSlot(PCBptr)];
+	return next == EndOfList ? EndOfList : ProcPCB[next];
+}
+
+/*******************************************************************************
+ * Function: SetNextPCB
+ *
+ * Description: Sets the queue link of a PCB.
+ *
+ * Input Parameters
+ *      PCBptr				PCB to link
+ *      NextPCBptr			Next PCB in the queue, or EndOfList
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+static inline void SetNextPCB(long PCBptr, long NextPCBptr)
+{
+	ProcNext[PCBSlot(PCBptr)] = NextPCBptr == EndOfList ? EndOfList : PCBSlot(NextPCBptr);
+}
+
+/*******************************************************************************
+ * Function: SyncPCB
+ *
+ * Description: Copies the scheduler fields of a PCB from the process table
+ * to its words in OS memory, for a dump of them, and saves registers the
+ * CPU still holds for it.
+ *
+ * Input Parameters
+ *      PCBptr				PCB to update
+ *
+ * Output Parameters
+ *      mem[PCBptr + NextPtr], mem[PCBptr + PCB_Pid], mem[PCBptr + PCB_State],
+ *      mem[PCBptr + PCB_Reason], mem[PCBptr + PCB_Priority]
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void SyncPCB(long PCBptr)
+{
+	long slot = PCBSlot(PCBptr);
+
+	if (PCBptr == ContextPCB)
+		SaveContext(PCBptr);
+	mem[PCBptr + NextPtr] = NextPCB(PCBptr);
+	mem[PCBptr + PCB_Pid] = ProcPid[slot];
+	mem[PCBptr + PCB_State] = ProcState[slot];
+	mem[PCBptr + PCB_Reason] = ProcReason[slot];
+	mem[PCBptr + PCB_Priority] = ProcPriority[slot];
+}
+
+/*******************************************************************************
+ * Function: AllocateUserMemory
+ *
+ * Description:
+ *      This function is used to specify an amount of space in the user
+ memory to be allocated based on the requested size
+ *
+ * Input Parameters
+ *      RequestedSize - long value specfied by the user,
+ *                      to determine size of memory block to be allocated
+ *                      minimum value is 2 so if user requests less than 2
+ *                      the program will automatically change it to 2
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorNoFreeMemory
+ *      ErrorInvalidMemorySize
+ *
+ * initial implementation done by Jacob Nowlan
+ ******************************************************************************/
+
+long AllocateUserMemory(long RequestedSize) //return value contains address or ERROR
+{
+	// Allocate memory from OS free space, which is organized as link
+	if (UserFreeList == EndOfList)
+	{
+		printf("ERROR: No free User memory\n");
+		return(ErrorNoFreeMemory);
+	}
+
+	if (RequestedSize < 0)
+	{
+		printf("ERROR: Invalid Memory Size\n");
+		return(ErrorInvalidMemorySize);
+	}
+
+	if (RequestedSize == 1)
+	{
+		RequestedSize = 2; //minimum allocated memory is 2 locations
+	}
+
+	long CurrentPtr = UserFreeList;
+	long PreviousPtr = EndOfList;
+	while (CurrentPtr != EndOfList)
+	{
+		if (mem[CurrentPtr + 1] == RequestedSize)
+		{//found block with requested Size
+			if (CurrentPtr == UserFreeList) // first block
+			{
+				UserFreeList = mem[CurrentPtr]; //first entry is pointer to next block
+				mem[CurrentPtr] = EndOfList;  //reset next pointer in the allocated blcok
+				return(CurrentPtr); //return memory address
+			}
+			else //not first block
+			{
+				mem[PreviousPtr] = mem[CurrentPtr]; //point to next block
+				mem[CurrentPtr] = EndOfList; //reset next pointer in the allocated block
+				return(CurrentPtr); //return memory address
+			}
+		}
+
+		else if (mem[CurrentPtr + 1] > RequestedSize)
+		{
+			//found block with size greater than RequestedSize
+			if (CurrentPtr == UserFreeList) //first block
+			{
+				mem[CurrentPtr + RequestedSize] = mem[CurrentPtr];
+
+				mem[CurrentPtr + RequestedSize + 1] = mem[CurrentPtr + 1] - RequestedSize;
+
+				UserFreeList = CurrentPtr + RequestedSize; //address of reduced block
+				mem[CurrentPtr] = EndOfList; //reset next pointer in the allocated block
+				return(CurrentPtr); //return memory address
+			}
+			else // not first block
+			{
+				mem[CurrentPtr + RequestedSize] = mem[CurrentPtr]; //move the next block pointer
+
+				mem[CurrentPtr + RequestedSize + 1] = mem[CurrentPtr + 1] - RequestedSize;
+
+				mem[PreviousPtr] = CurrentPtr + RequestedSize; //address of reduced block
+				mem[CurrentPtr] = EndOfList; //Reset next pointer in the allocated block
+				return(CurrentPtr); //return memory address
+			}
+		}
+		else //small block
+		{
+			//look at next block
+			PreviousPtr = CurrentPtr;
+			CurrentPtr = mem[CurrentPtr];
+
+		}
+	} //end of while CurrentPtr loop
+
+	printf("ERROR: No Free User memory\n");
+	return(ErrorNoFreeMemory);
+}
+
+/*******************************************************************************
+ * Function: FreeUserMemory
+ *
+ * Description:
+ *      This function frees up space in user memory
+ *      This frees memory by using the pointer to specify
+ *      the area that will be overridden
+ *
+ * Input Parameters
+ *      ptr  - long value pointing to location in user memory that will be freed
+ *      size - amount of space in the user memory to be freed
+ *
+ * Output Parameters
+ *      UserFreeList
+ *      VerifiedCode			Cleared over the block
+ *
+ * Function Return Value
+ *      ErrorInvalidAddress
+ *
+ * initial implementation by Jacob Nowlan
+ ******************************************************************************/
+
+long FreeUserMemory(long ptr, long size)
+{
+	if (ptr <= MAX_USER_MEMORY || ptr > MAX_HEAP_MEMORY)
+	{
+		printf("ERROR: Invalid Adress");
+		return(ErrorInvalidAddress);
+	}
+
+	if (size == 1)
+	{
+		size = 2; //minimum allocated size
+	}
+
+	else if (size < 1 || (ptr + size) > MAX_HEAP_MEMORY + 1)
+	{
+		//invalid size
+		printf("ERROR: Invalid size or Invalid Address");
+		return(ErrorInvalidAddress);
+	}
+
+	// A relocated program may have left verifier marks; the block may come
+	// back as a stack, which Push writes without StoreMemory
+	memset(&VerifiedCode[ptr], 0, size);
+
+	mem[ptr] = UserFreeList;
+	mem[ptr + 1] = size; //set the free block size in the given free block
+	UserFreeList = ptr; // user free list points to given free block
+	return(OK);
+}
+
+/*******************************************************************************
+ * Function: AllocateProgramMemory
+ *
+ * Description: Allocates a program segment from the user region. Blocks on
+ * ProgramFreeList have the same layout as the other free lists: next block
+ * pointer, then block size. The first block that fits is used.
+ *
+ * Input Parameters
+ *      RequestedSize			Words in the program segment
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Address of the segment
+ *      ErrorNoFreeMemory
+ *      ErrorInvalidMemorySize
+ ******************************************************************************/
+
+long AllocateProgramMemory(long RequestedSize)
+{
+	if (RequestedSize < 1 || RequestedSize > MAX_USER_MEMORY + 1)
+	{
+		printf("ERROR: Invalid Memory Size\n");
+		return(ErrorInvalidMemorySize);
+	}
+	if (RequestedSize == 1)
+		RequestedSize = 2;		// Minimum allocated memory is 2 locations
+
+	long CurrentPtr = ProgramFreeList;
+	long PreviousPtr = EndOfList;
+	while (CurrentPtr != EndOfList)
+	{
+		// A one-word rest could not hold a free block header
+		if (mem[CurrentPtr + 1] == RequestedSize ||
+				mem[CurrentPtr + 1] >= RequestedSize + 2)
+		{
+			// Unlink the block, or keep the rest of it on the list
+			long RestPtr = mem[CurrentPtr];
+			if (mem[CurrentPtr + 1] > RequestedSize)
+			{
+				RestPtr = CurrentPtr + RequestedSize;
+				mem[RestPtr] = mem[CurrentPtr];
+				mem[RestPtr + 1] = mem[CurrentPtr + 1] - RequestedSize;
+			}
+			if (PreviousPtr == EndOfList)
+				ProgramFreeList = RestPtr;
+			else
+				mem[PreviousPtr] = RestPtr;
+			mem[CurrentPtr] = EndOfList;
+			return(CurrentPtr);
+		}
+		PreviousPtr = CurrentPtr;
+		CurrentPtr = mem[CurrentPtr];
+	}
+
+	printf("ERROR: No free program memory\n");
+	return(ErrorNoFreeMemory);
+}
+
+/*******************************************************************************
+ * Function: FreeProgramMemory
+ *
+ * Description: Returns a program segment to ProgramFreeList, dropping the
+ * verifier marks of its words.
+ *
+ * Input Parameters
+ *      ptr				Address of the segment
+ *      size				Words in the segment
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorInvalidAddress
+ ******************************************************************************/
+
+long FreeProgramMemory(long ptr, long size)
+{
+	if (size == 1)
+		size = 2;		// Minimum allocated size
+	if (ptr < 0 || size < 1 || ptr + size > MAX_USER_MEMORY + 1)
+	{
+		printf("ERROR: Invalid Adress");
+		return(ErrorInvalidAddress);
+	}
+
+	memset(&VerifiedCode[ptr], 0, size);	// See FreeUserMemory
+	mem[ptr] = ProgramFreeList;
+	mem[ptr + 1] = size;
+	ProgramFreeList = ptr;
+	return(OK);
+}
+
+/*******************************************************************************
+ * Function: TranslatePage
+ *
+ * Description: Paged half of the memory-protection unit. The TLB is looked
+ * up first; on a miss the PTE in the running process's page table is read
+ * and cached. Every translation sets the referenced bit of the frame.
+ *
+ * Input Parameters
+ *      Address				Address below limit
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      ErrorPageFault			-Page not resident, FaultAddress is set
+ *      Physical address
+ ******************************************************************************/
+
+long TranslatePage(long Address)
+{
+	if (Address > MAX_USER_MEMORY && Address <= MAX_HEAP_MEMORY)
+		return Address;			// Heap, as under the other models
+
+	long page = Address / PAGE_SIZE;
+	long slot = page % TLB_SIZE;
+	long frame;
+
+	if (TLBPage[slot] == page) {
+		TLBHits++;
+		frame = TLBFrame[slot];
+	}
+	else {
+		TLBMisses++;
+		frame = mem[base + page * PTEsize + PTE_Frame];
+		if (frame == NotResident) {
+			FaultAddress = Address;
+			return ErrorPageFault;
+		}
+		TLBPage[slot] = page;
+		TLBFrame[slot] = frame;
+	}
+	FrameReferenced[frame] = 1;
+	return frame * PAGE_SIZE + Address % PAGE_SIZE;
+}
+
+/*******************************************************************************
+ * Function: LoadPages
+ *
+ * Description: Builds the page table of a program in the OS region and
+ * writes its pages to the backing store. No page is resident until the
+ * program touches it. Pages over the heap addresses get no backing store.
+ *
+ * Input Parameters
+ *      Image				Program words from address 0
+ *      size				Words in Image
+ *
+ * Output Parameters
+ *      Base				Address of the page table
+ *      Limit				Virtual size of the program
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorNoFreeMemory
+ ******************************************************************************/
+
+long LoadPages(long *Image, long size, long *Base, long *Limit)
+{
+	long pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+	long table = AllocateOSMemory(pages * PTEsize);
+	if (table < 0)
+		return ErrorNoFreeMemory;
+
+	for (long page = 0; page < pages; page++) {
+		long entry = table + page * PTEsize;
+		mem[entry + PTE_Frame] = NotResident;
+		mem[entry + PTE_Swap] = EndOfList;
+		if (page > MAX_USER_MEMORY / PAGE_SIZE && page <= MAX_HEAP_MEMORY / PAGE_SIZE)
+			continue;
+
+		if (SwapFreeList == EndOfList) {
+			printf("ERROR: Backing store full\n");
+			FreePages(table, page * PAGE_SIZE);
+			return ErrorNoFreeMemory;
+		}
+		long slot = SwapFreeList;
+		SwapFreeList = SwapNext[slot];
+		mem[entry + PTE_Swap] = slot;
+		memcpy(SwapSpace[slot], &Image[page * PAGE_SIZE], sizeof(SwapSpace[slot]));
+	}
+
+	*Base = table;
+	*Limit = size;
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: FreePages
+ *
+ * Description: Releases the frames, backing store and page table of a
+ * paged program.
+ *
+ * Input Parameters
+ *      PageTable			Address of the page table
+ *      Limit				Virtual size of the program
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void FreePages(long PageTable, long Limit)
+{
+	long pages = (Limit + PAGE_SIZE - 1) / PAGE_SIZE;
+
+	for (long page = 0; page < pages; page++) {
+		long entry = PageTable + page * PTEsize;
+		if (mem[entry + PTE_Frame] != NotResident)
+			FrameOwner[mem[entry + PTE_Frame]] = EndOfList;
+		if (mem[entry + PTE_Swap] != EndOfList) {
+			SwapNext[mem[entry + PTE_Swap]] = SwapFreeList;
+			SwapFreeList = mem[entry + PTE_Swap];
+		}
+	}
+	if (TLBOwner == PageTable)
+		TLBOwner = EndOfList;		// A new table may reuse the address
+	if (pages > 0)
+		FreeOSMemory(&PageTable, pages * PTEsize);
+}
+
+/*******************************************************************************
+ * Function: ISRpageFaultInterrupt
+ *
+ * Description: Brings the page at FaultAddress into a frame for the given
+ * process, evicting the page chosen by the replacement policy and writing
+ * it back when dirty. The page-in is charged PAGE_FAULT_TIME.
+ *
+ * Input Parameters
+ *      PCBptr				Process that faulted
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void ISRpageFaultInterrupt(long PCBptr)
+{
+	long table = mem[PCBptr + PCB_Base];
+	long page = FaultAddress / PAGE_SIZE;
+	long entry = table + page * PTEsize;
+	long frame = SelectVictimFrame();
+
+	if (FrameOwner[frame] != EndOfList) {
+		long victim = FrameOwner[frame] + FramePage[frame] * PTEsize;
+		if (FrameDirty[frame]) {
+			memcpy(SwapSpace[mem[victim + PTE_Swap]], &mem[frame * PAGE_SIZE],
+					sizeof(SwapSpace[0]));
+			PageWriteBacks++;
+		}
+		mem[victim + PTE_Frame] = NotResident;
+		if (FrameOwner[frame] == TLBOwner && TLBPage[FramePage[frame] % TLB_SIZE] == FramePage[frame])
+			TLBPage[FramePage[frame] % TLB_SIZE] = NotResident;
+		PageEvictions++;
+	}
+
+	memcpy(&mem[frame * PAGE_SIZE], SwapSpace[mem[entry + PTE_Swap]], sizeof(SwapSpace[0]));
+	mem[entry + PTE_Frame] = frame;
+	FrameOwner[frame] = table;
+	FramePage[frame] = page;
+	FrameReferenced[frame] = 1;
+	FrameDirty[frame] = 0;
+	FrameAge[frame] = 0;
+	PageFaults++;
+	clock += PAGE_FAULT_TIME;
+
+	if (VerboseMode)
+		printf("Page fault: PID %ld page %ld into frame %ld\n",
+				ProcPid[PCBSlot(PCBptr)], page, frame);
+}
+
+/*******************************************************************************
+ * Function: SelectVictimFrame
+ *
+ * Description: Picks the frame for a page-in: a free frame if there is
+ * one, otherwise the clock hand's first unreferenced frame (clearing the
+ * referenced bits it passes), or under LRU the frame with the lowest age.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Frame number
+ ******************************************************************************/
+
+long SelectVictimFrame()
+{
+	long victim = 0;
+
+	for (long frame = 0; frame < FrameCount; frame++)
+		if (FrameOwner[frame] == EndOfList)
+			return frame;
+
+	if (ReplacementPolicy == PAGE_CLOCK) {
+		while (FrameReferenced[ClockHand]) {
+			FrameReferenced[ClockHand] = 0;
+			ClockHand = (ClockHand + 1) % FrameCount;
+		}
+		victim = ClockHand;
+		ClockHand = (ClockHand + 1) % FrameCount;
+		return victim;
+	}
+
+	for (long frame = 1; frame < FrameCount; frame++)
+		if (FrameAge[frame] < FrameAge[victim])
+			victim = frame;
+	return victim;
+}
+
+/*******************************************************************************
+ * Function: AgeFrames
+ *
+ * Description: Shifts each frame's referenced bit into its age after a time
+ * slice, the LRU approximation used by SelectVictimFrame.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void AgeFrames()
+{
+	if (ReplacementPolicy != PAGE_LRU)
+		return;
+	for (long frame = 0; frame < FrameCount; frame++) {
+		FrameAge[frame] = (FrameAge[frame] >> 1) | (FrameReferenced[frame] << 7);
+		FrameReferenced[frame] = 0;
+	}
+}
+
+/*******************************************************************************
+ * Function: FlushTLB
+ *
+ * Description: Invalidates every TLB entry.
+ ******************************************************************************/
+
+void FlushTLB()
+{
+	for (long slot = 0; slot < TLB_SIZE; slot++)
+		TLBPage[slot] = NotResident;
+}
+
+/*******************************************************************************
+ * Function: RestartInstruction
+ *
+ * Description: Undoes a partly executed instruction after a page fault.
+ * Faults happen while operands are fetched, before anything is stored, so
+ * restoring PC and the GPRs (autoincrement and autodecrement) is enough.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      pc, gpr
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void RestartInstruction()
+{
+	pc = RestartPC;
+	memcpy(gpr, RestartGPR, sizeof(gpr));
+	InstructionCount--;
+}
+
+/*******************************************************************************
+ * Function: StartTimer
+ *
+ * Description: Takes a timer from the free list and puts it on the wheel.
+ *
+ * Input Parameters
+ *      PCBptr				PCB of the process owning the timer
+ *      Deadline			Clock at which it expires
+ *      Period				Ticks between expiries, 0 for one-shot
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Timer number
+ *      ErrorNoFreeMemory		-Every timer is in use
+ ******************************************************************************/
+
+long StartTimer(long PCBptr, long Deadline, long Period)
+{
+	if (TimerFreeList == EndOfList) {
+		printf("ERROR: No free timer\n");
+		return ErrorNoFreeMemory;
+	}
+	long timer = TimerFreeList;
+	TimerFreeList = TimerNext[timer];
+	TimersInUse++;
+
+	TimerOwner[timer] = PCBptr;
+	TimerDeadline[timer] = Deadline;
+	TimerPeriod[timer] = Period;
+	InsertTimer(timer);
+	return timer;
+}
+
+/*******************************************************************************
+ * Function: InsertTimer
+ *
+ * Description: Links a timer into the wheel slot for its deadline: level 0
+ * when it falls within WHEEL_SLOTS ticks, otherwise the lowest level whose
+ * range reaches it. A deadline beyond the top level waits in the last top
+ * level slot and is placed again when that slot is cascaded. A deadline
+ * already past expires on the next tick processed.
+ *
+ * Input Parameters
+ *      timer				Timer number
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void InsertTimer(long timer)
+{
+	long when = TimerDeadline[timer] < WheelTime ? WheelTime : TimerDeadline[timer];
+	long range = 1L << (WHEEL_BITS * WHEEL_LEVELS);
+	long level = 0;
+
+	if (when - WheelTime >= range)
+		when = WheelTime + range - 1;
+	while (when - WheelTime >= 1L << (WHEEL_BITS * (level + 1)))
+		level++;
+
+	long slot = level * WHEEL_SLOTS + ((when >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+	TimerSlot[timer] = slot;
+	TimerPrev[timer] = EndOfList;
+	TimerNext[timer] = Wheel[slot];
+	if (Wheel[slot] != EndOfList)
+		TimerPrev[Wheel[slot]] = timer;
+	Wheel[slot] = timer;
+}
+
+/*******************************************************************************
+ * Function: StopTimer
+ *
+ * Description: Takes a timer off the wheel, if it is on it, and returns it
+ * to the free list.
+ *
+ * Input Parameters
+ *      timer				Timer number
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void StopTimer(long timer)
+{
+	if (TimerSlot[timer] != EndOfList) {
+		if (TimerPrev[timer] != EndOfList)
+			TimerNext[TimerPrev[timer]] = TimerNext[timer];
+		else
+			Wheel[TimerSlot[timer]] = TimerNext[timer];
+		if (TimerNext[timer] != EndOfList)
+			TimerPrev[TimerNext[timer]] = TimerPrev[timer];
+		TimerSlot[timer] = EndOfList;
+	}
+	TimerNext[timer] = TimerFreeList;
+	TimerFreeList = timer;
+	TimersInUse--;
+}
+
+/*******************************************************************************
+ * Function: AdvanceTimers
+ *
+ * Description: Turns the wheel up to the current clock. At each tick the
+ * higher level slots starting there are cascaded into the levels below,
+ * then every timer in the level 0 slot expires. An empty wheel jumps
+ * straight to the clock.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void AdvanceTimers()
+{
+	long timer, next;
+
+	if (TimersInUse == 0 && WheelTime <= clock)
+		WheelTime = clock + 1;
+	for (; WheelTime <= clock; WheelTime++) {
+		for (long level = WHEEL_LEVELS - 1; level > 0; level--) {
+			if (WheelTime & ((1L << (WHEEL_BITS * level)) - 1))
+				continue;
+			long slot = level * WHEEL_SLOTS +
+				((WheelTime >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+			timer = Wheel[slot];
+			Wheel[slot] = EndOfList;
+			for (; timer != EndOfList; timer = next) {
+				next = TimerNext[timer];
+				InsertTimer(timer);
+			}
+		}
+
+		long slot = WheelTime & (WHEEL_SLOTS - 1);
+		timer = Wheel[slot];
+		Wheel[slot] = EndOfList;
+		for (; timer != EndOfList; timer = next) {
+			next = TimerNext[timer];
+			TimerSlot[timer] = EndOfList;
+			ExpireTimer(timer);
+		}
+	}
+}
+
+/*******************************************************************************
+ * Function: ExpireTimer
+ *
+ * Description: Handles a timer that reached its deadline. A sleep timer is
+ * freed and wakes its process. A periodic timer is put back on the wheel
+ * one period later and wakes its process if it waits in timer_wait, or
+ * else counts the expiry for the next timer_wait.
+ *
+ * Input Parameters
+ *      timer				Timer number, already off the wheel
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void ExpireTimer(long timer)
+{
+	long PCBptr = TimerOwner[timer];
+
+	TimerExpiries++;
+	if (TimerPeriod[timer] == 0) {
+		mem[PCBptr + PCB_SleepTimer] = EndOfList;
+		StopTimer(timer);
+		WakeTimerWaiter(PCBptr, 0);
+		return;
+	}
+
+	TimerDeadline[timer] += TimerPeriod[timer];
+	InsertTimer(timer);
+	if (mem[PCBptr + PCB_SleepTimer] == EndOfList && ProcState[PCBSlot(PCBptr)] == Waiting &&
+			ProcReason[PCBSlot(PCBptr)] == TimerExpiry)
+		WakeTimerWaiter(PCBptr, 1);
+	else
+		mem[PCBptr + PCB_TimerPending]++;
+}
+
+/*******************************************************************************
+ * Function: WakeTimerWaiter
+ *
+ * Description: Moves a process blocked in sleep or timer_wait from the WQ
+ * to the RQ.
+ *
+ * Input Parameters
+ *      PCBptr				PCB of the process
+ *      Expiries			Returned in GPR1
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void WakeTimerWaiter(long PCBptr, long Expiries)
+{
+	if (ProcState[PCBSlot(PCBptr)] != Waiting || ProcReason[PCBSlot(PCBptr)] != TimerExpiry)
+		return;
+
+	SearchAndRemovePCBfromWQ(ProcPid[PCBSlot(PCBptr)]);
+	mem[PCBptr + PCB_GPR0] = OK;
+	mem[PCBptr + PCB_GPR1] = Expiries;
+	ProcState[PCBSlot(PCBptr)] = Ready;
+	InsertIntoRQ(&PCBptr);
+}
+
+/*******************************************************************************
+ * Function: TimerWaiters
+ *
+ * Description: Tells whether a process in the WQ waits for a timer.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Non-zero when one does
+ ******************************************************************************/
+
+int TimerWaiters()
+{
+	for (long PCBptr = WQ; PCBptr != EndOfList; PCBptr = NextPCB(PCBptr))
+		if (ProcReason[PCBSlot(PCBptr)] == TimerExpiry)
+			return 1;
+	return 0;
+}
+
+/*******************************************************************************
+ * Function: SkipIdleTime
+ *
+ * Description: Called when only the null process is ready and some process
+ * waits for a timer or the disk. Advances the clock tick by tick, expiring
+ * timers and completing disk requests, until a process is woken, instead of
+ * running the null process.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      clock
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void SkipIdleTime()
+{
+	long start = clock;
+
+	while (RQ == EndOfList || RQ == NullProcessPtr) {
+		clock++;
+		AdvanceTimers();
+		ISRdiskCompletionInterrupt();
+	}
+	IdleClock += clock - start;
+}
+
+/*******************************************************************************
+ * Function: TimeGetSystemCall
+ *
+ * Description: Returns the time of day, the clock plus the offset set by
+ *              time_set.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      gpr[0]				OK
+ *      gpr[1]				Time
+ *
+ * Function Return Value
+ *      OK
+ ******************************************************************************/
+
+long TimeGetSystemCall()
+{
+	gpr[1] = clock + TimeOffset;
+	gpr[0] = OK;
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: TimeSetSystemCall
+ *
+ * Description: Sets the time of day. Timers run on the clock and are not
+ *              moved.
+ *
+ * Input Parameters
+ *      gpr[1]				Time
+ *
+ * Output Parameters
+ *      gpr[0]				OK
+ *
+ * Function Return Value
+ *      OK
+ ******************************************************************************/
+
+long TimeSetSystemCall()
+{
+	TimeOffset = gpr[1] - clock;
+	gpr[0] = OK;
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: SleepSystemCall
+ *
+ * Description: Parks the running process in the WQ for a number of clock
+ *              ticks.
+ *
+ * Input Parameters
+ *      gpr[1]				Ticks, returns at once when not positive
+ *
+ * Output Parameters
+ *      gpr[0]				Return code
+ *      gpr[1]				0 on wake up
+ *
+ * Function Return Value
+ *      OK
+ *      WaitForTimer
+ *      ErrorNoFreeMemory		-No free timer
+ ******************************************************************************/
+
+long SleepSystemCall()
+{
+	gpr[0] = OK;
+	if (gpr[1] <= 0)
+		return gpr[0];
+
+	long timer = StartTimer(RunningPCB, clock + gpr[1], 0);
+	if (timer < 0) {
+		gpr[0] = timer;
+		return gpr[0];
+	}
+	mem[RunningPCB + PCB_SleepTimer] = timer;
+	return WaitForTimer;
+}
+
+/*******************************************************************************
+ * Function: TimerSetSystemCall
+ *
+ * Description: Starts the periodic timer of the running process, replacing
+ *              the one it had. The first expiry is one period from now.
+ *
+ * Input Parameters
+ *      gpr[1]				Period in ticks, 0 to stop the timer
+ *
+ * Output Parameters
+ *      gpr[0]				Return code
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorInvalidAddress		-Negative period
+ *      ErrorNoFreeMemory		-No free timer
+ ******************************************************************************/
+
+long TimerSetSystemCall()
+{
+	long Period = gpr[1];
+
+	if (Period < 0) {
+		printf("ERROR: Invalid timer period\n");
+		gpr[0] = ErrorInvalidAddress;
+		return gpr[0];
+	}
+	if (mem[RunningPCB + PCB_PeriodTimer] != EndOfList)
+		StopTimer(mem[RunningPCB + PCB_PeriodTimer]);
+	mem[RunningPCB + PCB_PeriodTimer] = EndOfList;
+	mem[RunningPCB + PCB_TimerPending] = 0;
+
+	gpr[0] = OK;
+	if (Period > 0) {
+		long timer = StartTimer(RunningPCB, clock + Period, Period);
+		if (timer < 0)
+			gpr[0] = timer;
+		else
+			mem[RunningPCB + PCB_PeriodTimer] = timer;
+	}
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: TimerWaitSystemCall
+ *
+ * Description: Waits for the next expiry of the periodic timer of the
+ *              running process. Expiries that happened since the last
+ *              wait are returned at once, so a late task sees its overrun.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      gpr[0]				Return code
+ *      gpr[1]				Expiries since the last wait
+ *
+ * Function Return Value
+ *      OK
+ *      WaitForTimer
+ *      ErrorNoTimer			-No periodic timer
+ ******************************************************************************/
+
+long TimerWaitSystemCall()
+{
+	if (mem[RunningPCB + PCB_PeriodTimer] == EndOfList) {
+		gpr[0] = ErrorNoTimer;
+		return gpr[0];
+	}
+	if (mem[RunningPCB + PCB_TimerPending] > 0) {
+		gpr[1] = mem[RunningPCB + PCB_TimerPending];
+		mem[RunningPCB + PCB_TimerPending] = 0;
+		gpr[0] = OK;
+		return gpr[0];
+	}
+	return WaitForTimer;
+}
+
+/*******************************************************************************
+ * Function: MemAllocSystemCall
+ *
+ * Description: this is a system call used to allow the machine code
+ *              to request a service from the operating system,
+ *              the service being memory allocation
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      gpr[1]
+ *      gpr[2]
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorInvalidAddress
+ *
+ * initial implementation by Jacob Nowlan
+ ******************************************************************************/
+
+long MemAllocSystemCall()
+{
+	// Allocate memory from user free list
+	// Return status from the function is either the address of allocated memory or an error code
+
+	long Size = gpr[2];
+
+	//check if size is out of range
+	if (Size < 1 || Size > MAX_USER_MEMORY)
+	{
+		printf("Error: InvalidAddress");
+		return(ErrorInvalidAddress);
+	}
+
+	if (Size == 1)
+		Size = 2;
+
+	gpr[1] = AllocateUserMemory(Size);
+
+	if (gpr[1] < 0)
+	{
+		gpr[0] = gpr[1]; //set GPR0 to have the return status
+	}
+	else
+	{
+		gpr[0] = OK;
+	}
+
+	if (VerboseMode)
+		printf("MemAllocSystemCall - GPR0: %d\tGPR1: %d\tGPR2: %d", gpr[0], gpr[1], gpr[2]);
+
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: MemFreeSystemCall
+ *
+ * Description: this is a system call used to allow the machine code
+ *              to request a service from the operating system,
+ *              allowing us to free space in user memory
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      gpr[0]
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorInvalidAddress
+ *
+ * implemtation by Jacob Nowlan
+ ******************************************************************************/
+
+long MemFreeSystemCall()
+{
+	// Return dynamically allocated memory to the user free list
+	// GPR1 has memory address and GPR2 has memory size to be released
+	// Return status in GPR0
+
+	long Size = gpr[2];
+
+	//check if size is out of range
+	if (Size < 1 || Size > MAX_USER_MEMORY)
+	{
+		printf("Error: InvalidAddress");
+		return(ErrorInvalidAddress);
+	}
+
+	if (Size == 1)
+		Size = 2;
+
+	gpr[0] = FreeUserMemory(gpr[1], Size);
+
+	if (VerboseMode)
+		printf("Mem_Free System Call - GPR0: %d\tGPR1: %d\tGPR2: %d", gpr[0], gpr[1], gpr[2]);
+
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: ProcessCreateSystemCall
+ *
+ * Description: Forks the running process. The child gets a copy of the
+ *              registers and of the stack, and shares the program: the
+ *              segment model shares both segments copy-on-write (see
+ *              CopyOnWrite), a relocated flat program shares its heap
+ *              block, and a paged program is copied into new pages.
+ *              Heap blocks from mem_alloc are shared, as the heap is not
+ *              relocated. The stack is copied because SP holds a physical
+ *              address.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      gpr[0]				Return code
+ *      gpr[1]				PID of the child, 0 in the child
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorNoFreeMemory
+ ******************************************************************************/
+
+long ProcessCreateSystemCall()
+{
+	long ParentPtr = RunningPCB;
+	long ChildPtr = AllocatePCB();
+	if (ChildPtr < 0) {
+		gpr[0] = ErrorNoFreeMemory;
+		return gpr[0];
+	}
+	InitializePCB(ChildPtr);
+
+	// Private stack holding a copy of the parent's
+	long StackSize = mem[ParentPtr + PCB_StackSize];
+	long ParentStack = mem[ParentPtr + PCB_StackStartAddr];
+	long StackPtr = AllocateUserMemory(StackSize);
+	if (StackPtr < 0) {
+		FreePCB(&ChildPtr);
+		gpr[0] = ErrorNoFreeMemory;
+		return gpr[0];
+	}
+	memcpy(&mem[StackPtr], &mem[ParentStack], StackSize * sizeof(long));
+
+	SaveContext(ChildPtr);		// Registers, PC and segments of the parent
+	if (ForkProgram(ParentPtr, ChildPtr) != OK) {
+		FreeUserMemory(StackPtr, StackSize);
+		FreePCB(&ChildPtr);
+		gpr[0] = ErrorNoFreeMemory;
+		return gpr[0];
+	}
+
+	mem[ChildPtr + PCB_SP] = sp - ParentStack + StackPtr;
+	mem[ChildPtr + PCB_StackStartAddr] = StackPtr;
+	mem[ChildPtr + PCB_StackSize] = StackSize;
+	ProcPriority[PCBSlot(ChildPtr)] = ProcPriority[PCBSlot(ParentPtr)];
+	mem[ChildPtr + PCB_Parent] = ProcPid[PCBSlot(ParentPtr)];
+	mem[ChildPtr + PCB_GPR0] = OK;
+	mem[ChildPtr + PCB_GPR1] = 0;
+
+	gpr[0] = OK;
+	gpr[1] = ProcPid[PCBSlot(ChildPtr)];
+	ForkCount++;
+
+	if (VerboseMode)
+		printf("Process_Create System Call - Child PID: %ld\n", gpr[1]);
+
+	InsertIntoRQ(&ChildPtr);
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: ForkProgram
+ *
+ * Description: Gives a forked child the program of its parent. The child
+ * PCB already holds the segment fields of the parent.
+ *
+ * Input Parameters
+ *      ParentPtr			PCB of the forking process
+ *      ChildPtr			PCB of the child
+ *
+ * Output Parameters
+ *      Segment fields of the child PCB
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorNoFreeMemory
+ ******************************************************************************/
+
+long ForkProgram(long ParentPtr, long ChildPtr)
+{
+	long CodeBase = mem[ChildPtr + PCB_CodeBase], CodeLimit = mem[ChildPtr + PCB_CodeLimit];
+	long Base = mem[ChildPtr + PCB_Base], Limit = mem[ChildPtr + PCB_Limit];
+	long CodeAddr = mem[ParentPtr + PCB_CodeAddr], CodeSize = mem[ParentPtr + PCB_CodeSize];
+
+	mem[ChildPtr + PCB_CodeAddr] = EndOfList;
+	mem[ChildPtr + PCB_CodeSize] = 0;
+
+	// A private segment of the parent gains two users, a shared one one more
+	if (MemoryModel == MMU_PAGED) {
+		if (CopyPages(Base, Limit, &Base) != OK)
+			return ErrorNoFreeMemory;
+		mem[ChildPtr + PCB_Base] = mem[ChildPtr + PCB_CodeBase] = Base;
+	}
+	else if (MemoryModel == MMU_SEGMENT) {
+		if (ShareSegment(CodeBase, CodeLimit,
+					FindSharedSegment(CodeBase) == EndOfList ? 2 : 1) != OK)
+			return ErrorNoFreeMemory;
+		if (CodeLimit < Limit && ShareSegment(Base + CodeLimit, Limit - CodeLimit,
+					FindSharedSegment(Base + CodeLimit) == EndOfList ? 2 : 1) != OK) {
+			ReleaseSegment(CodeBase, CodeLimit);
+			return ErrorNoFreeMemory;
+		}
+		ProcNative[PCBSlot(ChildPtr)] = ProcNative[PCBSlot(ParentPtr)];
+	}
+	else if (CodeSize > 0) {
+		if (ShareSegment(CodeAddr, CodeSize,
+					FindSharedSegment(CodeAddr) == EndOfList ? 2 : 1) != OK)
+			return ErrorNoFreeMemory;
+		mem[ChildPtr + PCB_CodeAddr] = CodeAddr;
+		mem[ChildPtr + PCB_CodeSize] = CodeSize;
+	}
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: CopyPages
+ *
+ * Description: Copies the pages of a paged program into new pages on the
+ * backing store. Resident pages are copied from their frames.
+ *
+ * Input Parameters
+ *      PageTable			Page table of the program
+ *      Limit				Size of the program
+ *
+ * Output Parameters
+ *      Base				Page table of the copy
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorNoFreeMemory
+ ******************************************************************************/
+
+long CopyPages(long PageTable, long Limit, long *Base)
+{
+	static long Image[MAX_VIRTUAL_MEMORY + 1];
+	long pages = (Limit + PAGE_SIZE - 1) / PAGE_SIZE;
+
+	for (long page = 0; page < pages; page++) {
+		long entry = PageTable + page * PTEsize;
+		long *words = &Image[page * PAGE_SIZE];
+		if (mem[entry + PTE_Frame] != NotResident)
+			memcpy(words, &mem[mem[entry + PTE_Frame] * PAGE_SIZE], PAGE_SIZE * sizeof(long));
+		else if (mem[entry + PTE_Swap] != EndOfList)
+			memcpy(words, SwapSpace[mem[entry + PTE_Swap]], PAGE_SIZE * sizeof(long));
+		else
+			memset(words, 0, PAGE_SIZE * sizeof(long));
+	}
+	return LoadPages(Image, Limit, Base, &Limit);
+}
+
+/*******************************************************************************
+ * Function: ProcessDeleteSystemCall
+ *
+ * Description: Terminates the running process. The exit status is kept
+ *              for the parent (see TerminateProcess).
+ *
+ * Input Parameters
+ *      gpr[1]				Exit status
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      SIMULATOR_STATUS_HALTED
+ ******************************************************************************/
+
+long ProcessDeleteSystemCall()
+{
+	mem[RunningPCB + PCB_ExitStatus] = gpr[1];
+	return SIMULATOR_STATUS_HALTED;
+}
+
+/*******************************************************************************
+ * Function: ProcessInquirySystemCall
+ *
+ * Description: Waits for a child of the running process to terminate. A
+ *              child already in ZombieQ is reaped at once; otherwise the
+ *              process waits in the WQ and TerminateProcess fills in the
+ *              results when the child exits.
+ *
+ * Input Parameters
+ *      gpr[1]				PID of the child, 0 for any child
+ *
+ * Output Parameters
+ *      gpr[0]				Return code
+ *      gpr[1]				PID of the child
+ *      gpr[2]				Exit status of the child
+ *
+ * Function Return Value
+ *      OK
+ *      WaitForChild			-No child has terminated yet
+ *      ErrorNoChild			-No such child
+ ******************************************************************************/
+
+long ProcessInquirySystemCall()
+{
+	long pid = ProcPid[PCBSlot(RunningPCB)];
+	long ChildPtr = FindChild(ZombieQ, pid, gpr[1]);
+
+	if (ChildPtr != EndOfList) {
+		RemoveFromQueue(&ZombieQ, ChildPtr);
+		gpr[0] = OK;
+		gpr[1] = ProcPid[PCBSlot(ChildPtr)];
+		gpr[2] = mem[ChildPtr + PCB_ExitStatus];
+		FreePCB(&ChildPtr);
+		return gpr[0];
+	}
+	if (FindChild(RQ, pid, gpr[1]) != EndOfList || FindChild(WQ, pid, gpr[1]) != EndOfList)
+		return WaitForChild;
+
+	gpr[0] = ErrorNoChild;
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: ProcessExecSystemCall
+ *
+ * Description: Replaces the program of the running process with the one
+ *              in a file. The file name is a string in the program, one
+ *              character per word ending with 0. The stack is emptied and
+ *              the new program starts at its entry point; the old program
+ *              is kept if the load fails.
+ *
+ * Input Parameters
+ *      gpr[1]				Address of the file name
+ *
+ * Output Parameters
+ *      gpr[0]				Return code
+ *      pc, sp, base, limit, codebase, codelimit
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorInvalidAddress		-Bad file name
+ *      ErrorPageFault			-File name not resident
+ *      AbsoluteLoader error codes
+ ******************************************************************************/
+
+long ProcessExecSystemCall()
+{
+	const int Fields[] = { PCB_Base, PCB_Limit, PCB_CodeBase, PCB_CodeLimit,
+		PCB_CodeAddr, PCB_CodeSize };
+	const int FieldCount = sizeof(Fields) / sizeof(Fields[0]);
+	long Old[6], New[6];		// One per field
+	char filename[MAX_FILENAME];
+	long PCBptr = RunningPCB;
+	int i;
+
+	for (i = 0; i < MAX_FILENAME; i++) {
+		long addr = Translate(gpr[1] + i);
+		if (addr == ErrorPageFault)
+			return ErrorPageFault;
+		if (addr < 0 || mem[addr] < 0 || mem[addr] > 255) {
+			printf("ERROR: Invalid file name address\n");
+			gpr[0] = ErrorInvalidAddress;
+			return gpr[0];
+		}
+		if ((filename[i] = mem[addr]) == '\0')
+			break;
+	}
+	if (i == MAX_FILENAME) {
+		printf("ERROR: File name too long\n");
+		gpr[0] = ErrorInvalidAddress;
+		return gpr[0];
+	}
+
+	// Load beside the old program, which is released only on success
+	SaveContext(PCBptr);
+	for (i = 0; i < FieldCount; i++)
+		Old[i] = mem[PCBptr + Fields[i]];
+	long EntryPC = AbsoluteLoader(filename, PCBptr);
+	for (i = 0; i < FieldCount; i++) {
+		New[i] = mem[PCBptr + Fields[i]];
+		mem[PCBptr + Fields[i]] = Old[i];
+	}
+	if (EntryPC < 0) {
+		gpr[0] = EntryPC;
+		return gpr[0];
+	}
+	ReleaseProgram(PCBptr);
+	for (i = 0; i < FieldCount; i++)
+		mem[PCBptr + Fields[i]] = New[i];
+
+	base = mem[PCBptr + PCB_Base];
+	limit = mem[PCBptr + PCB_Limit];
+	codebase = mem[PCBptr + PCB_CodeBase];
+	codelimit = mem[PCBptr + PCB_CodeLimit];
+	if (MemoryModel == MMU_PAGED) {
+		FlushTLB();
+		TLBOwner = base;
+	}
+	pc = EntryPC;
+	sp = mem[PCBptr + PCB_StackStartAddr] - 1;
+	memset(gpr, 0, sizeof(gpr));
+	gpr[0] = OK;
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: MsgSendSystemCall
+ *
+ * Description: Sends a message to the mailbox of a process. The message
+ *              is a heap block (from mem_alloc) that is handed over to the
+ *              receiver: no word is copied, and the sender must not use
+ *              or free the block afterwards. A receiver blocked on an
+ *              empty mailbox gets the message in its registers and is
+ *              made ready at once.
+ *
+ * Input Parameters
+ *      gpr[1]				PID of the receiver
+ *      gpr[2]				Address of the buffer
+ *      gpr[3]				Words in the buffer, 0 for an empty message
+ *
+ * Output Parameters
+ *      gpr[0]				Return code
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorInvalidAddress		-Buffer is not in the heap
+ *      ErrorNoProcess			-No such receiver
+ *      ErrorMailboxFull
+ *      ErrorNoFreeMemory		-No room for the mailbox
+ ******************************************************************************/
+
+long MsgSendSystemCall()
+{
+	long ProcessID = gpr[1], Buffer = gpr[2], Size = gpr[3];
+	long sender = ProcPid[PCBSlot(RunningPCB)];
+
+	if (Size < 0 || (Size > 0 && (Buffer <= MAX_USER_MEMORY ||
+					Buffer + Size - 1 > MAX_HEAP_MEMORY))) {
+		printf("ERROR: Message buffer not in the heap\n");
+		gpr[0] = ErrorInvalidAddress;
+		return gpr[0];
+	}
+
+	// A blocked receiver takes the message without the mailbox
+	long PCBptr = FindPCB(WQ, ProcessID);
+	if (PCBptr != EndOfList && ProcReason[PCBSlot(PCBptr)] == MessageArrival) {
+		SearchAndRemovePCBfromWQ(ProcessID);
+		mem[PCBptr + PCB_GPR0] = OK;
+		mem[PCBptr + PCB_GPR1] = sender;
+		mem[PCBptr + PCB_GPR2] = Buffer;
+		mem[PCBptr + PCB_GPR3] = Size;
+		mem[PCBptr + PCB_MessageClock] = clock;
+		ProcState[PCBSlot(PCBptr)] = Ready;
+		InsertIntoRQ(&PCBptr);
+		MessagesSent++;
+		gpr[0] = OK;
+		return gpr[0];
+	}
+
+	if (PCBptr == EndOfList)
+		PCBptr = ProcessID == sender ? RunningPCB : FindPCB(RQ, ProcessID);
+	if (PCBptr == EndOfList) {
+		printf("ERROR: Message to invalid Process ID %ld\n", ProcessID);
+		gpr[0] = ErrorNoProcess;
+		return gpr[0];
+	}
+
+	long Mailbox = mem[PCBptr + PCB_Mailbox];
+	if (Mailbox == EndOfList) {
+		Mailbox = AllocateOSMemory(MAILBOX_SIZE);
+		if (Mailbox < 0) {
+			gpr[0] = ErrorNoFreeMemory;
+			return gpr[0];
+		}
+		mem[Mailbox + MB_Head] = 0;
+		mem[Mailbox + MB_Count] = 0;
+		mem[PCBptr + PCB_Mailbox] = Mailbox;
+	}
+	if (mem[Mailbox + MB_Count] == MAILBOX_SLOTS) {
+		gpr[0] = ErrorMailboxFull;
+		return gpr[0];
+	}
+
+	long slot = Mailbox + MB_Slots + (mem[Mailbox + MB_Head] + mem[Mailbox + MB_Count])
+		% MAILBOX_SLOTS * MSG_SIZE;
+	mem[slot + MSG_Sender] = sender;
+	mem[slot + MSG_Buffer] = Buffer;
+	mem[slot + MSG_Size] = Size;
+	mem[slot + MSG_Clock] = clock;
+	mem[Mailbox + MB_Count]++;
+	MessagesSent++;
+
+	if (VerboseMode)
+		printf("Msg_Send System Call - GPR1: %ld\tGPR2: %ld\tGPR3: %ld\n", gpr[1], gpr[2], gpr[3]);
+
+	gpr[0] = OK;
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: MsgReceiveSystemCall
+ *
+ * Description: Takes the oldest message from the mailbox of the running
+ *              process. The process blocks in the WQ while the mailbox is
+ *              empty; MsgSendSystemCall then fills in the results.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      gpr[0]				Return code
+ *      gpr[1]				PID of the sender
+ *      gpr[2]				Address of the buffer, now owned by the receiver
+ *      gpr[3]				Words in the buffer
+ *
+ * Function Return Value
+ *      OK
+ *      WaitForMessage			-Mailbox empty
+ ******************************************************************************/
+
+long MsgReceiveSystemCall()
+{
+	long Mailbox = mem[RunningPCB + PCB_Mailbox];
+	if (Mailbox == EndOfList || mem[Mailbox + MB_Count] == 0)
+		return WaitForMessage;
+
+	long slot = Mailbox + MB_Slots + mem[Mailbox + MB_Head] * MSG_SIZE;
+	gpr[1] = mem[slot + MSG_Sender];
+	gpr[2] = mem[slot + MSG_Buffer];
+	gpr[3] = mem[slot + MSG_Size];
+	MessageLatency += clock - mem[slot + MSG_Clock];
+	MessagesReceived++;
+	mem[Mailbox + MB_Head] = (mem[Mailbox + MB_Head] + 1) % MAILBOX_SLOTS;
+	mem[Mailbox + MB_Count]--;
+
+	if (VerboseMode)
+		printf("Msg_Receive System Call - GPR1: %ld\tGPR2: %ld\tGPR3: %ld\n", gpr[1], gpr[2], gpr[3]);
+
+	gpr[0] = OK;
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: InitializePCB
+ *
+ * Description:
+ *      This function initializes all important values of the PCB
+ *      sets all values in the user memory to 0
+ *      allocates PID and set in in the pcb
+ *      sets default state to ReadyState
+ *      sets priority to default priority
+ *      sets next pointer to point to end of list
+ *
+ * Input Parameters
+ *      PCBptr  - long value specifying adress in pcb
+ *
+ * Output Parameters
+ *      ProcPid[PCBSlot(PCBptr)]       - ProcessID
+ *      ProcState[PCBSlot(PCBptr)]     - the state of os
+ *      ProcPriority[PCBSlot(PCBptr)]  - priority
+ *      ProcNext[PCBSlot(PCBptr)]      - nextPCBlink
+ *
+ * Function Return Value
+ *      None
+ *
+ * Initial implementation by Jacob Nowlan
+ ******************************************************************************/
+
+void InitializePCB(long PCBptr)
+{
+	//Set entire PCB area to 0 using PCBptr;
+	// Array initialization
+	for (int i = 0; i < PCBsize; i++)
+	{
+		mem[PCBptr + i] = 0;
+	}
+	// Allocate PID and set it in the PCB. PID zero is invalidcvoid
+	ProcPid[PCBSlot(PCBptr)] = ProcessID++;  // ProcessID is global variable initialized to 1
+
+	//Set state field in the PCB = ReadyState;
+	ProcState[PCBSlot(PCBptr)] = ReadyState;
+	ProcReason[PCBSlot(PCBptr)] = 0;
+
+	//Set priority field in the PCB = Default Priority;
+	ProcPriority[PCBSlot(PCBptr)] = DEFAULT_PRIORITY;
+
+	//Set next PCB pointer field in the PCB = EndOfList
+	SetNextPCB(PCBptr, EndOfList);
+	mem[PCBptr + PCB_Mailbox] = EndOfList;
+	mem[PCBptr + PCB_SleepTimer] = EndOfList;
+	mem[PCBptr + PCB_PeriodTimer] = EndOfList;
+
+	return;
+}
+
+/*******************************************************************************
+ * Function: PrintPCB
+ * Description: This function simply displays the status of the current PCB
+ *
+ * Input Parameters
+ *      PCBptr      - the pointer to the start of the PCB
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ *
+ * Initial implementation by Jacob Nowlan
+ ******************************************************************************/
+
+void PrintPCB(long PCBptr)
+{
+	SyncPCB(PCBptr);
+	printf("PCB address = %d\n",  PCBptr);
+	printf("Next PCB Ptr = %ld\n", NextPCB(PCBptr));
+	printf("PID = %ld\n", ProcPid[PCBSlot(PCBptr)]);
+	printf("State = %ld\n", ProcState[PCBSlot(PCBptr)]);
+	printf("PC = %d\n", mem[PCBptr + PCB_PC]);
+	printf("SP = %d\n", mem[PCBptr + PCB_SP]);
+	printf("Segment: base = %ld\n", mem[PCBptr + PCB_Base]);
+	printf("Limit = %ld\n", mem[PCBptr + PCB_Limit]);
+	printf("Code segment: base = %ld, limit = %ld\n",
+			mem[PCBptr + PCB_CodeBase], mem[PCBptr + PCB_CodeLimit]);
+	printf("Parent PID = %ld\n", mem[PCBptr + PCB_Parent]);
+	if (mem[PCBptr + PCB_CodeSize] > 0)
+		printf("Relocated code: address = %ld, size = %ld\n",
+				mem[PCBptr + PCB_CodeAddr], mem[PCBptr + PCB_CodeSize]);
+	printf("Priority = %ld\n", ProcPriority[PCBSlot(PCBptr)]);
+	printf("Stack Info: start address = %d\n", mem[PCBptr + PCB_StackStartAddr]);
+	printf("Size = %d\n", mem[PCBptr + PCB_StackSize]);
+	printf("GPR 0 = %d\n", mem[PCBptr + PCB_GPR0]);
+	printf("GPR 1 = %d\n", mem[PCBptr + PCB_GPR1]);
+	printf("GPR 2 = %d\n", mem[PCBptr + PCB_GPR2]);
+	printf("GPR 3 = %d\n", mem[PCBptr + PCB_GPR3]);
+	printf("GPR 4 = %d\n", mem[PCBptr + PCB_GPR4]);
+	printf("GPR 5 = %d\n", mem[PCBptr + PCB_GPR5]);
+	printf("GPR 6 = %d\n", mem[PCBptr + PCB_GPR6]);
+	printf("GPR 7 = %d\n", mem[PCBptr + PCB_GPR7]);
+
+	return;
+
+}  // end of PrintPCB() function
+
+/*******************************************************************************
+ * Function: PrintQueue
+ *
+ * Description: This function will print all of the processes
+ *              that are in the queue until it reaches the EndOfList
+ *
+ * Input Parameters
+ *      Qptr    -pointer to a process in the queue
+ *
+ * Output Parameters
+ *      none
+ *
+ * Function Return Value
+ *      OK
+ ******************************************************************************/
+
+long PrintQueue(long Qptr)
+{
+	long currentPCBPtr = Qptr;
+
+	if (currentPCBPtr == EndOfList)
+	{
+		printf("Empty List\n");
+		return(OK);
+	}
+
+	while (currentPCBPtr != EndOfList)
+	{
+		//Print PCB passing currentPCBPtr
+		PrintPCB(currentPCBPtr);
+		//currentPCBPtr = nextPCBlink;
+		currentPCBPtr = NextPCB(currentPCBPtr);
+	}
+
+	return(OK);
+}
+
+/*******************************************************************************
+ * Function: SelectProcessFromRQ
+ *
+ * Description: Selects the process that is at the front of the Ready Queue.
+ *
+ * Input Parameters
+ * - None
+ *
+ * Output Parameters
+ * - PCBptr			The ptr to the PCB which is to be run
+ *
+ * Function Return Value
+ * - None
+ ******************************************************************************/
+
+long SelectProcessFromRQ()
+{
+	long PCBptr = RQ;
+
+	if (RQ == EndOfList)
+		return(EndOfList);
+
+	// Remove first PCB RQ
+	// Set RQ = next PCB pointed by RQ
+	RQ = NextPCB(RQ);
+
+	// Set next point to EOL in the PCB
+	// Set Next PCBfield in the given PCB to End of List
+
+	SetNextPCB(PCBptr, EndOfList);
+
+	return(PCBptr);
+} //end of SelectProcessFromRQ
+
+
+/*******************************************************************************
+ * Function: SaveContext
+ *
+ * Description: Save context stores all of the current values of the gpr's into
+ *              the PCB, as well as storing the SP and PC into the PCB.
+ *              A process that loses the CPU at the end of its time slice is
+ *              saved later, by the Dispatcher or a reader of its PCB, and
+ *              not at all when it is dispatched again first.
+ *
+ * Input Parameters
+ *      PCBptr      -Pointer to start of PCB
+ *
+ * Output Parameters
+ *      mem[PCBptr + PCB_GPR0]
+ *      mem[PCBptr + PCB_GPR1]
+ *      mem[PCBptr + PCB_GPR2]
+ *      mem[PCBptr + PCB_GPR3]
+ *      mem[PCBptr + PCB_GPR4]
+ *      mem[PCBptr + PCB_GPR5]
+ *      mem[PCBptr + PCB_GPR6]
+ *      mem[PCBptr + PCB_GPR7]
+ *      mem[PCBptr + PCB_SP]
+ *      mem[PCBptr + PCB_PC]
+ *      mem[PCBptr + PCB_PSR]
+ *      mem[PCBptr + PCB_Base]
+ *      mem[PCBptr + PCB_Limit]
+ *      mem[PCBptr + PCB_CodeBase]
+ *      mem[PCBptr + PCB_CodeLimit]
+ *      ContextPCB			EndOfList when it was PCBptr
+ *
+ * Function Return Value
+ *      None
+ *
+ * initial implementation by Jacob Nowlan
+ ******************************************************************************/
+
+void SaveContext(long PCBptr)
+{
+	//Assume PCBptr is a valid pointer
+
+	// PCB_GPR0 to PCB_GPR7 are consecutive words
+	memcpy(&mem[PCBptr + PCB_GPR0], gpr, sizeof(gpr));
+
+	mem[PCBptr + PCB_SP] = sp;
+
+	mem[PCBptr + PCB_PC] = pc;
+	mem[PCBptr + PCB_PSR] = psr;		// Condition flags of the process
+	mem[PCBptr + PCB_Base] = base;
+	mem[PCBptr + PCB_Limit] = limit;
+	mem[PCBptr + PCB_CodeBase] = codebase;
+	mem[PCBptr + PCB_CodeLimit] = codelimit;
+
+	if (PCBptr == ContextPCB)
+		ContextPCB = EndOfList;
+}
+
+/*******************************************************************************
+ * Function: Dispatcher
+ *
+ * Description: The Dispatcher serves as the opposite of save context
+ *              this funtion stores the values of pcb into the systems GPR's,
+ *              sp, pc and psr flags, as well as setting the psr to user mode.
+ *              The registers are left alone when the CPU still holds them
+ *              (ContextPCB); registers of another process held there are
+ *              saved first.
+ *
+ * Input Parameters
+ *      PCBptr      - long value pointing to pcb
+ *
+ * Output Parameters
+ *      gpr[0]
+ *      gpr[1]
+ *      gpr[2]
+ *      gpr[3]
+ *      gpr[4]
+ *      gpr[5]
+ *      gpr[6]
+ *      gpr[7]
+ *      sp
+ *      pc
+ *      stackbase, stacklimit		Stack bounds, from the PCB
+ *      base
+ *      limit
+ *      codebase
+ *      codelimit
+ *      psr
+ *
+ * Function Return Value
+ *      None
+ *
+ * Initial implementation by Jacob Nowlan
+ ******************************************************************************/
+
+void Dispatcher(long PCBptr)
+{
+	//PCBptr is assumed to be correct
+
+	// The CPU still holds the registers of a process picked again after its
+	// time slice; any other process saved there is saved now
+	if (PCBptr == ContextPCB) {
+		ContextReuses++;
+		ContextPCB = EndOfList;
+	}
+	else {
+		if (ContextPCB != EndOfList)
+			SaveContext(ContextPCB);
+		RestoreContext(PCBptr);
+	}
+
+	psr = (psr & PSR_FLAGS) | MACHINE_MODE_USER;
+	RunningPCB = PCBptr;
+
+	// A message handed over while the process was blocked is received now
+	if (mem[PCBptr + PCB_MessageClock] != 0) {
+		MessageLatency += clock - mem[PCBptr + PCB_MessageClock];
+		MessagesReceived++;
+		mem[PCBptr + PCB_MessageClock] = 0;
+	}
+
+	return;
+}
+
+/*******************************************************************************
+ * Function: RestoreContext
+ *
+ * Description: Loads the registers of a process from its PCB.
+ *
+ * Input Parameters
+ *      PCBptr				PCB of the process
+ *
+ * Output Parameters
+ *      gpr, sp, pc, psr, stackbase, stacklimit, base, limit, codebase,
+ *      codelimit
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void RestoreContext(long PCBptr)
+{
+	//copy CPU GPR register values from given PCB into the CPU registers
+	//This is opposite of save CPU context
+	memcpy(gpr, &mem[PCBptr + PCB_GPR0], sizeof(gpr));
+
+	//Restore SP and PC from given PCB
+	sp = mem[PCBptr + PCB_SP];
+	pc = mem[PCBptr + PCB_PC];
+	psr = mem[PCBptr + PCB_PSR];
+	stackbase = mem[PCBptr + PCB_StackStartAddr];
+	stacklimit = stackbase + mem[PCBptr + PCB_StackSize] - 1;
+	base = mem[PCBptr + PCB_Base];
+	limit = mem[PCBptr + PCB_Limit];
+	codebase = mem[PCBptr + PCB_CodeBase];
+	codelimit = mem[PCBptr + PCB_CodeLimit];
+
+	// The TLB only holds translations of one process
+	if (MemoryModel == MMU_PAGED && TLBOwner != base) {
+		FlushTLB();
+		TLBOwner = base;
+	}
+}
+
+/*******************************************************************************
+ * Function: InsertIntoRQ
+ *
+ * Description: Inserts a Process into the Ready Queue at some position
+ * dependent on it's priority.
+ *
+ * Input Parameters
+ * - *PCBptr			Pointer to the PCB that is to be inserted
+ *
+ * Output Parameters
+ * - None
+ *
+ * Function Return Value
+ * 	OK
+ * 	ErrorInvalidAddress
+ ******************************************************************************/
+
+long InsertIntoRQ(long *PCBptr)
+{
+	// Insert PCB according to Priority Round Robin algorithm
+	// Use priority in the PCB to find the correct place to insert
+	// The RQ is walked by process slot, so each step is one load
+	long Previous = EndOfList;
+	long Current;
+
+	//check for invalid PCB memory address
+	if ((*PCBptr < 0) || (*PCBptr > MAX_OS_MEMORY))
+	{
+		printf("ERROR: Invalid Memory Address ");
+		return(ErrorInvalidAddress);
+	}
+
+	long slot = PCBSlot(*PCBptr);
+	long Priority = ProcPriority[slot];
+	ProcState[slot] = Ready;   //set state to ready
+	ProcNext[slot] = EndOfList; //set next pointer to end of list
+
+	if (RQ == EndOfList) //RQ is empty
+	{
+		RQ = *PCBptr;
+		return(OK);
+	}
+
+	//walk thru RQ and find place to insert
+	// PCB will be inserted at the end of its priority
+
+	for (Current = PCBSlot(RQ); Current != EndOfList; Current = ProcNext[Current])
+	{
+		if (Priority > ProcPriority[Current])
+		{
+			if (Previous == EndOfList)
+			{
+				// Enter PCB in the front of the list as first entry
+				ProcNext[slot] = Current;
+				RQ = *PCBptr;
+				return(OK);
+			}
+			//enter PCB in the middle of the list
+			ProcNext[slot] = Current;
+			ProcNext[Previous] = slot;
+			return(OK);
+		}
+		//PCB to inserted has lower or equal priority to the Current PCB in RQ
+		Previous = Current;
+	} // end of for loop
+
+	//insert PCB at the end of RQ
+	ProcNext[Previous] = slot;
+	return(OK);
+}
+
+/*** FUNCTIONS ***/
+/*******************************************************************************
+ * Function: InsertIntoWQ
+ *
+ * Description: Inserts a Process into the Waiting Queue. The Waiting Queue is
+ * not sorted by priority
+ *
+ * Input Parameters
+ * - *PCBptr			Pointer to the PCB that is to be inserted
+ *
+ * Output Parameters
+ * - None
+ *
+ * Function Return Value
+ * 	OK
+ * 	ErrorInvalidAddress
+ *
+ ******************************************************************************/
+
+long InsertIntoWQ(long *PCBptr)
+{
+	//insert given PCB at the front of InsertIntoWQ
+
+	//check for invalid PCB memory Address
+	if ((*PCBptr < 0) || (*PCBptr > MAX_OS_MEMORY))
+	{
+		printf("ERROR: Invalid PCB address");
+		return(ErrorInvalidAddress); //error code < 0
+	}
+
+	ProcState[PCBSlot(*PCBptr)] = Waiting; //What
+	SetNextPCB(*PCBptr, WQ);
+
+	WQ = *PCBptr;
+
+	return(OK);
+} //end of InsertIntoWQ() function
+
+/*******************************************************************************
+ * Function: CheckAndProcessInterrupt
+ *
+ * Description: Read interrupt ID number. Based on the interrupt ID,
+ * service the interrupt.
+ *
+ * Input Parameters: N/A
+ *
+ * Output Parameters: N/A
+ *
+ * Function Return Value: N/A
+ *
+ * Initial implementation by Douglas Perkins
+ ******************************************************************************/
+
+void CheckAndProcessInterrupt()
+{
+
+	int InterruptID;
+	// Prompt and read interrupt ID
+	printf("Possible interrupt IDs: \n0 - no interrupt"
+			"\n1 - run program"
+			"\n2 - shutdown system"
+			"\n3 - input operation completion (io_getc)"
+			"\n4 - output operation completion (io_putc)");
+
+	printf("Input interrupt ID: ");
+	scanf("%d", &InterruptID);
+	printf("Interrupt read: %d\n", InterruptID);
+
+	// Process interrupt
+	switch(InterruptID)
+	{
+		case 0: // no interrupt
+			break;
+
+		case 1: // run program
+			ISRrunProgramInterrupt();
+			break;
+
+		case 2: // shutdown system
+			ISRshutdownSystem();
+			SysShutdownStatus = 1;
+			break;
+
+		case 3: // input operation completion (io_getc)
+			ISRinputCompletionInterrupt();
+			break;
+
+		case 4: // output operation completion (io_putc)
+			ISRoutputCompletionInterrupt();
+			break;
+
+		default: // invalid interrupt ID
+			printf("Invalid interrupt ID");
+			break;
+	}
+
+	return;
+}
+
+
+/*******************************************************************************
+ * Function: ISRrunProgramInterrupt
+ *
+ * Description: Read filename and create process.
+ *
+ * Input Parameters:
+ * - None
+ *
+ * Output Parameters
+ * - None
+ *
+ * Function Return Value
+ *
+ * Initial implementation by Douglas Perkins
+ ******************************************************************************/
+
+void ISRrunProgramInterrupt()
+{
+	char filename[30];
+
+	// Prompt and read filename
+	printf("Input filename: ");
+	fgets(filename, 30, stdin);
+	strtok(filename, "\n");
+
+	// Call Create Process passing filename and Default Priority as arguments
+	CreateProcess(filename, DEFAULT_PRIORITY);
+
+	return;
+}
+
+
+
+/*******************************************************************************
+ * Function: Input Completion Interrupt
+ *
+ * Description: Read PID of the process completing the io_getc operation and
+ * 				read one character from the keyboard (input device). Store the
+ * 				character in the GPR in the PCB of the process.
+ *
+ * Input Parameters: N/A
+ *
+ * Output Parameters: N/A
+ *
+ * Function Return Value: N/A
+ *
+ * Initial implementation by Douglas Perkins
+ ******************************************************************************/
+
+void ISRinputCompletionInterrupt()
+{
+
+	int ProcessID;
+	long currentPCBptr;
+
+	// Prompt and read PID of the process completing input completion
+	printf("Input PID of the process completing input completion: ");
+	scanf("%d", &ProcessID);
+
+	// Search WQ to find the PCB having the given PID
+	currentPCBptr = SearchAndRemovePCBfromWQ(ProcessID);
+	if (currentPCBptr != EndOfList && !WaitingForIO(currentPCBptr)) {
+		InsertIntoWQ(&currentPCBptr);		// Waiting for a child or a message
+		printf("Invalid Process ID");
+		return;
+	}
+	if (currentPCBptr != EndOfList) {
+		CompleteInputOperation(currentPCBptr);
+		return;
+	}
+
+	// If no match is found in WQ, then search RQ
+	for (currentPCBptr = RQ; currentPCBptr != EndOfList;
+			currentPCBptr = NextPCB(currentPCBptr)) {
+		if (ProcPid[PCBSlot(currentPCBptr)] == ProcessID) {
+			// The CPU may still hold the registers of the process
+			if (currentPCBptr == ContextPCB)
+				SaveContext(currentPCBptr);
+
+			// Read one character from standard input device keyboard
+			printf("Enter a character: ");
+			mem[currentPCBptr + PCB_GPR1] = getchar();
+			return;
+		}
+	}
+
+	// If no matching PCB is found in WQ, and RQ, print invalid PID as an error message.
+	printf("Invalid Process ID");
+	return;
+}
+
+
+/*******************************************************************************
+ * Function: Output Completion Interrupt
+ *
+ * Description: Read PID of the process completing the io_putc operation and
+ * 				display one character on the monitor (output device) from the GPR
+ * 				in the PCB of the process
+ *
+ * Input Parameters: N/A
+ *
+ * Output Parameters: N/A
+ *
+ * Function Return Value: N/A
+ *
+ * Initial implementation by Douglas Perkins
+ ******************************************************************************/
+
+void ISRoutputCompletionInterrupt()
+{
+
+	int ProcessID;
+	long currentPCBptr;
+
+	// Prompt and read PID of the process completing output completion
+	printf("Input PID of the process completing output completion: ");
+	scanf("%d", &ProcessID);
+
+	// Search WQ to find the PCB having the given PID
+	currentPCBptr = SearchAndRemovePCBfromWQ(ProcessID);
+	if (currentPCBptr != EndOfList && !WaitingForIO(currentPCBptr)) {
+		InsertIntoWQ(&currentPCBptr);		// Waiting for a child or a message
+		printf("Invalid Process ID");
+		return;
+	}
+	if (currentPCBptr != EndOfList) {
+		CompleteOutputOperation(currentPCBptr);
+		return;
+	}
+
+	// If no match is found in WQ, then search RQ
+	for (currentPCBptr = RQ; currentPCBptr != EndOfList;
+			currentPCBptr = NextPCB(currentPCBptr)) {
+		if (ProcPid[PCBSlot(currentPCBptr)] == ProcessID) {
+			// The CPU may still hold the registers of the process
+			if (currentPCBptr == ContextPCB)
+				SaveContext(currentPCBptr);
+
+			// Print the character in the GPR in the PCB
+			printf("%c", (char)mem[currentPCBptr + PCB_GPR1]);
+			return;
+		}
+	}
+
+	// If no matching PCB is found in WQ, and RQ, print invalid PID as an error message.
+	printf("Invalid Process ID");
+	return;
+}
+
+
+/*******************************************************************************
+ * Function: CompleteInputOperation
+ *
+ * Description: Finishes the io_getc or io_read of a process already removed
+ * 				from the WQ. Reads one character into GPR1 of the PCB for
+ * 				io_getc and makes the process ready again.
+ *
+ * Input Parameters
+ * 	- PCBptr			PCB of the process waiting on input
+ *
+ * Output Parameters: N/A
+ *
+ * Function Return Value: N/A
+ ******************************************************************************/
+
+void CompleteInputOperation(long PCBptr)
+{
+	// Read one character from standard input device keyboard; io_read
+	// already stored its line
+	if (ProcReason[PCBSlot(PCBptr)] == InputCompletion) {
+		if (InteractiveMode)
+			printf("Enter a character: ");
+		mem[PCBptr + PCB_GPR1] = getchar();
+	}
+
+	// Set the process state to Ready in the PCB and insert PCB into RQ
+	ProcState[PCBSlot(PCBptr)] = Ready;
+	InsertIntoRQ(&PCBptr);
+}
+
+
+/*******************************************************************************
+ * Function: CompleteOutputOperation
+ *
+ * Description: Finishes the io_putc or io_write of a process already
+ * 				removed from the WQ. Displays the character in GPR1 of the
+ * 				PCB for io_putc and makes the process ready again.
+ *
+ * Input Parameters
+ * 	- PCBptr			PCB of the process waiting on output
+ *
+ * Output Parameters: N/A
+ *
+ * Function Return Value: N/A
+ ******************************************************************************/
+
+void CompleteOutputOperation(long PCBptr)
+{
+	// Io_write already wrote its buffer
+	if (ProcReason[PCBSlot(PCBptr)] == OutputCompletion)
+		putchar((char)mem[PCBptr + PCB_GPR1]);
+
+	// Set the process state to Ready in the PCB and insert PCB into RQ
+	ProcState[PCBSlot(PCBptr)] = Ready;
+	InsertIntoRQ(&PCBptr);
+}
+
+
+/*******************************************************************************
+ * Function: WaitingForIO
+ *
+ * Description: Tells whether a process in the WQ waits for an I/O
+ * 				completion interrupt, rather than for a child, a message or
+ * 				a timer.
+ *
+ * Input Parameters
+ * 	- PCBptr			PCB of the waiting process
+ *
+ * Output Parameters: N/A
+ *
+ * Function Return Value
+ * 	- Non-zero for an io_getc or io_putc
+ ******************************************************************************/
+
+int WaitingForIO(long PCBptr)
+{
+	return ProcReason[PCBSlot(PCBptr)] == InputCompletion ||
+		ProcReason[PCBSlot(PCBptr)] == OutputCompletion ||
+		ProcReason[PCBSlot(PCBptr)] == BlockInputCompletion ||
+		ProcReason[PCBSlot(PCBptr)] == BlockOutputCompletion;
+}
+
+
+/*******************************************************************************
+ * Function: RaiseBatchInterrupts
+ *
+ * Description: Interrupt source used in batch mode in place of the keyboard
+ * 				prompt. Every I/O request in the WQ completes immediately,
+ * 				processes waiting for a child, a message or the disk keep
+ * 				waiting, and the system shuts down once only the null
+ * 				process is left and no process sleeps or waits for the
+ * 				disk.
+ *
+ * Input Parameters: N/A
+ *
+ * Output Parameters: N/A
+ *
+ * Function Return Value: N/A
+ ******************************************************************************/
+
+void RaiseBatchInterrupts()
+{
+	long PCBptr = WQ, next;
+
+	// Complete every pending I/O operation, waits for a child stay
+	WQ = EndOfList;
+	for (; PCBptr != EndOfList; PCBptr = next) {
+		next = NextPCB(PCBptr);
+		SetNextPCB(PCBptr, EndOfList);
+
+		if (!WaitingForIO(PCBptr))
+			InsertIntoWQ(&PCBptr);
+		else if (ProcReason[PCBSlot(PCBptr)] == InputCompletion ||
+				ProcReason[PCBSlot(PCBptr)] == BlockInputCompletion)
+			CompleteInputOperation(PCBptr);
+		else
+			CompleteOutputOperation(PCBptr);
+	}
+
+	// Null process has the lowest priority, so it is last in RQ. Sleeping
+	// processes and disk requests keep the system up until they complete.
+	if ((RQ == EndOfList || RQ == NullProcessPtr) && !TimerWaiters() && !DiskWaiters()) {
+		ISRshutdownSystem();
+		SysShutdownStatus = 1;
+	}
+}
+
+
+/*******************************************************************************
+ * Function: SearchAndRemovePCBfromWQ
+ *
+ * Description: Search the WQ for the matching PID.
+ * 				When a match is found remove it from WQ and return PCB pointer.
+ * 				If no match is found, return invalid PID error code.
+ *
+ * Input Parameters: N/A
+ *
+ * Output Parameters: N/A
+ *
+ * Function Return Value: N/A
+ *
+ * Initial implementation by Douglas Perkins
+ ******************************************************************************/
+long SearchAndRemovePCBfromWQ(long ProcessID){
+
+	long currentPCBptr = WQ;
+	long previousPCBptr = EndOfList;
+
+	// Search WQ for a PCB that has the given PID
+	// If a match is found, remove it from WQ and return the PCB pointer.
+	while(currentPCBptr != EndOfList){
+		if(ProcPid[PCBSlot(currentPCBptr)] == ProcessID){
+			// match found, remove from WQ
+			if (previousPCBptr == EndOfList){
+				// first PCB
+				WQ = NextPCB(currentPCBptr);
+			}
+			else
+			{
+				// not first PCB
+				SetNextPCB(previousPCBptr, NextPCB(currentPCBptr));
+			}
+			SetNextPCB(currentPCBptr, EndOfList);
+			return(currentPCBptr);
+		}
+		previousPCBptr = currentPCBptr;
+		currentPCBptr = NextPCB(currentPCBptr);
+	}
+
+	return(EndOfList);
+}
+
+/*******************************************************************************
+ * Function: FindPCB
+ *
+ * Description: Searches a queue for the PCB having the given PID.
+ *
+ * Input Parameters
+ * 	- Qptr				First PCB of the queue
+ * 	- ProcessID			PID to find
+ *
+ * Output Parameters: N/A
+ *
+ * Function Return Value
+ * 	- PCB pointer, or EndOfList
+ ******************************************************************************/
+long FindPCB(long Qptr, long ProcessID)
+{
+	for (; Qptr != EndOfList; Qptr = NextPCB(Qptr))
+		if (ProcPid[PCBSlot(Qptr)] == ProcessID)
+			return Qptr;
+	return EndOfList;
+}
+
+
+/*******************************************************************************
+ * Function: FindChild
+ *
+ * Description: Searches a queue for a child of the given process.
+ *
+ * Input Parameters
+ * 	- Qptr				First PCB of the queue
+ * 	- ParentID			PID of the parent
+ * 	- ProcessID			PID of the child, 0 for any child
+ *
+ * Output Parameters: N/A
+ *
+ * Function Return Value
+ * 	- PCB pointer, or EndOfList
+ ******************************************************************************/
+long FindChild(long Qptr, long ParentID, long ProcessID)
+{
+	for (; Qptr != EndOfList; Qptr = NextPCB(Qptr))
+		if (mem[Qptr + PCB_Parent] == ParentID &&
+				(ProcessID == 0 || ProcPid[PCBSlot(Qptr)] == ProcessID))
+			return Qptr;
+	return EndOfList;
+}
+
+
+/*******************************************************************************
+ * Function: RemoveFromQueue
+ *
+ * Description: Unlinks a PCB from a queue.
+ *
+ * Input Parameters
+ * 	- Qptr				Queue head
+ * 	- PCBptr			PCB to remove
+ *
+ * Output Parameters
+ * 	- Qptr				Updated when the PCB was first
+ *
+ * Function Return Value
+ * 	- OK, or EndOfList when the PCB is not in the queue
+ ******************************************************************************/
+long RemoveFromQueue(long *Qptr, long PCBptr)
+{
+	long PreviousPtr = EndOfList;
+
+	for (long CurrentPtr = *Qptr; CurrentPtr != EndOfList; CurrentPtr = NextPCB(CurrentPtr)) {
+		if (CurrentPtr == PCBptr) {
+			if (PreviousPtr == EndOfList)
+				*Qptr = NextPCB(PCBptr);
+			else
+				SetNextPCB(PreviousPtr, NextPCB(PCBptr));
+			SetNextPCB(PCBptr, EndOfList);
+			return OK;
+		}
+		PreviousPtr = CurrentPtr;
+	}
+	return EndOfList;
+}
+
+
+
+/*******************************************************************************
+ * Function: ISRshutdownSystem
+ *
+ * Description: Terminate all Processes in RQ so that the system can shut down
+ *
+ * Input Parameters:
+ * 	- None
+ *
+ * Output Parameters:
+ * 	- None
+ *
+ * Function Return Value:
+ * 	- None
+ *
+ * Initial implementation by Douglas Perkins
+ ******************************************************************************/
+void ISRshutdownSystem(){
+
+	// Terminate all processes in RQ one by one.
+	long PCBptr = RQ;
+
+	// A terminating child wakes a waiting parent into RQ, so repeat
+	while (RQ != EndOfList || WQ != EndOfList) {
+		PCBptr = RQ;
+		while(PCBptr != EndOfList){
+			RQ = NextPCB(PCBptr);
+			TerminateProcess(PCBptr);
+			PCBptr = RQ;
+		}
+
+		// Terminate all processes in WQ one by one.
+		PCBptr = WQ;
+		while(PCBptr != EndOfList){
+			WQ = NextPCB(PCBptr);
+			TerminateProcess(PCBptr);
+			PCBptr = WQ;
+		}
+	}
+
+	return;
+}
+
+/*******************************************************************************
+ * Function: IOGetC
+ *
+ * Description: Requests one character from the user. Forces rescheduling, the
+ * character is read by the input completion interrupt.
+ *
+ * Input Parameters: None
+ *
+ * Output Parameters
+ * 		1. R0 = return code, always OK.
+ * 		2. R1 = the character read (stored on input completion)
+ *
+ * Function Return Value
+ * 		StartOfInput
+ *
+ * Initial implementation by Douglas Perkins
+ ******************************************************************************/
+
+long IOGetCSystemCall()
+{
+	gpr[0] = OK;
+	return StartOfInput;
+}
+
+/*******************************************************************************
+ * Function: IOPutC
+ *
+ * Description: Specifies a character to be printed on the user terminal.
+ * Forces rescheduling, the character is displayed by the output completion
+ * interrupt.
+ *
+ * Input Parameters: R1 = character to be displayed
+ *
+ * Output Parameters
+ * 		1. R0 = return code, always OK
+ *
+ * Function Return Value
+ * 		StartOfOutput
+ *
+ * Initial implementation by Douglas Perkins
+ ******************************************************************************/
+
+long IOPutCSystemCall()
+{
+	gpr[0] = OK;
+	return StartOfOutput;
+}
+
+/*******************************************************************************
+ * Function: TranslateBuffer
+ *
+ * Description: Translates every word of a user buffer before a block
+ * transfer, so that a page fault restarts the system call before any data
+ * has moved.
+ *
+ * Input Parameters
+ *      Address				Program address of the buffer
+ *      Length				Words in the buffer, at most MAX_IO_BLOCK
+ *
+ * Output Parameters
+ *      Physical			Physical address of each word
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorInvalidAddress		-Buffer outside the program or heap
+ *      ErrorPageFault
+ ******************************************************************************/
+
+long TranslateBuffer(long Address, long Length, long *Physical)
+{
+	if (Length < 0 || Length > MAX_IO_BLOCK) {
+		printf("ERROR: Invalid I/O length %ld\n", Length);
+		return ErrorInvalidAddress;
+	}
+	for (long i = 0; i < Length; i++) {
+		Physical[i] = Translate(Address + i);
+		if (Physical[i] == ErrorPageFault)
+			return ErrorPageFault;
+		if (Physical[i] < 0) {
+			printf("ERROR: Invalid I/O buffer address %ld\n", Address + i);
+			return ErrorInvalidAddress;
+		}
+	}
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: IOReadSystemCall
+ *
+ * Description: Reads one line, or as much of it as fits, from the console
+ * into a user buffer, one character per word. The whole buffer is one
+ * request: the process waits in the WQ once, and the input completion
+ * interrupt only wakes it.
+ *
+ * Input Parameters
+ *      R1 = address of the buffer
+ *      R2 = words in the buffer, at most MAX_IO_BLOCK
+ *
+ * Output Parameters
+ * 		1. R0 = return code
+ * 		2. R2 = characters read, newline included; 0 at end of input
+ *
+ * Function Return Value
+ * 		StartOfBlockInput
+ * 		ErrorPageFault
+ * 		ErrorInvalidAddress
+ * 		ErrorNoFreeMemory		-No room for a copy on write
+ ******************************************************************************/
+
+long IOReadSystemCall()
+{
+	static long Physical[MAX_IO_BLOCK];
+	char line[MAX_IO_BLOCK + 1];
+	long count = 0;
+
+	gpr[0] = TranslateBuffer(gpr[1], gpr[2], Physical);
+	if (gpr[0] == ErrorPageFault)
+		return ErrorPageFault;
+	if (gpr[0] != OK)
+		return gpr[0];
+
+	// A copy on write moves the process, so the rest of the buffer is
+	// translated again, as BlockInstruction does
+	for (long i = 0; i < gpr[2]; i++)
+		if (SharedMemory[Physical[i]]) {
+			gpr[0] = WritableWord(Physical[i]);
+			if (gpr[0] < 0)
+				return gpr[0];
+			gpr[0] = TranslateBuffer(gpr[1], gpr[2], Physical);
+			if (gpr[0] != OK)
+				return gpr[0];
+		}
+
+	if (InteractiveMode)
+		printf("Enter a line: ");
+	if (gpr[2] > 0 && fgets(line, gpr[2] + 1, stdin) != NULL)
+		count = strlen(line);
+	for (long i = 0; i < count && gpr[0] == OK; i++)
+		gpr[0] = StoreMemory(Physical[i], (unsigned char)line[i]);
+	gpr[2] = count;
+	BlockTransfers++;
+	return gpr[0] == OK ? StartOfBlockInput : gpr[0];
+}
+
+/*******************************************************************************
+ * Function: IOWriteSystemCall
+ *
+ * Description: Writes a user buffer, one character per word, to the console
+ * through the host stdio buffer. The whole buffer is one request: the
+ * process waits in the WQ once, and the output completion interrupt only
+ * wakes it.
+ *
+ * Input Parameters
+ *      R1 = address of the buffer
+ *      R2 = characters to write, at most MAX_IO_BLOCK
+ *
+ * Output Parameters
+ * 		1. R0 = return code
+ *
+ * Function Return Value
+ * 		StartOfBlockOutput
+ * 		ErrorPageFault
+ * 		ErrorInvalidAddress
+ ******************************************************************************/
+
+long IOWriteSystemCall()
+{
+	static long Physical[MAX_IO_BLOCK];
+	char line[MAX_IO_BLOCK];
+
+	gpr[0] = TranslateBuffer(gpr[1], gpr[2], Physical);
+	if (gpr[0] == ErrorPageFault)
+		return ErrorPageFault;
+	if (gpr[0] != OK)
+		return gpr[0];
+
+	for (long i = 0; i < gpr[2]; i++)
+		line[i] = (char)mem[Physical[i]];
+	fwrite(line, 1, gpr[2], stdout);
+	BlockTransfers++;
+	return StartOfBlockOutput;
+}
+
+/*******************************************************************************
+ * Function: OpenDisk
+ *
+ * Description: Attaches the host file holding the disk blocks, creating it
+ * or growing it to DISK_BLOCKS blocks of zeros.
+ *
+ * Input Parameters
+ *      filename			Path of the host file
+ *
+ * Output Parameters
+ *      DiskFile
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorFileOpen
+ ******************************************************************************/
+
+long OpenDisk(char *filename)
+{
+	off_t size = (off_t)DISK_BLOCKS * DISK_BLOCK_SIZE * sizeof(long);
+	struct stat info;
+
+	DiskFile = open(filename, O_RDWR | O_CREAT, 0644);
+	if (DiskFile < 0 || fstat(DiskFile, &info) != 0 ||
+			(info.st_size < size && ftruncate(DiskFile, size) != 0)) {
+		printf("ERROR: Unable to open disk %s\n", filename);
+		return ErrorFileOpen;
+	}
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: DiskRequestSystemCall
+ *
+ * Description: Queues a disk_read or disk_write of one block. The process
+ * waits in the WQ until the disk completion interrupt; the data moves by
+ * DMA when the request completes, not now. The buffer must be a heap
+ * block, which is at the same physical address under every memory model
+ * and is never paged or copied, so it stays put while the request waits.
+ *
+ * Input Parameters
+ *      Write				Non-zero for disk_write
+ *      R1 = block number
+ *      R2 = address of a DISK_BLOCK_SIZE word heap buffer
+ *
+ * Output Parameters
+ * 		1. R0 = return code, set on completion for a queued request
+ *
+ * Function Return Value
+ * 		StartOfDiskIO
+ * 		ErrorNoDevice
+ * 		ErrorInvalidAddress
+ * 		ErrorNoFreeMemory		-Request queue full
+ ******************************************************************************/
+
+long DiskRequestSystemCall(int Write)
+{
+	long block = gpr[1], buffer = gpr[2];
+
+	if (DiskFile < 0) {
+		printf("ERROR: No disk attached\n");
+		gpr[0] = ErrorNoDevice;
+		return gpr[0];
+	}
+	if (block < 0 || block >= DISK_BLOCKS) {
+		printf("ERROR: Invalid disk block %ld\n", block);
+		gpr[0] = ErrorInvalidAddress;
+		return gpr[0];
+	}
+	if (buffer <= MAX_USER_MEMORY || buffer + DISK_BLOCK_SIZE - 1 > MAX_HEAP_MEMORY) {
+		printf("ERROR: Disk buffer %ld is not in the heap\n", buffer);
+		gpr[0] = ErrorInvalidAddress;
+		return gpr[0];
+	}
+	if (DiskFreeList == EndOfList) {
+		printf("ERROR: Disk request queue full\n");
+		gpr[0] = ErrorNoFreeMemory;
+		return gpr[0];
+	}
+
+	long request = DiskFreeList;
+	DiskFreeList = DiskNext[request];
+	DiskBlock[request] = block;
+	DiskBuffer[request] = buffer;
+	DiskWrite[request] = Write;
+	DiskOwner[request] = RunningPCB;
+	DiskQueued[request] = clock;
+	DiskNext[request] = EndOfList;
+
+	long *tail = &DiskPending;
+	while (*tail != EndOfList)
+		tail = &DiskNext[*tail];
+	*tail = request;
+	if (DiskActive == EndOfList)
+		StartDiskRequest(clock);
+
+	gpr[0] = OK;
+	return StartOfDiskIO;
+}
+
+/*******************************************************************************
+ * Function: StartDiskRequest
+ *
+ * Description: The controller takes the next pending request, if any, and
+ * works out when it completes: a seek of DISK_SETTLE_TIME plus
+ * DISK_SEEK_TIME per track, the wait for the sector to come under the
+ * head, and one sector time to transfer it. DISK_FCFS takes the oldest
+ * request; DISK_LOOK takes the nearest one in the direction of the sweep,
+ * the oldest of those on the same track, and reverses when there is none.
+ *
+ * Input Parameters
+ *      Now				Clock at which the controller is free
+ *
+ * Output Parameters
+ *      DiskActive, DiskDone
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void StartDiskRequest(long Now)
+{
+	long request = DiskPending;
+
+	if (request == EndOfList)
+		return;
+
+	if (DiskPolicy == DISK_LOOK) {
+		request = EndOfList;
+		for (int sweep = 0; sweep < 2 && request == EndOfList; sweep++) {
+			long nearest = DISK_BLOCKS;
+			for (long r = DiskPending; r != EndOfList; r = DiskNext[r]) {
+				long distance = (DiskBlock[r] / DISK_TRACK_BLOCKS - DiskTrack) * DiskDirection;
+				if (distance >= 0 && distance < nearest) {
+					nearest = distance;
+					request = r;
+				}
+			}
+			if (request == EndOfList)
+				DiskDirection = -DiskDirection;
+		}
+	}
+
+	long *link = &DiskPending;
+	while (*link != request)
+		link = &DiskNext[*link];
+	*link = DiskNext[request];
+
+	long track = DiskBlock[request] / DISK_TRACK_BLOCKS;
+	long tracks = labs(track - DiskTrack);
+	long arrival = Now + (tracks ? DISK_SETTLE_TIME + tracks * DISK_SEEK_TIME : 0);
+	long sector = (arrival + DISK_SECTOR_TIME - 1) / DISK_SECTOR_TIME;
+	long rotation = (DiskBlock[request] % DISK_TRACK_BLOCKS - sector % DISK_TRACK_BLOCKS +
+			DISK_TRACK_BLOCKS) % DISK_TRACK_BLOCKS;
+
+	DiskDone = (sector + rotation + 1) * DISK_SECTOR_TIME;
+	DiskTrack = track;
+	DiskSeekTracks += tracks;
+	DiskActive = request;
+}
+
+/*******************************************************************************
+ * Function: ISRdiskCompletionInterrupt
+ *
+ * Description: Completes every disk request whose time has passed. The block
+ * is moved between the host file and the heap buffer without the CPU, the
+ * process that made the request is moved from the WQ to the RQ with the
+ * return code in GPR0, and the controller starts the next request at the
+ * clock the last one finished. A block read drops the verifier marks of
+ * the words and dirties their heap pages, as a store would.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void ISRdiskCompletionInterrupt()
+{
+	ssize_t bytes = DISK_BLOCK_SIZE * sizeof(long);
+
+	while (DiskActive != EndOfList && clock >= DiskDone) {
+		long request = DiskActive;
+		long PCBptr = DiskOwner[request];
+		long buffer = DiskBuffer[request];
+		off_t offset = (off_t)DiskBlock[request] * bytes;
+		long status = OK;
+
+		// A process that died no longer owns the buffer
+		if (PCBptr != EndOfList) {
+			if (DiskWrite[request] ?
+					pwrite(DiskFile, &mem[buffer], bytes, offset) != bytes :
+					pread(DiskFile, &mem[buffer], bytes, offset) != bytes) {
+				printf("ERROR: Disk transfer of block %ld failed\n", DiskBlock[request]);
+				status = ErrorRuntime;
+			}
+			for (long i = 0; i < DISK_BLOCK_SIZE && !DiskWrite[request]; i++) {
+				if (VerifiedCode[buffer + i])
+					UnverifyWord(buffer + i);
+				HeapDirty[(buffer + i) / PAGE_SIZE] = 1;
+			}
+		}
+		if (PCBptr != EndOfList && ProcState[PCBSlot(PCBptr)] == Waiting &&
+				ProcReason[PCBSlot(PCBptr)] == DiskCompletion) {
+			SearchAndRemovePCBfromWQ(ProcPid[PCBSlot(PCBptr)]);
+			mem[PCBptr + PCB_GPR0] = status;
+			ProcState[PCBSlot(PCBptr)] = Ready;
+			InsertIntoRQ(&PCBptr);
+		}
+
+		DiskRequests++;
+		DiskServiceClock += DiskDone - DiskQueued[request];
+		DiskNext[request] = DiskFreeList;
+		DiskFreeList = request;
+		DiskActive = EndOfList;
+		StartDiskRequest(DiskDone);
+	}
+}
+
+/*******************************************************************************
+ * Function: CancelDiskRequests
+ *
+ * Description: Drops the pending disk requests of a terminating process. A
+ * request already being served still occupies the disk but moves no data.
+ *
+ * Input Parameters
+ *      PCBptr				PCB of the process
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void CancelDiskRequests(long PCBptr)
+{
+	long *link = &DiskPending;
+
+	while (*link != EndOfList) {
+		long request = *link;
+		if (DiskOwner[request] != PCBptr) {
+			link = &DiskNext[request];
+			continue;
+		}
+		*link = DiskNext[request];
+		DiskNext[request] = DiskFreeList;
+		DiskFreeList = request;
+	}
+	if (DiskActive != EndOfList && DiskOwner[DiskActive] == PCBptr)
+		DiskOwner[DiskActive] = EndOfList;
+}
+
+/*******************************************************************************
+ * Function: DiskWaiters
+ *
+ * Description: Tells whether a process waits for the disk.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      Non-zero when one does
+ ******************************************************************************/
+
+int DiskWaiters()
+{
+	return DiskPending != EndOfList ||
+		(DiskActive != EndOfList && DiskOwner[DiskActive] != EndOfList);
+}
+
+/*******************************************************************************
+ * Function: MmapSystemCall
+ *
+ * Description: Maps a region of a host file into a new heap block, one
+ * character per word as io_read stores them, so that the program reads and
+ * writes the file with ordinary loads and stores. The heap is at the same
+ * address under every memory model. Stores mark the heap pages they touch
+ * dirty; munmap, or the exit of the process, writes the dirty pages of the
+ * mapping back to the file. A forked child does not inherit the mapping.
+ *
+ * Input Parameters
+ *      R1 = address of the file name, one character per word, 0 terminated
+ *      R2 = offset of the region in the file
+ *      R3 = characters to map, 0 for the rest of the file
+ *
+ * Output Parameters
+ * 		1. R0 = return code
+ * 		2. R1 = address of the mapping, EndOfList when nothing is mapped
+ * 		3. R3 = characters mapped, cut at the end of the file; 0 past
+ * 		   the end of the file or on an error
+ *
+ * Function Return Value
+ * 		OK
+ * 		ErrorPageFault
+ * 		ErrorInvalidAddress
+ * 		ErrorFileOpen
+ * 		ErrorInvalidMemorySize
+ * 		ErrorNoFreeMemory		-Heap or mapping table full
+ ******************************************************************************/
+
+long MmapSystemCall()
+{
+	static char text[MAX_HEAP_MEMORY - MAX_USER_MEMORY];
+	char filename[MAX_FILENAME];
+	long entry, name = gpr[1], offset = gpr[2], size = gpr[3];
+	struct stat info;
+	int fd;
+
+	// Nothing is mapped on an error
+	gpr[1] = EndOfList;
+	gpr[3] = 0;
+
+	// The name is read before anything is done, so a page fault restarts the call
+	for (long i = 0; i < MAX_FILENAME; i++) {
+		long addr = Translate(name + i);
+		if (addr == ErrorPageFault)
+			return ErrorPageFault;
+		if (addr < 0 || (i == MAX_FILENAME - 1 && mem[addr] != 0)) {
+			printf("ERROR: Invalid file name address %ld\n", name + i);
+			gpr[0] = ErrorInvalidAddress;
+			return gpr[0];
+		}
+		filename[i] = (char)mem[addr];
+		if (filename[i] == 0)
+			break;
+	}
+
+	for (entry = 0; entry < MAX_MAPPINGS; entry++)
+		if (MapFile[entry] < 0)
+			break;
+	if (entry == MAX_MAPPINGS) {
+		printf("ERROR: Mapping table full\n");
+		gpr[0] = ErrorNoFreeMemory;
+		return gpr[0];
+	}
+
+	fd = open(filename, O_RDWR);
+	if (fd < 0 || fstat(fd, &info) != 0) {
+		printf("ERROR: Unable to map file %s\n", filename);
+		if (fd >= 0)
+			close(fd);
+		gpr[0] = ErrorFileOpen;
+		return gpr[0];
+	}
+	if (offset < 0 || size < 0 || size > MAX_HEAP_MEMORY - MAX_USER_MEMORY) {
+		printf("ERROR: Invalid mapping of %ld characters at %ld\n", size, offset);
+		close(fd);
+		gpr[0] = ErrorInvalidMemorySize;
+		return gpr[0];
+	}
+	if (size == 0 || offset + size > info.st_size)
+		size = info.st_size > offset ? info.st_size - offset : 0;
+	if (size == 0) {
+		close(fd);
+		gpr[0] = OK;
+		return gpr[0];
+	}
+	if (size > MAX_HEAP_MEMORY - MAX_USER_MEMORY)
+		size = MAX_HEAP_MEMORY - MAX_USER_MEMORY;
+
+	long block = AllocateUserMemory(size < 2 ? 2 : size);
+	if (block < 0 || pread(fd, text, size, offset) != size) {
+		if (block >= 0) {
+			printf("ERROR: Unable to read file %s\n", filename);
+			FreeUserMemory(block, size < 2 ? 2 : size);
+		}
+		close(fd);
+		gpr[0] = block < 0 ? ErrorNoFreeMemory : ErrorFileOpen;
+		return gpr[0];
+	}
+
+	for (long i = 0; i < size; i++) {
+		if (VerifiedCode[block + i])
+			UnverifyWord(block + i);
+		mem[block + i] = (unsigned char)text[i];
+	}
+	// Pages wholly inside the block belong to no other mapping
+	for (long page = (block + PAGE_SIZE - 1) / PAGE_SIZE;
+			(page + 1) * PAGE_SIZE <= block + size; page++)
+		HeapDirty[page] = 0;
+
+	MapFile[entry] = fd;
+	MapOwner[entry] = RunningPCB;
+	MapAddress[entry] = block;
+	MapSize[entry] = size;
+	MapOffset[entry] = offset;
+	FilesMapped++;
+
+	gpr[0] = OK;
+	gpr[1] = block;
+	gpr[3] = size;
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: MunmapSystemCall
+ *
+ * Description: Writes back and removes a mapping made by mmap.
+ *
+ * Input Parameters
+ *      R1 = address of the mapping
+ *
+ * Output Parameters
+ * 		1. R0 = return code
+ *
+ * Function Return Value
+ * 		OK
+ * 		ErrorInvalidAddress		-No mapping of the process there
+ * 		ErrorRuntime			-Write-back failed
+ ******************************************************************************/
+
+long MunmapSystemCall()
+{
+	for (long entry = 0; entry < MAX_MAPPINGS; entry++)
+		if (MapFile[entry] >= 0 && MapOwner[entry] == RunningPCB &&
+				MapAddress[entry] == gpr[1]) {
+			gpr[0] = UnmapFile(entry);
+			return gpr[0];
+		}
+
+	printf("ERROR: No mapping at %ld\n", gpr[1]);
+	gpr[0] = ErrorInvalidAddress;
+	return gpr[0];
+}
+
+/*******************************************************************************
+ * Function: UnmapFile
+ *
+ * Description: Writes the dirty pages of a mapping back to its file, one
+ * character per word, then closes the file and frees the heap block. Only
+ * the part of a page inside the mapping is written.
+ *
+ * Input Parameters
+ *      entry				Mapping table entry
+ *
+ * Output Parameters
+ *      None
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorRuntime			-Write-back failed
+ ******************************************************************************/
+
+long UnmapFile(long entry)
+{
+	char text[PAGE_SIZE];
+	long block = MapAddress[entry], size = MapSize[entry];
+	long status = OK;
+
+	for (long page = block / PAGE_SIZE; page * PAGE_SIZE < block + size; page++) {
+		if (!HeapDirty[page])
+			continue;
+		long from = page * PAGE_SIZE > block ? page * PAGE_SIZE : block;
+		long to = (page + 1) * PAGE_SIZE < block + size ? (page + 1) * PAGE_SIZE : block + size;
+		for (long i = from; i < to; i++)
+			text[i - from] = (char)mem[i];
+		if (pwrite(MapFile[entry], text, to - from, MapOffset[entry] + from - block) != to - from) {
+			printf("ERROR: Write-back of mapped page %ld failed\n", page);
+			status = ErrorRuntime;
+		}
+		if (from == page * PAGE_SIZE && to == (page + 1) * PAGE_SIZE)
+			HeapDirty[page] = 0;
+		MappedWriteBacks++;
+	}
+
+	close(MapFile[entry]);
+	MapFile[entry] = -1;
+	FreeUserMemory(block, size < 2 ? 2 : size);
+	return status;
+}
+
+/*******************************************************************************
+ * Function: HostTimeNanoseconds
+ *
+ * Description: Reads the host monotonic clock, which steps neither with
+ * NTP nor with date changes. Used only for statistics, the simulated time
+ * is kept in `clock`.
+ *
+ * Input Parameters: None
+ *
+ * Output Parameters: None
+ *
+ * Function Return Value
+ * 		Host time in nanoseconds
+ ******************************************************************************/
+
+long HostTimeNanoseconds()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/*******************************************************************************
+ * Function: OpenStatistics
+ *
+ * Description: Creates the shared memory object of the statistics page and
+ * maps it. An object left by an earlier run is truncated.
+ *
+ * Input Parameters
+ *      name				POSIX shared memory object, e.g. /hypo
+ *
+ * Output Parameters
+ *      Stats
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorFileOpen			-Unable to create or map the object
+ ******************************************************************************/
+
+long OpenStatistics(char *name)
+{
+	int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+	if (fd < 0 || ftruncate(fd, sizeof(struct StatsPage)) != 0) {
+		printf("ERROR: Unable to create statistics page %s\n", name);
+		if (fd >= 0)
+			close(fd);
+		return ErrorFileOpen;
+	}
+	void *page = mmap(NULL, sizeof(struct StatsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (page == MAP_FAILED) {
+		printf("ERROR: Unable to map statistics page %s\n", name);
+		shm_unlink(name);
+		return ErrorFileOpen;
+	}
+
+	Stats = page;		// Zeroed by ftruncate
+	Stats->Version = STATS_VERSION;
+	Stats->MachineWords = MACHINE_WORDS;
+	Stats->Processes = MAX_PROCESSES;
+	PublishStatistics(1);
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: PublishStatistics
+ *
+ * Description: Writes the statistics page between two increments of its
+ * sequence number. The clock and the instruction, context switch and
+ * system call counts are copied every time; the system calls by ID, the
+ * queues, free lists and process table when Walk is set or STATS_PERIOD
+ * of clock has passed since the last walk, so a scheduling pass costs a
+ * few stores. Nothing here waits for the readers.
+ *
+ * Input Parameters
+ *      Walk				Non-zero to walk whatever the clock
+ *
+ * Output Parameters
+ *      Stats
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void PublishStatistics(int Walk)
+{
+	unsigned long sequence = Stats->Sequence;
+
+	// Odd: a reader copying now retries
+	__atomic_store_n(&Stats->Sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	Stats->Running = SysShutdownStatus != 1;
+	Stats->Clock = clock;
+	Stats->Instructions = InstructionCount;
+	Stats->ContextSwitches = ContextSwitchCount;
+	Stats->SystemCalls = SystemCallCount;
+
+	if (Walk || clock >= StatsWalkClock) {
+		memcpy(Stats->SystemCallsByID, SystemCallsByID, sizeof(SystemCallsByID));
+		long count = 0;
+		for (long PCBptr = RQ; PCBptr != EndOfList; PCBptr = NextPCB(PCBptr))
+			count++;
+		Stats->ReadyCount = count;
+		count = 0;
+		for (long PCBptr = WQ; PCBptr != EndOfList; PCBptr = NextPCB(PCBptr))
+			count++;
+		Stats->WaitCount = count;
+
+		Stats->UserFreeWords = FreeListWords(UserFreeList, &Stats->UserFreeBlocks);
+		Stats->OSFreeWords = FreeListWords(OSFreeList, &Stats->OSFreeBlocks);
+		Stats->ProgramFreeWords = FreeListWords(ProgramFreeList, &Stats->ProgramFreeBlocks);
+
+		for (long slot = 0; slot < MAX_PROCESSES; slot++) {
+			struct StatsProcess *process = &Stats->Process[slot];
+			process->Pid = ProcPCB[slot] == EndOfList ? 0 : ProcPid[slot];
+			process->State = ProcState[slot];
+			process->Reason = ProcReason[slot];
+			process->Priority = ProcPriority[slot];
+		}
+		StatsWalkClock = clock + STATS_PERIOD;
+	}
+
+	__atomic_store_n(&Stats->Sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+/*******************************************************************************
+ * Function: FreeListWords
+ *
+ * Description: Adds up the blocks of a free list, each holding the next
+ * block and its size in its first two words.
+ *
+ * Input Parameters
+ *      List				First free block, or EndOfList
+ *
+ * Output Parameters
+ *      Blocks				Blocks in the list
+ *
+ * Function Return Value
+ *      Free words in the list
+ ******************************************************************************/
+
+long FreeListWords(long List, long *Blocks)
+{
+	long words = 0, blocks = 0;
+
+	for (long ptr = List; ptr != EndOfList; ptr = mem[ptr]) {
+		words += mem[ptr + 1];
+		blocks++;
+	}
+	*Blocks = blocks;
+	return words;
+}
+
+/*******************************************************************************
+ * Function: CloseStatistics
+ *
+ * Description: Publishes the final statistics, which show the OS stopped,
+ * and removes the shared memory object. Readers still mapping it keep the
+ * last page.
+ *
+ * Input Parameters
+ *      None
+ *
+ * Output Parameters
+ *      Stats				NULL
+ *
+ * Function Return Value
+ *      None
+ ******************************************************************************/
+
+void CloseStatistics()
+{
+	PublishStatistics(1);
+	munmap(Stats, sizeof(struct StatsPage));
+	shm_unlink(StatsName);
+	Stats = NULL;
+}
+
+/*******************************************************************************
+ * Function: PrintStatistics
+ *
+ * Description: Displays the counters gathered while the system was running.
+ * One "name: value" pair per line, read by tools/benchmark.py.
+ *
+ * Input Parameters: None
+ *
+ * Output Parameters: None
+ *
+ * Function Return Value: None
+ ******************************************************************************/
+
+void PrintStatistics()
+{
+	printf("Simulation Statistics\n");
+	printf("Engine: %s\n", LaneCount ? "lockstep" : Engine->Name);
+	printf("Machine words: %d\n", MACHINE_WORDS);
+	if (LaneCount) {
+		printf("Lanes: %ld\n", LaneCount);
+		printf("Lane steps: %ld\n", LaneSteps);
+	}
+	printf("Instructions: %ld\n", InstructionCount);
+	printf("Simulated clock: %ld\n", clock);
+	printf("Context switches: %ld\n", ContextSwitchCount);
+	printf("Context restores skipped: %ld\n", ContextReuses);
+	printf("Verified instructions: %ld\n", VerifiedCount);
+	if (Engine->Run == NativeCPU)
+		printf("Native instructions: %ld\n", NativeCount);
+	printf("Image cache hits: %ld\n", ImageHits);
+	printf("Image cache misses: %ld\n", ImageMisses);
+	printf("Processes forked: %ld\n", ForkCount);
+	printf("Messages sent: %ld\n", MessagesSent);
+	printf("Message latency clock: %ld\n",
+			MessagesReceived ? MessageLatency / MessagesReceived : 0);
+	printf("Timer expiries: %ld\n", TimerExpiries);
+	printf("Idle clock: %ld\n", IdleClock);
+	printf("System calls: %ld\n", SystemCallCount);
+	printf("Block transfers: %ld\n", BlockTransfers);
+	printf("Disk requests: %ld\n", DiskRequests);
+	printf("Disk seek tracks: %ld\n", DiskSeekTracks);
+	printf("Disk service clock: %ld\n",
+			DiskRequests ? DiskServiceClock / DiskRequests : 0);
+	printf("Files mapped: %ld\n", FilesMapped);
+	printf("Mapped pages written back: %ld\n", MappedWriteBacks);
+	if (MemoryModel == MMU_SEGMENT)
+		printf("Copies on write: %ld\n", CopiesOnWrite);
+	if (MemoryModel == MMU_PAGED) {
+		printf("TLB hits: %ld\n", TLBHits);
+		printf("TLB misses: %ld\n", TLBMisses);
+		printf("Page faults: %ld\n", PageFaults);
+		printf("Page evictions: %ld\n", PageEvictions);
+		printf("Page write-backs: %ld\n", PageWriteBacks);
+		printf("Page faults per 1000 instructions: %.3f\n",
+				InstructionCount ? PageFaults * 1000.0 / InstructionCount : 0.0);
+	}
+	printf("Host time ns: %ld\n", HostTimeNanoseconds() - HostStartTime);
+}
@@ -0,0 +1,777 @@
+#!/usr/bin/python
+import argparse
+import csv
+import os
+import subprocess
+import sys
+import tempfile
+
+# Benchmark suite for the HYPO simulator.
+#
+# Generates synthetic HYPO object modules, runs every workload under every
+# execution engine the simulator reports (simulator -l) in batch mode, and
+# compares the results against a stored baseline.
+#
+# Build the simulator first:
+#   gcc -O2 -o simulator simulator.c
+#
+# Usage:
+#   ./tools/benchmark.py [--simulator ./simulator] [--scale 1]
+#                        [--baseline tools/bench/baseline.csv]
+#                        [--save-baseline] [--threshold 0.10]
+#                        [--options '-m paged -f 8'] [--lanes 1024]
+#
+# A workload regresses when its host ns/instruction is worse than the baseline
+# by more than the threshold. Changed simulated instruction or clock counts are
+# reported but are not regressions, since optimizations change them on purpose.
+#
+# The native engine runs workloads translated by simulator -t and built with
+# $CC (default cc) beside the module; without them it interprets.
+#
+# Sweep workloads run one program over many inputs. The lockstep engine
+# (simulator -n) runs every input; each engine runs the first SWEEP_SAMPLES
+# as processes of one simulator run, for comparison.
+
+# === CONSTANTS ===
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_BASELINE = os.path.join(TOOLS_DIR, 'bench', 'baseline.csv')
+DEFAULT_SIMULATOR = os.path.join(os.path.dirname(TOOLS_DIR), 'simulator')
+CC = os.environ.get('CC', 'cc')
+STATISTICS = {                                  # Simulator output -> field
+        'Instructions':'instructions', 'Simulated clock':'clock',
+        'Context switches':'switches', 'Messages sent':'messages',
+        'Message latency clock':'latency', 'System calls':'syscalls',
+        'Disk requests':'disk_requests', 'Disk seek tracks':'seek_tracks',
+        'Disk service clock':'service', 'Files mapped':'mapped',
+        'Mapped pages written back':'written_back',
+        'Host time ns':'host_ns' }
+BASELINE_FIELDS = ['workload', 'engine', 'instructions', 'clock', 'switches',
+        'ns_per_instruction']
+
+# Opcodes
+HALT, ADD, SUBTRACT, MULTIPLY, DIVIDE, MOVE, BRANCH = 0, 1, 2, 3, 4, 5, 6
+BRANCH_ON_MINUS, BRANCH_ON_PLUS, BRANCH_ON_ZERO = 7, 8, 9
+PUSH, POP, SYSTEM_CALL = 10, 11, 12
+BLOCK_MOVE, BLOCK_FILL, BLOCK_COMPARE = 13, 14, 15
+CALL, RETURN, COMPARE = 16, 17, 18
+BRANCH_ON_EQUAL, BRANCH_ON_NOT_EQUAL, BRANCH_ON_LESS = 19, 20, 21
+BRANCH_ON_LESS_OR_EQUAL, BRANCH_ON_GREATER, BRANCH_ON_GREATER_OR_EQUAL = 22, 23, 24
+COMPARE_AND_SWAP, FETCH_AND_ADD, TEST_AND_SET = 25, 26, 27
+
+# System calls
+PROCESS_CREATE, PROCESS_DELETE, PROCESS_INQUIRY = 1, 2, 3
+MEM_ALLOC, MEM_FREE, MSG_SEND, MSG_RECEIVE = 4, 5, 6, 7
+TIME_GET, SLEEP, TIMER_SET, TIMER_WAIT = 10, 13, 14, 15
+IO_GETC, IO_PUTC, IO_READ, IO_WRITE = 8, 9, 16, 17
+DISK_READ, DISK_WRITE, MMAP, MUNMAP = 18, 19, 20, 21
+DISK_BLOCK_SIZE, DISK_BLOCKS = 64, 1024
+SWEEP_SAMPLES = 8
+
+# === OPERANDS ===
+# An operand is (mode, gpr, extra word or None)
+def R(n):   return (1, n, None)                 # Register
+def DEF(n): return (2, n, None)                 # Register deferred
+def INC(n): return (3, n, None)                 # Autoincrement
+def DEC(n): return (4, n, None)                 # Autodecrement
+def DIR(a): return (5, 0, a)                    # Direct (address or label)
+def IMM(v): return (6, 0, v)                    # Immediate
+NONE = (0, 0, None)
+
+# === OBJECT MODULE BUILDER ===
+class Program:
+    def __init__(self, origin=0):
+        self.origin = origin
+        self.words = []                         # Values or label names
+        self.labels = {}
+
+    def label(self, name):
+        self.labels[name] = self.origin + len(self.words)
+
+    def ins(self, opcode, op1=NONE, op2=NONE, target=None):
+        self.words.append(opcode * 10000 + op1[0] * 1000 + op1[1] * 100
+                + op2[0] * 10 + op2[1])
+        for op in (op1, op2):
+            if op[2] is not None:
+                self.words.append(op[2])
+        if target is not None:                  # Branch address word
+            self.words.append(target)
+
+    def space(self, count):                     # Zeroed data words
+        self.words.extend([0] * count)
+
+    def string(self, text):                     # A character per word, 0 ends
+        self.words.extend([ord(c) for c in text] + [0])
+
+    def write(self, filename, start):           # Relocatable object module
+        with open(filename, 'w') as out:
+            relocations = []
+            for offset, value in enumerate(self.words):
+                if isinstance(value, str):
+                    value = self.labels[value]
+                    relocations.append(self.origin + offset)
+                out.write('%d %d\n' % (self.origin + offset, value))
+            for address in relocations:
+                out.write('-2 %d\n' % address)
+            out.write('-1 %d\n' % self.labels[start])
+
+# === WORKLOADS ===
+# Each returns (Program, number of processes to create from it)
+def arith_loop(scale):
+    p = Program()
+    p.label('Start')
+    p.ins(MOVE, R(1), IMM(200000 * scale))
+    p.ins(MOVE, R(2), IMM(0))
+    p.ins(MOVE, R(3), IMM(7))
+    p.label('Loop')
+    p.ins(ADD, R(2), R(3))
+    p.ins(MULTIPLY, R(2), IMM(3))
+    p.ins(DIVIDE, R(2), IMM(3))
+    p.ins(SUBTRACT, R(2), R(3))
+    p.ins(SUBTRACT, R(1), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(1), target='Loop')
+    p.ins(HALT)
+    return p, 1
+
+def memory_walk(scale):
+    p = Program()
+    p.label('Start')
+    p.ins(MOVE, R(5), IMM(2000 * scale))
+    p.label('Outer')
+    p.ins(MOVE, R(3), IMM('Buffer'))            # Fill with autoincrement
+    p.ins(MOVE, R(4), IMM(100))
+    p.label('Fill')
+    p.ins(MOVE, INC(3), R(4))
+    p.ins(SUBTRACT, R(4), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(4), target='Fill')
+    p.ins(MOVE, R(2), IMM(0))                   # Sum back with autodecrement
+    p.ins(MOVE, R(4), IMM(100))
+    p.label('Sum')
+    p.ins(ADD, R(2), DEC(3))
+    p.ins(SUBTRACT, R(4), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(4), target='Sum')
+    p.ins(MOVE, R(6), DEF(3))                   # Register deferred and direct
+    p.ins(ADD, DIR('Middle'), R(6))
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Outer')
+    p.ins(HALT)
+    p.label('Buffer')                           # Inside the program segment
+    p.space(50)
+    p.label('Middle')
+    p.space(50)
+    return p, 1
+
+def block_copy(scale):                          # memory_walk's buffers moved
+    p = Program()                               # by the block instructions
+    p.label('Start')
+    p.ins(MOVE, R(5), IMM(2000 * scale))
+    p.label('Outer')
+    p.ins(MOVE, R(1), IMM('Buffer'))            # R1 destination, R2 source
+    p.ins(MOVE, R(2), R(5))                     # or value, R3 count
+    p.ins(MOVE, R(3), IMM(100))
+    p.ins(BLOCK_FILL)
+    p.ins(MOVE, R(1), IMM('Copy'))
+    p.ins(MOVE, R(2), IMM('Buffer'))
+    p.ins(MOVE, R(3), IMM(100))
+    p.ins(BLOCK_MOVE)
+    p.ins(MOVE, R(1), IMM('Copy'))
+    p.ins(MOVE, R(2), IMM('Buffer'))
+    p.ins(MOVE, R(3), IMM(100))
+    p.ins(BLOCK_COMPARE)
+    p.ins(ADD, R(6), R(0))
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Outer')
+    p.ins(HALT)
+    p.label('Buffer')
+    p.space(100)
+    p.label('Copy')
+    p.space(100)
+    return p, 1
+
+def push_pop(scale):
+    p = Program()
+    p.label('Start')
+    p.ins(MOVE, R(5), IMM(20000 * scale))
+    p.label('Outer')
+    p.ins(MOVE, R(1), IMM(16))                  # Descend, pushing each level
+    p.label('Down')
+    p.ins(PUSH, R(1))
+    p.ins(SUBTRACT, R(1), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(1), target='Down')
+    p.ins(MOVE, R(1), IMM(16))                  # Unwind, popping each level
+    p.label('Up')
+    p.ins(POP, R(2))
+    p.ins(ADD, R(3), R(2))
+    p.ins(SUBTRACT, R(1), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(1), target='Up')
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Outer')
+    p.ins(HALT)
+    return p, 1
+
+def recursion(scale):                           # Towers of Hanoi, 8 discs: calls
+    p = Program()                               # and returns as push/pop frames
+    p.label('Start')                            # of disc count and return tag
+    p.ins(MOVE, R(5), IMM(1000 * scale))
+    p.label('Outer')
+    p.ins(PUSH, IMM(0))                         # Tag 0 returns to Outer
+    p.ins(MOVE, R(1), IMM(8))
+    p.label('Call')
+    p.ins(BRANCH_ON_ZERO, R(1), target='Return')
+    p.ins(PUSH, R(1))
+    p.ins(PUSH, IMM(1))                         # Tag 1: move a disc, call again
+    p.ins(SUBTRACT, R(1), IMM(1))
+    p.ins(BRANCH, target='Call')
+    p.label('Return')
+    p.ins(POP, R(2))
+    p.ins(BRANCH_ON_ZERO, R(2), target='Solved')
+    p.ins(SUBTRACT, R(2), IMM(1))
+    p.ins(BRANCH_ON_ZERO, R(2), target='Move')
+    p.ins(POP)                                  # Tag 2: drop the disc count
+    p.ins(BRANCH, target='Return')
+    p.label('Move')
+    p.ins(POP, R(1))
+    p.ins(ADD, R(6), IMM(1))
+    p.ins(PUSH, R(1))
+    p.ins(PUSH, IMM(2))
+    p.ins(SUBTRACT, R(1), IMM(1))
+    p.ins(BRANCH, target='Call')
+    p.label('Solved')
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Outer')
+    p.ins(HALT)
+    return p, 1
+
+def call_return(scale):                         # The same Towers of Hanoi with
+    p = Program()                               # Call, Return and Compare
+    p.label('Start')
+    p.ins(MOVE, R(5), IMM(1000 * scale))
+    p.label('Outer')
+    p.ins(MOVE, R(1), IMM(8))
+    p.ins(CALL, target='Hanoi')
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Outer')
+    p.ins(HALT)
+    p.label('Hanoi')                            # R1 discs, kept across calls
+    p.ins(COMPARE, R(1), IMM(0))
+    p.ins(BRANCH_ON_EQUAL, target='Done')
+    p.ins(PUSH, R(1))
+    p.ins(SUBTRACT, R(1), IMM(1))
+    p.ins(CALL, target='Hanoi')
+    p.ins(ADD, R(6), IMM(1))                    # Move a disc
+    p.ins(CALL, target='Hanoi')
+    p.ins(POP, R(1))
+    p.label('Done')
+    p.ins(RETURN)
+    return p, 1
+
+def alloc_churn(scale):
+    p = Program()
+    p.label('Start')
+    p.ins(MOVE, R(5), IMM(200000 * scale))
+    p.label('Loop')
+    p.ins(MOVE, R(2), IMM(50))
+    p.ins(SYSTEM_CALL, IMM(MEM_ALLOC))
+    p.ins(MOVE, DEF(1), R(5))                   # Touch the block
+    p.ins(MOVE, R(2), IMM(50))
+    p.ins(SYSTEM_CALL, IMM(MEM_FREE))
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Loop')
+    p.ins(HALT)
+    return p, 1
+
+def many_processes(scale):
+    p = Program()
+    p.label('Start')
+    p.ins(MOVE, R(1), IMM(20000 * scale))
+    p.label('Loop')
+    p.ins(ADD, R(2), R(1))
+    p.ins(SUBTRACT, R(1), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(1), target='Loop')
+    p.ins(HALT)
+    return p, 64
+
+def fork_fanout(scale):
+    p = Program()
+    p.label('Start')
+    p.ins(MOVE, R(5), IMM(2000 * scale))
+    p.ins(MOVE, R(6), IMM(0))
+    p.label('Loop')
+    p.ins(SYSTEM_CALL, IMM(PROCESS_CREATE))     # GPR1 = child PID, 0 in child
+    p.ins(BRANCH_ON_ZERO, R(1), target='Child')
+    p.ins(SYSTEM_CALL, IMM(PROCESS_INQUIRY))    # Wait for that child
+    p.ins(ADD, R(6), R(2))                      # Sum the exit statuses
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Loop')
+    p.ins(HALT)
+    p.label('Child')
+    p.ins(MOVE, R(1), R(5))
+    p.ins(SYSTEM_CALL, IMM(PROCESS_DELETE))
+    return p, 1
+
+def ping_pong(scale):
+    p = Program()
+    p.label('Start')
+    p.ins(MOVE, R(5), IMM(5000 * scale))
+    p.ins(MOVE, R(2), IMM(10))
+    p.ins(SYSTEM_CALL, IMM(MEM_ALLOC))
+    p.ins(MOVE, R(4), R(1))                     # Buffer passed back and forth
+    p.ins(SYSTEM_CALL, IMM(PROCESS_CREATE))
+    p.ins(BRANCH_ON_ZERO, R(1), target='Pong')
+    p.ins(MOVE, R(7), R(1))
+    p.label('Ping')
+    p.ins(MOVE, DEF(4), R(5))
+    p.ins(MOVE, R(1), R(7))
+    p.ins(MOVE, R(2), R(4))
+    p.ins(MOVE, R(3), IMM(10))
+    p.ins(SYSTEM_CALL, IMM(MSG_SEND))
+    p.ins(SYSTEM_CALL, IMM(MSG_RECEIVE))        # Blocks until the reply
+    p.ins(MOVE, R(4), R(2))
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Ping')
+    p.ins(MOVE, R(1), R(7))                     # Empty message stops Pong
+    p.ins(MOVE, R(3), IMM(0))
+    p.ins(SYSTEM_CALL, IMM(MSG_SEND))
+    p.ins(MOVE, R(1), R(7))
+    p.ins(SYSTEM_CALL, IMM(PROCESS_INQUIRY))
+    p.ins(MOVE, R(1), R(4))
+    p.ins(MOVE, R(2), IMM(10))
+    p.ins(SYSTEM_CALL, IMM(MEM_FREE))
+    p.ins(HALT)
+    p.label('Pong')
+    p.ins(SYSTEM_CALL, IMM(MSG_RECEIVE))
+    p.ins(BRANCH_ON_ZERO, R(3), target='Done')
+    p.ins(ADD, DEF(2), IMM(1))
+    p.ins(SYSTEM_CALL, IMM(MSG_SEND))           # Back to the sender in GPR1
+    p.ins(BRANCH, target='Pong')
+    p.label('Done')
+    p.ins(HALT)
+    return p, 1
+
+def shared_counter(scale):                      # Forked processes counting in a
+    p = Program()                               # shared heap block, no syscalls
+    p.label('Start')
+    p.ins(MOVE, R(2), IMM(3))
+    p.ins(SYSTEM_CALL, IMM(MEM_ALLOC))
+    p.ins(MOVE, R(4), R(1))                     # Counter added to atomically
+    p.ins(MOVE, DEF(4), IMM(0))
+    p.ins(MOVE, R(3), R(4))                     # Lock
+    p.ins(ADD, R(3), IMM(1))
+    p.ins(MOVE, DEF(3), IMM(0))
+    p.ins(MOVE, R(7), R(3))                     # Counter under the lock
+    p.ins(ADD, R(7), IMM(1))
+    p.ins(MOVE, DEF(7), IMM(0))
+    p.ins(MOVE, R(6), IMM(3))
+    p.label('Fork')
+    p.ins(SYSTEM_CALL, IMM(PROCESS_CREATE))
+    p.ins(BRANCH_ON_ZERO, R(1), target='Work')
+    p.ins(SUBTRACT, R(6), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(6), target='Fork')
+    p.label('Work')
+    p.ins(MOVE, R(5), IMM(50000 * scale))
+    p.label('Loop')
+    p.ins(FETCH_AND_ADD, DEF(4), IMM(1))
+    p.label('Spin')
+    p.ins(TEST_AND_SET, DEF(3))
+    p.ins(BRANCH_ON_NOT_EQUAL, target='Spin')
+    p.ins(ADD, DEF(7), IMM(1))
+    p.ins(MOVE, DEF(3), IMM(0))
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Loop')
+    p.ins(HALT)
+    return p, 1
+
+def timer_wheel(scale):
+    p = Program()
+    p.label('Start')
+    p.ins(SYSTEM_CALL, IMM(PROCESS_CREATE))
+    p.ins(BRANCH_ON_ZERO, R(1), target='Periodic')
+    p.ins(MOVE, R(7), R(1))
+    p.ins(MOVE, R(5), IMM(500 * scale))
+    p.label('Sleep')                            # Sleep 50 to 1073 ticks
+    p.ins(SYSTEM_CALL, IMM(TIME_GET))
+    p.ins(MOVE, R(2), R(1))
+    p.ins(DIVIDE, R(2), IMM(1024))
+    p.ins(MULTIPLY, R(2), IMM(1024))
+    p.ins(SUBTRACT, R(1), R(2))
+    p.ins(ADD, R(1), IMM(50))
+    p.ins(SYSTEM_CALL, IMM(SLEEP))
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Sleep')
+    p.ins(MOVE, R(1), R(7))
+    p.ins(SYSTEM_CALL, IMM(PROCESS_INQUIRY))
+    p.ins(HALT)
+    p.label('Periodic')                         # Real-time task, period 300
+    p.ins(MOVE, R(1), IMM(300))
+    p.ins(SYSTEM_CALL, IMM(TIMER_SET))
+    p.ins(MOVE, R(5), IMM(500 * scale))
+    p.label('Tick')
+    p.ins(SYSTEM_CALL, IMM(TIMER_WAIT))
+    p.ins(ADD, R(6), R(1))                      # Count expiries, overruns too
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Tick')
+    p.ins(HALT)
+    return p, 8
+
+def upcase(p, reg, label):                       # Lower case letter in reg -= 32
+    p.ins(MOVE, R(7), R(reg))
+    p.ins(SUBTRACT, R(7), IMM(ord('a')))
+    p.ins(BRANCH_ON_MINUS, R(7), target=label)
+    p.ins(SUBTRACT, R(7), IMM(26))
+    p.ins(BRANCH_ON_PLUS, R(7), target=label)
+    p.ins(BRANCH_ON_ZERO, R(7), target=label)
+    p.ins(SUBTRACT, R(reg), IMM(32))
+    p.label(label)
+
+def console_getc(scale):                        # Upcase filter, a character
+    p = Program()                               # per system call
+    p.label('Start')
+    p.ins(SYSTEM_CALL, IMM(IO_GETC))
+    p.ins(BRANCH_ON_MINUS, R(1), target='Done') # End of input
+    upcase(p, 1, 'Put')
+    p.ins(SYSTEM_CALL, IMM(IO_PUTC))
+    p.ins(BRANCH, target='Start')
+    p.label('Done')
+    p.ins(HALT)
+    return p, 1
+
+def console_block(scale):                       # Same filter, a line per
+    p = Program()                               # system call
+    p.label('Start')
+    p.ins(MOVE, R(1), IMM('Buffer'))
+    p.ins(MOVE, R(2), IMM(128))
+    p.ins(SYSTEM_CALL, IMM(IO_READ))
+    p.ins(BRANCH_ON_ZERO, R(2), target='Done')  # End of input
+    p.ins(MOVE, R(3), R(1))
+    p.ins(MOVE, R(4), R(2))
+    p.label('Next')
+    p.ins(MOVE, R(5), DEF(3))
+    upcase(p, 5, 'Store')
+    p.ins(MOVE, INC(3), R(5))
+    p.ins(SUBTRACT, R(4), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(4), target='Next')
+    p.ins(SYSTEM_CALL, IMM(IO_WRITE))           # R1, R2 still name the line
+    p.ins(BRANCH, target='Start')
+    p.label('Done')
+    p.ins(HALT)
+    p.label('Buffer')
+    p.space(128)
+    return p, 1
+
+def mapped_file(scale):                         # Same filter, in place on a
+    p = Program()                               # file mapped a window at a time
+    p.label('Start')
+    p.ins(MOVE, R(6), IMM(0))                   # Offset of the window
+    p.label('Window')
+    p.ins(MOVE, R(1), IMM('Name'))
+    p.ins(MOVE, R(2), R(6))
+    p.ins(MOVE, R(3), IMM(2000))
+    p.ins(SYSTEM_CALL, IMM(MMAP))
+    p.ins(BRANCH_ON_ZERO, R(3), target='Done')  # End of file
+    p.ins(ADD, R(6), R(3))
+    p.ins(MOVE, R(4), R(1))
+    p.ins(MOVE, R(5), R(3))
+    p.label('Next')
+    p.ins(MOVE, R(2), DEF(4))
+    upcase(p, 2, 'Store')
+    p.ins(MOVE, INC(4), R(2))
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Next')
+    p.ins(SUBTRACT, R(4), R(3))                 # Back to the start
+    p.ins(MOVE, R(1), R(4))
+    p.ins(SYSTEM_CALL, IMM(MUNMAP))             # Writes the window back
+    p.ins(BRANCH, target='Window')
+    p.label('Done')
+    p.ins(HALT)
+    p.label('Name')                             # Path appended by the runner
+    return p, 1
+
+def console_text(scale):                        # Standard input of both
+    line = 'the quick brown fox jumps over the lazy dog, %d times\n'
+    return ''.join(line % i for i in range(400 * scale))
+
+def disk_random(scale):                         # Random block writes and reads
+    p = Program()                               # with a little compute between
+    p.label('Start')
+    p.ins(MOVE, R(2), IMM(DISK_BLOCK_SIZE))
+    p.ins(SYSTEM_CALL, IMM(MEM_ALLOC))
+    p.ins(MOVE, R(4), R(1))                     # Heap buffer for the DMA
+    p.ins(SYSTEM_CALL, IMM(TIME_GET))           # Seed differs per process
+    p.ins(MOVE, R(6), R(1))
+    p.ins(MOVE, R(5), IMM(100 * scale))
+    p.label('Loop')
+    for op in (DISK_WRITE, DISK_READ):
+        p.ins(MULTIPLY, R(6), IMM(97))          # Next block, LCG mod DISK_BLOCKS
+        p.ins(ADD, R(6), IMM(13))
+        p.ins(MOVE, R(7), R(6))
+        p.ins(DIVIDE, R(7), IMM(DISK_BLOCKS))
+        p.ins(MULTIPLY, R(7), IMM(DISK_BLOCKS))
+        p.ins(SUBTRACT, R(6), R(7))
+        p.ins(MOVE, R(1), R(6))
+        p.ins(MOVE, R(2), R(4))
+        p.ins(SYSTEM_CALL, IMM(op))
+    p.ins(MOVE, R(3), IMM(20))
+    p.label('Compute')
+    p.ins(ADD, DEF(4), R(3))
+    p.ins(SUBTRACT, R(3), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(3), target='Compute')
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Loop')
+    p.ins(MOVE, R(1), R(4))
+    p.ins(MOVE, R(2), IMM(DISK_BLOCK_SIZE))
+    p.ins(SYSTEM_CALL, IMM(MEM_FREE))
+    p.ins(HALT)
+    return p, 8
+
+WORKLOADS = [
+        ('arith_loop', arith_loop),
+        ('memory_walk', memory_walk),
+        ('block_copy', block_copy),
+        ('push_pop', push_pop),
+        ('recursion', recursion),
+        ('call_return', call_return),
+        ('alloc_churn', alloc_churn),
+        ('many_processes', many_processes),
+        ('fork_fanout', fork_fanout),
+        ('ping_pong', ping_pong),
+        ('shared_counter', shared_counter),
+        ('timer_wheel', timer_wheel),
+        ('console_getc', console_getc),
+        ('console_block', console_block),
+        ('disk_fcfs', disk_random),
+        ('disk_look', disk_random),
+        ('mapped_file', mapped_file) ]
+# === SWEEPS ===
+# Each reads its input in R1, or starts by moving seed there
+def lcg_sweep(scale, seed=None):                # Same path for every input
+    p = Program()
+    p.label('Start')
+    if seed is not None:
+        p.ins(MOVE, R(1), IMM(seed))
+    p.ins(MOVE, R(5), IMM(10000 * scale))
+    p.label('Loop')
+    p.ins(MULTIPLY, R(1), IMM(1103515245))      # R1 = R1 * a + c mod 2^31
+    p.ins(ADD, R(1), IMM(12345))
+    p.ins(MOVE, R(2), R(1))
+    p.ins(DIVIDE, R(2), IMM(2 ** 31))
+    p.ins(MULTIPLY, R(2), IMM(2 ** 31))
+    p.ins(SUBTRACT, R(1), R(2))
+    p.ins(SUBTRACT, R(5), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(5), target='Loop')
+    p.ins(HALT)
+    return p
+
+def collatz_sweep(scale, seed=None):            # Paths differ per input
+    p = Program()
+    p.label('Start')
+    if seed is not None:
+        p.ins(MOVE, R(1), IMM(seed))
+    p.ins(MOVE, R(2), IMM(0))                   # Steps to reach 1, summed
+    p.ins(MOVE, R(4), IMM(20 * scale))          # over the next inputs
+    p.label('Next')
+    p.ins(MOVE, R(6), R(1))
+    p.label('Loop')
+    p.ins(MOVE, R(3), R(6))
+    p.ins(SUBTRACT, R(3), IMM(1))
+    p.ins(BRANCH_ON_ZERO, R(3), target='Done')
+    p.ins(ADD, R(2), IMM(1))
+    p.ins(MOVE, R(3), R(6))
+    p.ins(DIVIDE, R(3), IMM(2))
+    p.ins(MULTIPLY, R(3), IMM(2))
+    p.ins(SUBTRACT, R(3), R(6))
+    p.ins(BRANCH_ON_ZERO, R(3), target='Even')
+    p.ins(MULTIPLY, R(6), IMM(3))
+    p.ins(ADD, R(6), IMM(1))
+    p.ins(BRANCH, target='Loop')
+    p.label('Even')
+    p.ins(DIVIDE, R(6), IMM(2))
+    p.ins(BRANCH, target='Loop')
+    p.label('Done')
+    p.ins(ADD, R(1), IMM(1))
+    p.ins(SUBTRACT, R(4), IMM(1))
+    p.ins(BRANCH_ON_PLUS, R(4), target='Next')
+    p.ins(HALT)
+    return p
+
+SWEEPS = [                                      # Name, program, input of lane
+        ('lcg_sweep', lcg_sweep, lambda lane: lane + 1),
+        ('collatz_sweep', collatz_sweep, lambda lane: lane * 7 % 100000 + 1) ]
+
+STDIN = { 'console_getc':console_text, 'console_block':console_text }
+DISK = { 'disk_fcfs':'fcfs', 'disk_look':'look' }  # Disk scheduling policy
+MAPPED = { 'mapped_file':console_text }         # Contents of the mapped file
+
+# === RUNNING ===
+def list_engines(simulator):
+    result = subprocess.run([simulator, '-l'], capture_output=True, text=True)
+    return result.stdout.split()
+
+def translate(simulator, filename):             # Shared object for -e native
+    subprocess.run([simulator, '-t', filename + '.c', filename],
+            capture_output=True)
+    result = subprocess.run([CC, '-O2', '-shared', '-fPIC', '-o',
+            filename + '.so', filename + '.c'], capture_output=True, text=True)
+    if result.returncode != 0:
+        print('%s not translated: %s' % (filename, result.stderr[-200:]))
+
+def run(simulator, engine, filename, processes, text, extra, files):
+    for path, contents in files.items():        # Fresh, as runs modify them
+        with open(path, 'w') as f:
+            f.write(contents)
+    command = [simulator, '-b', '-q', '-e', engine] + OPTIONS + extra \
+            + [filename] * processes
+    result = subprocess.run(command, cwd=TOOLS_DIR, input=text,
+            capture_output=True, text=True)
+    stats = {}
+    for line in result.stdout.splitlines():
+        name, _, value = line.partition(': ')
+        if name in STATISTICS:
+            stats[STATISTICS[name]] = int(value)
+    if len(stats) != len(STATISTICS) or 'ERROR' in result.stdout:
+        print(result.stdout[-2000:])
+        sys.exit('ERROR: %s failed under engine %s' % (filename, engine))
+    return stats
+
+def measure(simulator, engine, filename, processes, text, extra, files,
+        repeat):
+    best = None
+    for _ in range(repeat):                     # Keep the fastest host time
+        stats = run(simulator, engine, filename, processes, text, extra,
+                files)
+        if best is None or stats['host_ns'] < best['host_ns']:
+            best = stats
+    seconds = max(best['host_ns'], 1) / 1e9
+    best['ips'] = best['instructions'] / seconds
+    best['ns_per_instruction'] = best['host_ns'] / max(best['instructions'], 1)
+    best['switches_per_second'] = best['switches'] / seconds
+    best['messages_per_second'] = best['messages'] / seconds
+    return best
+
+# === BASELINE ===
+def load_baseline(filename):
+    baseline = {}
+    if os.path.exists(filename):
+        with open(filename) as f:
+            for row in csv.DictReader(f):
+                baseline[(row['workload'], row['engine'])] = row
+    return baseline
+
+def save_baseline(filename, results):
+    os.makedirs(os.path.dirname(filename), exist_ok=True)
+    with open(filename, 'w', newline='') as f:
+        writer = csv.DictWriter(f, BASELINE_FIELDS, extrasaction='ignore')
+        writer.writeheader()
+        for (workload, engine), stats in results.items():
+            row = dict(stats, workload=workload, engine=engine)
+            row['ns_per_instruction'] = '%.2f' % stats['ns_per_instruction']
+            writer.writerow(row)
+
+def compare(base, stats, threshold):
+    if base is None:
+        return 'new'
+    notes = []
+    if int(base['instructions']) != stats['instructions'] \
+            or int(base['clock']) != stats['clock']:
+        notes.append('changed')
+    limit = float(base['ns_per_instruction']) * (1 + threshold)
+    if stats['ns_per_instruction'] > limit:
+        notes.append('REGRESSION')
+    return ' '.join(notes) or 'ok'
+
+### === MAIN === ###
+parser = argparse.ArgumentParser(description='HYPO simulator benchmarks')
+parser.add_argument('--simulator', default=DEFAULT_SIMULATOR)
+parser.add_argument('--baseline', default=DEFAULT_BASELINE)
+parser.add_argument('--save-baseline', action='store_true')
+parser.add_argument('--scale', type=int, default=1)
+parser.add_argument('--repeat', type=int, default=3)
+parser.add_argument('--threshold', type=float, default=0.10)
+parser.add_argument('--engine', action='append',
+        help='engine to run (default: every engine)')
+parser.add_argument('--workload', action='append',
+        help='workload to run (default: every workload)')
+parser.add_argument('--lanes', type=int, default=1024,
+        help='inputs of a sweep workload')
+parser.add_argument('--options', default='',
+        help='extra simulator options, e.g. a memory model')
+args = parser.parse_args()
+OPTIONS = args.options.split()
+
+simulator = os.path.abspath(args.simulator)
+engines = args.engine or list_engines(simulator)
+baseline = load_baseline(args.baseline)
+results = {}
+regressions = 0
+
+print('%-16s %-10s %12s %12s %10s %12s %9s  %s' % ('workload', 'engine',
+        'instructions', 'instr/sec', 'ns/instr', 'switches/sec', 'syscalls',
+        'baseline'))
+with tempfile.TemporaryDirectory() as workdir:
+    for name, build in WORKLOADS:
+        if args.workload and name not in args.workload:
+            continue
+        program, processes = build(args.scale)
+        files = {}
+        if name in MAPPED:
+            path = os.path.join(workdir, name + '.dat')
+            files[path] = MAPPED[name](args.scale)
+            program.string(path)
+        filename = os.path.join(workdir, name + '.txt')
+        program.write(filename, 'Start')
+        if 'native' in engines:
+            translate(simulator, filename)
+        text = STDIN[name](args.scale) if name in STDIN else ''
+        extra = ['-d', os.path.join(workdir, name + '.disk'), '-s', DISK[name]] \
+                if name in DISK else []
+        for engine in engines:
+            stats = measure(simulator, engine, filename, processes, text,
+                    extra, files, args.repeat)
+            results[(name, engine)] = stats
+            status = compare(baseline.get((name, engine)), stats,
+                    args.threshold)
+            regressions += 'REGRESSION' in status
+            print('%-16s %-10s %12d %12.0f %10.2f %12.0f %9d  %s' % (name,
+                engine, stats['instructions'], stats['ips'],
+                stats['ns_per_instruction'], stats['switches_per_second'],
+                stats['syscalls'], status))
+            if stats['messages']:
+                print('%-27s %12d messages %12.0f msg/sec %10.2f ns/msg'
+                        ' %6d clock latency' % ('', stats['messages'],
+                        stats['messages_per_second'],
+                        stats['host_ns'] / stats['messages'], stats['latency']))
+            if stats['disk_requests']:
+                print('%-27s %12d requests %12d seek tracks %6d clock service'
+                        % ('', stats['disk_requests'], stats['seek_tracks'],
+                        stats['service']))
+            if stats['mapped']:
+                print('%-27s %12d mappings %12d pages written back' % ('',
+                        stats['mapped'], stats['written_back']))
+
+    for name, build, seed in SWEEPS:
+        if args.workload and name not in args.workload:
+            continue
+        inputs = os.path.join(workdir, name + '.in')
+        with open(inputs, 'w') as f:
+            f.writelines('0 %d\n' % seed(lane) for lane in range(args.lanes))
+        filename = os.path.join(workdir, name + '.txt')
+        build(args.scale).write(filename, 'Start')
+        samples = []
+        for lane in range(min(SWEEP_SAMPLES, args.lanes)):
+            samples.append(os.path.join(workdir, '%s.%d.txt' % (name, lane)))
+            build(args.scale, seed(lane)).write(samples[-1], 'Start')
+            if 'native' in engines:
+                translate(simulator, samples[-1])
+        runs = [('lockstep', measure(simulator, engines[0], filename, 1, '',
+                ['-n', inputs], {}, args.repeat))]
+        for engine in engines:                  # Samples before the first one
+            runs.append((engine, measure(simulator, engine, samples[0], 1, '',
+                    samples[1:], {}, args.repeat)))
+        for engine, stats in runs:
+            print('%-16s %-10s %12d %12.0f %10.2f' % (name, engine,
+                stats['instructions'], stats['ips'],
+                stats['ns_per_instruction']))
+
+if args.save_baseline:
+    save_baseline(args.baseline, results)
+    print('Baseline written to', args.baseline)
+if regressions:
+    sys.exit('%d regression(s) against %s' % (regressions, args.baseline))
@@ -0,0 +1,1559 @@
+/*******************************************************************************
+ * hypothesize.c - HYPO Assembler
+ *
+ * Converts a file of HYPO ASM into a HYPO executable object module. Native
+ * replacement for hypothesize.py: one pass over the source, forward label
+ * references are patched from a fixup list once every label is known.
+ *
+ * The ASM file is split into 3 columns:
+ *   1. The Label Column
+ *   2. The Instruction Column
+ *   3. The Operand Column ("Op1,Op2", quoted when there are two operands)
+ *
+ * Operand syntax (all six addressing modes):
+ *   R3		Register
+ *   (R3)		Register deferred
+ *   (R3)++	Autoincrement
+ *   --(R3)	Autodecrement
+ *   Label		Direct (address of Label)
+ *   100, -5	Immediate
+ *
+ * Directives: Long, Origin, Function, End (see README.md)
+ *
+ * With -O the source is kept as a statement list and run through the
+ * peephole optimizer before addresses are assigned (see OptimizeProgram).
+ *
+ * With -r the module is relocatable: a "-2 address" record follows the words
+ * for every word that holds a program address, i.e. direct operands, branch
+ * targets and label constants, so the loader can place the program anywhere.
+ *
+ * Build:	gcc -O2 -o hypothesize tools/hypothesize.c
+ * Usage:	hypothesize [-b] [-O] [-r] [-v] [-o output] input.csv
+ *      -b	Write a binary image instead of the text object module
+ *      -O	Optimize and report the simulated cycles saved
+ *      -r	Write relocation records
+ *      -v	List the labels and their addresses
+ *      -o	Output file, default is the input with a .txt (.img) extension
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/*** VALUE CONSTANTS ***/
+#define SCRIPT_INDICATOR_END	-1
+#define SCRIPT_INDICATOR_RELOCATE	-2	// Word at the address is a program address
+#define MAX_FILENAME		128
+#define MAX_FIELD		128
+#define GPR_NUMBER		8
+#define IMAGE_MAGIC		"HYPO"		// Binary image header
+#define UNDEFINED		-1
+
+// Instruction classes: which operands the instruction takes
+#define OPERANDS_NONE		0	// Halt, BlockMove, BlockFill, BlockCompare, Return
+#define OPERANDS_ONE		1	// Push, Pop, SystemCall, TestAndSet
+#define OPERANDS_TWO		2	// Add .. Move, Compare, CompareAndSwap, FetchAndAdd
+#define OPERANDS_TARGET		3	// Branch, Call, BranchOnEqual .. BranchOnGreaterOrEqual
+#define OPERANDS_ONE_TARGET	4	// BranchOnMinus, BranchOnPlus, BranchOnZero
+
+/*** ERROR CODES ***/
+#define OK                      0
+#define ErrorFileOpen           -2
+#define ErrorSyntax		-3
+#define ErrorNoMemory		-4
+
+/*** INSTRUCTION TABLE ***/
+struct Instruction {
+	char *Mnemonic;
+	int Opcode;
+	int Operands;
+	int WritesOp1;		// Op1 is a destination and cannot be immediate
+	int Cycles;		// Execution time in microseconds
+};
+
+struct Instruction Instructions[] = {
+	{ "Halt",		0,	OPERANDS_NONE,		0,	12 },
+	{ "Add",		1,	OPERANDS_TWO,		1,	3 },
+	{ "Subtract",		2,	OPERANDS_TWO,		1,	3 },
+	{ "Multiply",		3,	OPERANDS_TWO,		1,	6 },
+	{ "Divide",		4,	OPERANDS_TWO,		1,	6 },
+	{ "Move",		5,	OPERANDS_TWO,		1,	2 },
+	{ "Branch",		6,	OPERANDS_TARGET,	0,	2 },
+	{ "BranchOnMinus",	7,	OPERANDS_ONE_TARGET,	0,	4 },
+	{ "BrOnMinus",		7,	OPERANDS_ONE_TARGET,	0,	4 },
+	{ "BranchOnPlus",	8,	OPERANDS_ONE_TARGET,	0,	4 },
+	{ "BrOnPlus",		8,	OPERANDS_ONE_TARGET,	0,	4 },
+	{ "BranchOnZero",	9,	OPERANDS_ONE_TARGET,	0,	4 },
+	{ "BrOnZero",		9,	OPERANDS_ONE_TARGET,	0,	4 },
+	{ "Push",		10,	OPERANDS_ONE,		0,	2 },
+	{ "Pop",		11,	OPERANDS_ONE,		1,	2 },
+	{ "SystemCall",		12,	OPERANDS_ONE,		0,	12 },
+	{ "BlockMove",		13,	OPERANDS_NONE,		0,	4 },	// Plus 1 a word
+	{ "BlockFill",		14,	OPERANDS_NONE,		0,	4 },
+	{ "BlockCompare",	15,	OPERANDS_NONE,		0,	4 },
+	{ "Call",		16,	OPERANDS_TARGET,	0,	4 },
+	{ "Return",		17,	OPERANDS_NONE,		0,	2 },
+	{ "Compare",		18,	OPERANDS_TWO,		0,	3 },	// Sets the PSR flags
+	{ "BranchOnEqual",	19,	OPERANDS_TARGET,	0,	4 },
+	{ "BrOnEqual",		19,	OPERANDS_TARGET,	0,	4 },
+	{ "BranchOnNotEqual",	20,	OPERANDS_TARGET,	0,	4 },
+	{ "BrOnNotEqual",	20,	OPERANDS_TARGET,	0,	4 },
+	{ "BranchOnLess",	21,	OPERANDS_TARGET,	0,	4 },
+	{ "BrOnLess",		21,	OPERANDS_TARGET,	0,	4 },
+	{ "BranchOnLessOrEqual",	22,	OPERANDS_TARGET,	0,	4 },
+	{ "BrOnLessOrEqual",	22,	OPERANDS_TARGET,	0,	4 },
+	{ "BranchOnGreater",	23,	OPERANDS_TARGET,	0,	4 },
+	{ "BrOnGreater",	23,	OPERANDS_TARGET,	0,	4 },
+	{ "BranchOnGreaterOrEqual",	24,	OPERANDS_TARGET,	0,	4 },
+	{ "BrOnGreaterOrEqual",	24,	OPERANDS_TARGET,	0,	4 },
+	{ "CompareAndSwap",	25,	OPERANDS_TWO,		1,	4 },	// Old word in R0
+	{ "FetchAndAdd",	26,	OPERANDS_TWO,		1,	4 },
+	{ "TestAndSet",		27,	OPERANDS_ONE,		1,	4 },
+};
+#define INSTRUCTION_COUNT	(sizeof(Instructions) / sizeof(Instructions[0]))
+
+/*** OPERAND ***/
+struct Operand {
+	int Mode;		// 0 (unused) thru 6
+	int Gpr;
+	int HasWord;		// Direct and immediate modes take the next word
+	long Word;
+	long Label;		// Label index when Word is a label address
+};
+
+/*** STATEMENT ***/
+// One source line that produces words. Kept in a list only with -O.
+#define STATEMENT_INSTRUCTION	0
+#define STATEMENT_LONG		1
+#define STATEMENT_ORIGIN	2
+
+struct Statement {
+	int Kind;
+	struct Instruction *Ins;
+	struct Operand Op1, Op2;	// Branch address is Op1 (Branch) or Op2
+	long Value;			// Long value or Origin address
+	long ValueLabel;		// Long holding a label address, or -1
+	long Line;
+	int Labelled;			// A label names this statement
+	int Deleted;
+};
+
+/*** GLOBAL VARS ***/
+// Label table: names and addresses in order of first use, found through an
+// open addressing hash of label indexes
+char **LabelName;
+long *LabelAddress;		// UNDEFINED until the label column is seen
+long LabelCount = 0, LabelCapacity = 0;
+long *LabelHash;		// Label index, or UNDEFINED for an empty slot
+long HashCapacity = 0;
+
+// Output stream: one entry per memory word
+long *CodeAddress, *CodeWord;
+long CodeCount = 0, CodeCapacity = 0;
+
+// Fixups: words holding the address of a label defined later
+long *FixupIndex, *FixupLabel, *FixupLine;
+long FixupCount = 0, FixupCapacity = 0;
+
+// Relocations: words holding a program address, kept with -r
+int Relocatable = 0;
+long *RelocationIndex;
+long RelocationCount = 0, RelocationCapacity = 0;
+
+long LocationCounter = 0;
+long LineNumber = 0;
+long EntryPC = UNDEFINED;	// Set by the End directive
+long EntryLabel = UNDEFINED;
+int EndSeen = 0;
+
+// Optimizer: statement list. While it is built LabelAddress holds the index
+// of the statement a label names, addresses are assigned by LayoutProgram().
+int Optimize = 0;
+struct Statement *Statements;
+long StatementCount = 0, StatementCapacity = 0;
+int PendingLabel = 0;		// Next statement is named by a label
+
+/*** FUNCTION PROTOTYPES ***/
+int main(int argc, char *argv[]);
+char *ReadFile(char *filename, long *size);
+int AssembleLine(char *line);
+int EmitStatement(struct Statement *st);
+int AppendStatement(struct Statement *st);
+int SplitFields(char *line, char fields[3][MAX_FIELD]);
+int ParseOperand(char *text, struct Operand *op);
+int ParseNumber(char *text, long *value);
+long LookupLabel(char *name);
+int DefineLabel(char *name, long address);
+int EmitWord(long word);
+int EmitLabelWord(long label);
+int EmitOperandWord(struct Operand *op);
+int AddRelocation();
+int ResolveFixups();
+int WriteTextObject(char *filename, long pc);
+int WriteBinaryImage(char *filename, long pc);
+void *Grow(void *array, long *capacity, long count, size_t size);
+void OptimizeProgram();
+int LayoutProgram();
+
+/*******************************************************************************
+ * Function: main
+ *
+ * Description: Assembles the input file and writes the object module.
+ *
+ * Function Return Value
+ *      0				-Object module written
+ *      1				-Syntax or file error (message printed)
+ ******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	char output[MAX_FILENAME] = "";
+	int binary = 0, verbose = 0, option;
+	long size;
+
+	while ((option = getopt(argc, argv, "bOrvo:")) != -1) {
+		switch (option) {
+			case 'b':
+				binary = 1;
+				break;
+			case 'O':
+				Optimize = 1;
+				break;
+			case 'r':
+				Relocatable = 1;
+				break;
+			case 'v':
+				verbose = 1;
+				break;
+			case 'o':
+				snprintf(output, MAX_FILENAME, "%s", optarg);
+				break;
+			default:
+				printf("Usage: %s [-b] [-O] [-r] [-v] [-o output] input.csv\n", argv[0]);
+				return 1;
+		}
+	}
+	if (optind >= argc) {
+		printf("Usage: %s [-b] [-O] [-r] [-v] [-o output] input.csv\n", argv[0]);
+		return 1;
+	}
+
+	char *source = ReadFile(argv[optind], &size);
+	if (source == NULL)
+		return 1;
+
+	// Single pass: assemble line by line, stop at the End directive
+	char *line = source;
+	while (line < source + size) {
+		char *end = memchr(line, '\n', source + size - line);
+		if (end == NULL)
+			end = source + size;
+		*end = '\0';
+		LineNumber++;
+
+		if (AssembleLine(line) != OK)
+			return 1;
+		if (EndSeen)
+			break;
+		line = end + 1;
+	}
+
+	if (!EndSeen) {
+		printf("ERROR: No End directive\n");
+		return 1;
+	}
+	if (Optimize) {
+		OptimizeProgram();
+		if (LayoutProgram() != OK)
+			return 1;
+	}
+	else if (ResolveFixups() != OK)
+		return 1;
+
+	if (verbose)
+		for (long i = 0; i < LabelCount; i++)
+			printf("%-24s %ld\n", LabelName[i], LabelAddress[i]);
+
+	// Default output name is $filename.txt (or .img)
+	if (output[0] == '\0') {
+		snprintf(output, MAX_FILENAME, "%s", argv[optind]);
+		char *dot = strrchr(output, '.');
+		if (dot == NULL || strchr(dot, '/') != NULL)
+			dot = output + strlen(output);
+		snprintf(dot, MAX_FILENAME - (dot - output), "%s", binary ? ".img" : ".txt");
+	}
+
+	if (binary)
+		return WriteBinaryImage(output, EntryPC) == OK ? 0 : 1;
+	return WriteTextObject(output, EntryPC) == OK ? 0 : 1;
+}
+
+/*******************************************************************************
+ * Function: ReadFile
+ *
+ * Description: Reads a whole file into a NUL terminated buffer.
+ *
+ * Output Parameters
+ *      size				Number of bytes read
+ *
+ * Function Return Value
+ *      Buffer, or NULL when the file cannot be read
+ ******************************************************************************/
+
+char *ReadFile(char *filename, long *size)
+{
+	FILE *fp = fopen(filename, "rb");
+	if (fp == NULL) {
+		printf("ERROR: Unable to open file %s\n", filename);
+		return NULL;
+	}
+	fseek(fp, 0, SEEK_END);
+	*size = ftell(fp);
+	rewind(fp);
+
+	char *buffer = malloc(*size + 1);
+	if (buffer == NULL || fread(buffer, 1, *size, fp) != (size_t)*size) {
+		printf("ERROR: Unable to read file %s\n", filename);
+		fclose(fp);
+		return NULL;
+	}
+	buffer[*size] = '\0';
+	fclose(fp);
+	return buffer;
+}
+
+/*******************************************************************************
+ * Function: AssembleLine
+ *
+ * Description: Assigns the label column to the current location and parses
+ * the instruction or directive into a statement, which is emitted at once
+ * or, with -O, kept for the optimizer. The End directive sets EndSeen.
+ *
+ * Function Return Value
+ *      OK				-Line assembled
+ *      ErrorSyntax			-Invalid line (message printed)
+ *      ErrorNoMemory			-Out of host memory
+ ******************************************************************************/
+
+int AssembleLine(char *line)
+{
+	char fields[3][MAX_FIELD];
+	char operands[2][MAX_FIELD];
+	struct Statement st;
+	struct Operand *op1 = &st.Op1, *op2 = &st.Op2;
+
+	// Skip blank lines
+	char *p = line;
+	while (isspace((unsigned char)*p))
+		p++;
+	if (*p == '\0')
+		return OK;
+
+	if (SplitFields(line, fields) != OK)
+		return ErrorSyntax;
+
+	// Column 1: ASSIGN INDEX LOCATION TO LABELS
+	if (fields[0][0] != '\0') {
+		if (DefineLabel(fields[0], Optimize ? StatementCount : LocationCounter) != OK)
+			return ErrorSyntax;
+		PendingLabel = 1;
+	}
+
+	// Column 3: split "Op1,Op2"
+	char *comma = strchr(fields[2], ',');
+	if (comma != NULL) {
+		*comma = '\0';
+		snprintf(operands[1], MAX_FIELD, "%s", comma + 1);
+	}
+	else
+		operands[1][0] = '\0';
+	snprintf(operands[0], MAX_FIELD, "%s", fields[2]);
+
+	memset(&st, 0, sizeof(st));
+	st.ValueLabel = -1;
+	st.Line = LineNumber;
+
+	// Column 2: DIRECTIVES
+	if (strcmp(fields[1], "Long") == 0) {
+		st.Kind = STATEMENT_LONG;
+		if (ParseNumber(operands[0], &st.Value) != OK) {
+			if (operands[0][0] == '\0') {
+				printf("ERROR: Line %ld Long needs a value\n", LineNumber);
+				return ErrorSyntax;
+			}
+			st.ValueLabel = LookupLabel(operands[0]);
+			if (st.ValueLabel < 0)
+				return ErrorNoMemory;
+		}
+		return Optimize ? AppendStatement(&st) : EmitStatement(&st);
+	}
+	if (strcmp(fields[1], "Origin") == 0) {
+		if (ParseNumber(operands[0], &st.Value) != OK || st.Value < 0) {
+			printf("ERROR: Line %ld Invalid Origin %s\n", LineNumber, operands[0]);
+			return ErrorSyntax;
+		}
+		st.Kind = STATEMENT_ORIGIN;
+		return Optimize ? AppendStatement(&st) : EmitStatement(&st);
+	}
+	if (strcmp(fields[1], "Function") == 0)
+		return OK;		// Label column already names the function
+	if (strcmp(fields[1], "End") == 0) {
+		long label = LookupLabel(operands[0]);
+		if (label < 0)
+			return ErrorNoMemory;
+		if (LabelAddress[label] == UNDEFINED) {
+			printf("ERROR: Line %ld End label %s is not defined\n",
+					LineNumber, operands[0]);
+			return ErrorSyntax;
+		}
+		EntryLabel = label;
+		EntryPC = LabelAddress[label];
+		EndSeen = 1;
+		return OK;
+	}
+
+	// Column 2: INSTRUCTION
+	struct Instruction *ins = NULL;
+	for (size_t i = 0; i < INSTRUCTION_COUNT; i++)
+		if (strcmp(fields[1], Instructions[i].Mnemonic) == 0)
+			ins = &Instructions[i];
+	if (ins == NULL) {
+		printf("ERROR: Line %ld Invalid word: %s\n", LineNumber, fields[1]);
+		return ErrorSyntax;
+	}
+	st.Kind = STATEMENT_INSTRUCTION;
+	st.Ins = ins;
+
+	// Column 3: OPERANDS
+	if (ParseOperand(operands[0], op1) != OK || ParseOperand(operands[1], op2) != OK)
+		return ErrorSyntax;
+
+	switch (ins->Operands) {
+		case OPERANDS_NONE:
+			if (op1->Mode != 0) {
+				printf("ERROR: Line %ld %s takes no operands\n", LineNumber, ins->Mnemonic);
+				return ErrorSyntax;
+			}
+			break;
+		case OPERANDS_TARGET:
+			// Branch address is the next word, encoded as a direct Op1
+			op1->Mode = 5;
+			op1->Gpr = 0;
+			if (op1->HasWord == 0 || op2->Mode != 0) {
+				printf("ERROR: Line %ld Branch needs an address\n", LineNumber);
+				return ErrorSyntax;
+			}
+			break;
+		case OPERANDS_ONE_TARGET:
+			if (op1->Mode == 0 || op2->HasWord == 0) {
+				printf("ERROR: Line %ld %s needs an operand and an address\n",
+						LineNumber, ins->Mnemonic);
+				return ErrorSyntax;
+			}
+			op2->Mode = 5;
+			op2->Gpr = 0;
+			break;
+		case OPERANDS_ONE:
+			if (op2->Mode != 0) {
+				printf("ERROR: Line %ld %s takes one operand\n", LineNumber, ins->Mnemonic);
+				return ErrorSyntax;
+			}
+			break;
+		case OPERANDS_TWO:
+			if (op1->Mode == 0 || op2->Mode == 0) {
+				printf("ERROR: Line %ld %s needs two operands\n", LineNumber, ins->Mnemonic);
+				return ErrorSyntax;
+			}
+			break;
+	}
+	if (ins->WritesOp1 && op1->Mode == 6) {
+		printf("ERROR: Line %ld Destination cannot be immediate\n", LineNumber);
+		return ErrorSyntax;
+	}
+	if (ins->Opcode >= 25 && op1->Mode == 1) {	// CompareAndSwap .. TestAndSet
+		printf("ERROR: Line %ld Atomic operand must be in memory\n", LineNumber);
+		return ErrorSyntax;
+	}
+
+	return Optimize ? AppendStatement(&st) : EmitStatement(&st);
+}
+
+/*******************************************************************************
+ * Function: EmitStatement
+ *
+ * Description: Emits the words of a statement at the location counter.
+ *
+ * Function Return Value
+ *      OK, or ErrorNoMemory
+ ******************************************************************************/
+
+int EmitStatement(struct Statement *st)
+{
+	struct Operand *op1 = &st->Op1, *op2 = &st->Op2;
+
+	switch (st->Kind) {
+		case STATEMENT_ORIGIN:
+			LocationCounter = st->Value;
+			return OK;
+		case STATEMENT_LONG:
+			if (st->ValueLabel < 0)
+				return EmitWord(st->Value);
+			if (Relocatable && AddRelocation() != OK)
+				return ErrorNoMemory;
+			return EmitLabelWord(st->ValueLabel);
+	}
+
+	// Push Code Line, then the operand words in order
+	if (EmitWord(st->Ins->Opcode * 10000 + op1->Mode * 1000 + op1->Gpr * 100
+				+ op2->Mode * 10 + op2->Gpr) != OK)
+		return ErrorNoMemory;
+	if (op1->HasWord && EmitOperandWord(op1) != OK)
+		return ErrorNoMemory;
+	if (op2->HasWord && EmitOperandWord(op2) != OK)
+		return ErrorNoMemory;
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: EmitOperandWord
+ *
+ * Description: Emits the word of a direct or immediate operand. Direct
+ * addresses, branch targets and label immediates are relocated with -r.
+ *
+ * Function Return Value
+ *      OK, or ErrorNoMemory
+ ******************************************************************************/
+
+int EmitOperandWord(struct Operand *op)
+{
+	if (Relocatable && (op->Mode == 5 || op->Label >= 0) && AddRelocation() != OK)
+		return ErrorNoMemory;
+	return op->Label >= 0 ? EmitLabelWord(op->Label) : EmitWord(op->Word);
+}
+
+/*******************************************************************************
+ * Function: AddRelocation
+ *
+ * Description: Records that the next word emitted holds a program address.
+ *
+ * Function Return Value
+ *      OK, or ErrorNoMemory
+ ******************************************************************************/
+
+int AddRelocation()
+{
+	if (RelocationCount == RelocationCapacity) {
+		RelocationIndex = Grow(RelocationIndex, &RelocationCapacity, RelocationCount,
+				sizeof(long));
+		if (RelocationIndex == NULL)
+			return ErrorNoMemory;
+	}
+	RelocationIndex[RelocationCount++] = CodeCount;
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: AppendStatement
+ *
+ * Description: Adds a statement to the list kept for the optimizer.
+ *
+ * Function Return Value
+ *      OK, or ErrorNoMemory
+ ******************************************************************************/
+
+int AppendStatement(struct Statement *st)
+{
+	if (StatementCount == StatementCapacity) {
+		Statements = Grow(Statements, &StatementCapacity, StatementCount,
+				sizeof(struct Statement));
+		if (Statements == NULL)
+			return ErrorNoMemory;
+	}
+	st->Labelled = PendingLabel;
+	PendingLabel = 0;
+	Statements[StatementCount++] = *st;
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: SplitFields
+ *
+ * Description: Splits one CSV line into label, instruction and operand
+ * columns. Quoted fields may contain commas, leading spaces are skipped.
+ *
+ * Function Return Value
+ *      OK				-Fields split
+ *      ErrorSyntax			-Field too long or unterminated quote
+ ******************************************************************************/
+
+int SplitFields(char *line, char fields[3][MAX_FIELD])
+{
+	char *p = line;
+
+	for (int f = 0; f < 3; f++) {
+		int length = 0;
+
+		fields[f][0] = '\0';
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == '"') {
+			for (p++; *p != '"'; p++) {
+				if (*p == '\0') {
+					printf("ERROR: Line %ld Unterminated quote\n", LineNumber);
+					return ErrorSyntax;
+				}
+				if (length == MAX_FIELD - 1)
+					goto toolong;
+				fields[f][length++] = *p;
+			}
+			p++;
+		}
+		while (*p != ',' && *p != '\0' && *p != '\r') {
+			if (length == MAX_FIELD - 1)
+				goto toolong;
+			fields[f][length++] = *p++;
+		}
+		while (length > 0 && isspace((unsigned char)fields[f][length - 1]))
+			length--;
+		fields[f][length] = '\0';
+		if (*p == ',')
+			p++;
+	}
+	return OK;
+
+toolong:
+	printf("ERROR: Line %ld Field too long\n", LineNumber);
+	return ErrorSyntax;
+}
+
+/*******************************************************************************
+ * Function: ParseOperand
+ *
+ * Description: Decodes one operand into its mode, GPR and extra word.
+ *
+ * Output Parameters
+ *      op				Decoded operand
+ *
+ * Function Return Value
+ *      OK				-Valid operand (or empty)
+ *      ErrorSyntax			-Invalid register or operand
+ ******************************************************************************/
+
+int ParseOperand(char *text, struct Operand *op)
+{
+	char name[MAX_FIELD];
+	long length;
+
+	while (isspace((unsigned char)*text))
+		text++;
+	snprintf(name, MAX_FIELD, "%s", text);
+	length = strlen(name);
+	while (length > 0 && isspace((unsigned char)name[length - 1]))
+		name[--length] = '\0';
+
+	op->Mode = op->Gpr = op->HasWord = 0;
+	op->Word = 0;
+	op->Label = -1;
+	if (length == 0)
+		return OK;
+
+	// Register forms: R3, (R3), (R3)++, --(R3)
+	char *reg = name;
+	if (strncmp(name, "--(", 3) == 0 && name[length - 1] == ')') {
+		op->Mode = 4;
+		reg = name + 3;
+		name[length - 1] = '\0';
+	}
+	else if (name[0] == '(' && length > 3 && strcmp(name + length - 3, ")++") == 0) {
+		op->Mode = 3;
+		reg = name + 1;
+		name[length - 3] = '\0';
+	}
+	else if (name[0] == '(' && name[length - 1] == ')') {
+		op->Mode = 2;
+		reg = name + 1;
+		name[length - 1] = '\0';
+	}
+	else if ((name[0] == 'R' || name[0] == 'r') && isdigit((unsigned char)name[1])
+			&& name[2] == '\0')
+		op->Mode = 1;
+
+	if (op->Mode != 0) {
+		if ((reg[0] != 'R' && reg[0] != 'r') || !isdigit((unsigned char)reg[1])
+				|| reg[2] != '\0' || reg[1] - '0' >= GPR_NUMBER) {
+			printf("ERROR: Line %ld Invalid register %s\n", LineNumber, text);
+			return ErrorSyntax;
+		}
+		op->Gpr = reg[1] - '0';
+		return OK;
+	}
+
+	// Immediate number or direct label
+	op->HasWord = 1;
+	if (ParseNumber(name, &op->Word) == OK) {
+		op->Mode = 6;
+		return OK;
+	}
+	if (!isalpha((unsigned char)name[0]) && name[0] != '_') {
+		printf("ERROR: Line %ld Invalid Operand %s\n", LineNumber, text);
+		return ErrorSyntax;
+	}
+	op->Mode = 5;
+	op->Label = LookupLabel(name);
+	return op->Label < 0 ? ErrorNoMemory : OK;
+}
+
+/*******************************************************************************
+ * Function: ParseNumber
+ *
+ * Description: Parses an optionally signed decimal integer.
+ *
+ * Function Return Value
+ *      OK				-Whole text is a number
+ *      ErrorSyntax			-Not a number
+ ******************************************************************************/
+
+int ParseNumber(char *text, long *value)
+{
+	char *end;
+
+	if (!isdigit((unsigned char)text[text[0] == '-' || text[0] == '+']))
+		return ErrorSyntax;
+	*value = strtol(text, &end, 10);
+	return *end == '\0' ? OK : ErrorSyntax;
+}
+
+/*******************************************************************************
+ * Function: LookupLabel
+ *
+ * Description: Finds a label, adding it as UNDEFINED when it is seen for the
+ * first time. Label indexes never change; only the hash is rebuilt when it
+ * reaches half load.
+ *
+ * Function Return Value
+ *      Label index, or ErrorNoMemory
+ ******************************************************************************/
+
+long LookupLabel(char *name)
+{
+	unsigned long hash = 2166136261UL;		// FNV-1a
+	for (char *p = name; *p; p++)
+		hash = (hash ^ (unsigned char)*p) * 16777619UL;
+
+	// Linear probing
+	if (HashCapacity > 0) {
+		long slot = hash & (HashCapacity - 1);
+		while (LabelHash[slot] != UNDEFINED) {
+			if (strcmp(LabelName[LabelHash[slot]], name) == 0)
+				return LabelHash[slot];
+			slot = (slot + 1) & (HashCapacity - 1);
+		}
+	}
+
+	// New label
+	if (LabelCount == LabelCapacity) {
+		long capacity = LabelCapacity;
+		LabelName = Grow(LabelName, &capacity, LabelCount, sizeof(char *));
+		LabelAddress = Grow(LabelAddress, &LabelCapacity, LabelCount, sizeof(long));
+		if (LabelName == NULL || LabelAddress == NULL)
+			return ErrorNoMemory;
+	}
+	LabelName[LabelCount] = strdup(name);
+	LabelAddress[LabelCount] = UNDEFINED;
+	LabelCount++;
+
+	// Rebuild the hash at half load, otherwise insert the new label
+	if (LabelCount * 2 > HashCapacity) {
+		free(LabelHash);
+		HashCapacity = HashCapacity ? HashCapacity * 2 : 4096;
+		LabelHash = malloc(HashCapacity * sizeof(long));
+		if (LabelHash == NULL) {
+			printf("ERROR: Out of memory\n");
+			return ErrorNoMemory;
+		}
+		for (long i = 0; i < HashCapacity; i++)
+			LabelHash[i] = UNDEFINED;
+		for (long i = 0; i < LabelCount; i++) {
+			hash = 2166136261UL;
+			for (char *p = LabelName[i]; *p; p++)
+				hash = (hash ^ (unsigned char)*p) * 16777619UL;
+			long slot = hash & (HashCapacity - 1);
+			while (LabelHash[slot] != UNDEFINED)
+				slot = (slot + 1) & (HashCapacity - 1);
+			LabelHash[slot] = i;
+		}
+	}
+	else {
+		long slot = hash & (HashCapacity - 1);
+		while (LabelHash[slot] != UNDEFINED)
+			slot = (slot + 1) & (HashCapacity - 1);
+		LabelHash[slot] = LabelCount - 1;
+	}
+	return LabelCount - 1;
+}
+
+/*******************************************************************************
+ * Function: DefineLabel
+ *
+ * Description: Sets the address of a label from the label column.
+ *
+ * Function Return Value
+ *      OK				-Label defined
+ *      ErrorSyntax			-Label defined twice
+ ******************************************************************************/
+
+int DefineLabel(char *name, long address)
+{
+	long label = LookupLabel(name);
+
+	if (label < 0)
+		return ErrorNoMemory;
+	if (LabelAddress[label] != UNDEFINED) {
+		printf("ERROR: Line %ld Label %s defined twice\n", LineNumber, name);
+		return ErrorSyntax;
+	}
+	LabelAddress[label] = address;
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: EmitWord
+ *
+ * Description: Stores one word at the location counter and advances it.
+ *
+ * Function Return Value
+ *      OK, or ErrorNoMemory
+ ******************************************************************************/
+
+int EmitWord(long word)
+{
+	if (CodeCount == CodeCapacity) {
+		long capacity = CodeCapacity;
+		CodeAddress = Grow(CodeAddress, &capacity, CodeCount, sizeof(long));
+		CodeWord = Grow(CodeWord, &CodeCapacity, CodeCount, sizeof(long));
+		if (CodeAddress == NULL || CodeWord == NULL)
+			return ErrorNoMemory;
+	}
+	CodeAddress[CodeCount] = LocationCounter++;
+	CodeWord[CodeCount++] = word;
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: EmitLabelWord
+ *
+ * Description: Emits the address of a label, recording a fixup when the
+ * label has not been defined yet.
+ *
+ * Function Return Value
+ *      OK, or ErrorNoMemory
+ ******************************************************************************/
+
+int EmitLabelWord(long label)
+{
+	if (label < 0)
+		return ErrorNoMemory;
+	if (LabelAddress[label] != UNDEFINED)
+		return EmitWord(LabelAddress[label]);
+
+	if (FixupCount == FixupCapacity) {
+		long capacity = FixupCapacity;
+		FixupIndex = Grow(FixupIndex, &capacity, FixupCount, sizeof(long));
+		capacity = FixupCapacity;
+		FixupLine = Grow(FixupLine, &capacity, FixupCount, sizeof(long));
+		FixupLabel = Grow(FixupLabel, &FixupCapacity, FixupCount, sizeof(long));
+		if (FixupIndex == NULL || FixupLine == NULL || FixupLabel == NULL)
+			return ErrorNoMemory;
+	}
+	FixupIndex[FixupCount] = CodeCount;
+	FixupLabel[FixupCount] = label;
+	FixupLine[FixupCount++] = LineNumber;
+	return EmitWord(0);
+}
+
+/*******************************************************************************
+ * Function: ResolveFixups
+ *
+ * Description: Patches every forward reference with its label address.
+ *
+ * Function Return Value
+ *      OK				-All labels resolved
+ *      ErrorSyntax			-A referenced label is never defined
+ ******************************************************************************/
+
+int ResolveFixups()
+{
+	for (long i = 0; i < FixupCount; i++) {
+		long label = FixupLabel[i];
+		if (LabelAddress[label] == UNDEFINED) {
+			printf("ERROR: Line %ld Label %s is not defined\n",
+					FixupLine[i], LabelName[label]);
+			return ErrorSyntax;
+		}
+		CodeWord[FixupIndex[i]] = LabelAddress[label];
+	}
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: WriteTextObject
+ *
+ * Description: Writes "address word" lines, then a "-2 address" line per
+ * relocation, followed by "-1 PC".
+ *
+ * Function Return Value
+ *      OK, or ErrorFileOpen
+ ******************************************************************************/
+
+int WriteTextObject(char *filename, long pc)
+{
+	FILE *fp = fopen(filename, "w");
+	if (fp == NULL) {
+		printf("ERROR: Unable to open file %s\n", filename);
+		return ErrorFileOpen;
+	}
+	setvbuf(fp, NULL, _IOFBF, 1 << 16);
+
+	for (long i = 0; i < CodeCount; i++)
+		fprintf(fp, "%ld %ld\n", CodeAddress[i], CodeWord[i]);
+	for (long i = 0; i < RelocationCount; i++)
+		fprintf(fp, "%d %ld\n", SCRIPT_INDICATOR_RELOCATE, CodeAddress[RelocationIndex[i]]);
+	fprintf(fp, "%d %ld\n", SCRIPT_INDICATOR_END, pc);
+	return fclose(fp) == 0 ? OK : ErrorFileOpen;
+}
+
+/*******************************************************************************
+ * Function: WriteBinaryImage
+ *
+ * Description: Writes IMAGE_MAGIC followed by (address, word) pairs of
+ * 32-bit integers in host byte order, then the (-2, address) relocation
+ * pairs, ending with the (-1, PC) pair. This is
+ * the binary format accepted by AbsoluteLoader() in simulator.c.
+ *
+ * Function Return Value
+ *      OK, or ErrorFileOpen
+ ******************************************************************************/
+
+int WriteBinaryImage(char *filename, long pc)
+{
+	FILE *fp = fopen(filename, "wb");
+	if (fp == NULL) {
+		printf("ERROR: Unable to open file %s\n", filename);
+		return ErrorFileOpen;
+	}
+	setvbuf(fp, NULL, _IOFBF, 1 << 16);
+
+	fwrite(IMAGE_MAGIC, 1, 4, fp);
+	for (long i = 0; i < CodeCount; i++) {
+		int32_t record[2] = { CodeAddress[i], CodeWord[i] };
+		fwrite(record, sizeof(record), 1, fp);
+	}
+	for (long i = 0; i < RelocationCount; i++) {
+		int32_t record[2] = { SCRIPT_INDICATOR_RELOCATE, CodeAddress[RelocationIndex[i]] };
+		fwrite(record, sizeof(record), 1, fp);
+	}
+	int32_t end[2] = { SCRIPT_INDICATOR_END, pc };
+	fwrite(end, sizeof(end), 1, fp);
+	return fclose(fp) == 0 ? OK : ErrorFileOpen;
+}
+
+/*******************************************************************************
+ * Function: Grow
+ *
+ * Description: Doubles a dynamic array when it is full.
+ *
+ * Function Return Value
+ *      Array (possibly moved), or NULL when out of memory
+ ******************************************************************************/
+
+void *Grow(void *array, long *capacity, long count, size_t size)
+{
+	if (count < *capacity)
+		return array;
+	*capacity = *capacity ? *capacity * 2 : 4096;
+	array = realloc(array, *capacity * size);
+	if (array == NULL)
+		printf("ERROR: Out of memory\n");
+	return array;
+}
+
+/*** PEEPHOLE OPTIMIZER ***/
+// Works on the statement list before addresses are assigned, so removing an
+// instruction only moves the labels after it. Pairs are only combined when
+// the second statement has no label, i.e. control cannot enter between them.
+// The cycle report is static: every instruction counted once.
+long ChainedBranches = 0, DeadStores = 0, FoldedConstants = 0;
+long RedundantMoves = 0, RegisterOperands = 0;
+long RemovedInstructions = 0, CyclesSaved = 0, WordsSaved = 0;
+
+#define OPCODE_HALT		0
+#define OPCODE_ADD		1
+#define OPCODE_SUBTRACT		2
+#define OPCODE_MULTIPLY		3
+#define OPCODE_DIVIDE		4
+#define OPCODE_MOVE		5
+#define OPCODE_BRANCH		6
+#define OPCODE_BRANCH_ON_ZERO	9
+#define OPCODE_PUSH		10
+#define OPCODE_POP		11
+#define OPCODE_SYSTEM_CALL	12
+#define OPCODE_BLOCK_MOVE	13
+#define OPCODE_BLOCK_COMPARE	15
+#define OPCODE_CALL		16
+#define OPCODE_RETURN		17
+#define OPCODE_COMPARE		18
+#define OPCODE_BRANCH_ON_EQUAL	19
+#define OPCODE_BRANCH_ON_GREATER_OR_EQUAL	24
+#define OPCODE_COMPARE_AND_SWAP	25
+#define OPCODE_FETCH_AND_ADD	26
+#define OPCODE_TEST_AND_SET	27
+
+/*******************************************************************************
+ * Function: NextLive
+ *
+ * Description: Index of the first statement after i that was not deleted.
+ *
+ * Function Return Value
+ *      Statement index, or StatementCount past the end
+ ******************************************************************************/
+
+long NextLive(long i)
+{
+	for (i++; i < StatementCount && Statements[i].Deleted; i++)
+		;
+	return i;
+}
+
+/*******************************************************************************
+ * Function: FindOpcode
+ *
+ * Description: Instruction table entry for an opcode (first mnemonic).
+ ******************************************************************************/
+
+struct Instruction *FindOpcode(int opcode)
+{
+	for (size_t i = 0; i < INSTRUCTION_COUNT; i++)
+		if (Instructions[i].Opcode == opcode)
+			return &Instructions[i];
+	return NULL;
+}
+
+/*******************************************************************************
+ * Function: StatementWords
+ *
+ * Description: Number of memory words a statement occupies.
+ ******************************************************************************/
+
+int StatementWords(struct Statement *st)
+{
+	if (st->Kind == STATEMENT_ORIGIN)
+		return 0;
+	if (st->Kind == STATEMENT_LONG)
+		return 1;
+	return 1 + st->Op1.HasWord + st->Op2.HasWord;
+}
+
+/*******************************************************************************
+ * Function: IsOpcode
+ *
+ * Description: Non-zero when statement i is a live instruction with opcode.
+ ******************************************************************************/
+
+int IsOpcode(long i, int opcode)
+{
+	return i < StatementCount && Statements[i].Kind == STATEMENT_INSTRUCTION
+		&& Statements[i].Ins->Opcode == opcode;
+}
+
+/*******************************************************************************
+ * Function: IsImmediate / IsRegister
+ *
+ * Description: Operand is an immediate number / register mode GPR.
+ ******************************************************************************/
+
+int IsImmediate(struct Operand *op)
+{
+	return op->Mode == 6 && op->Label < 0;
+}
+
+int IsRegister(struct Operand *op)
+{
+	return op->Mode == 1;
+}
+
+/*******************************************************************************
+ * Function: EndsBlock
+ *
+ * Description: Control leaves the straight-line code after this statement.
+ * System calls and calls count too: they read and write GPRs the source
+ * does not show.
+ ******************************************************************************/
+
+int EndsBlock(struct Statement *st)
+{
+	if (st->Kind != STATEMENT_INSTRUCTION)
+		return 1;
+	int opcode = st->Ins->Opcode;
+	return opcode == OPCODE_HALT || opcode == OPCODE_SYSTEM_CALL
+		|| (opcode >= OPCODE_BRANCH && opcode <= OPCODE_BRANCH_ON_ZERO)
+		|| opcode == OPCODE_CALL || opcode == OPCODE_RETURN
+		|| (opcode >= OPCODE_BRANCH_ON_EQUAL
+			&& opcode <= OPCODE_BRANCH_ON_GREATER_OR_EQUAL);
+}
+
+/*******************************************************************************
+ * Function: BranchTarget
+ *
+ * Description: Operand holding the branch address, or NULL.
+ ******************************************************************************/
+
+struct Operand *BranchTarget(struct Statement *st)
+{
+	if (st->Kind != STATEMENT_INSTRUCTION)
+		return NULL;
+	if (st->Ins->Operands == OPERANDS_TARGET)
+		return &st->Op1;
+	if (st->Ins->Operands == OPERANDS_ONE_TARGET)
+		return &st->Op2;
+	return NULL;
+}
+
+/*******************************************************************************
+ * Function: TargetStatement
+ *
+ * Description: First live statement at the label of a branch address.
+ *
+ * Function Return Value
+ *      Statement index, or StatementCount when it is not a known label
+ ******************************************************************************/
+
+long TargetStatement(struct Operand *target)
+{
+	if (target->Label < 0 || LabelAddress[target->Label] == UNDEFINED)
+		return StatementCount;
+	long i = LabelAddress[target->Label];
+	if (i < StatementCount && Statements[i].Deleted)
+		i = NextLive(i);
+	return i;
+}
+
+/*******************************************************************************
+ * Function: RegisterUse
+ *
+ * Description: GPRs read and written by an instruction, as bit masks.
+ ******************************************************************************/
+
+void RegisterUse(struct Statement *st, int *reads, int *writes)
+{
+	struct Operand *ops[2] = { &st->Op1, &st->Op2 };
+
+	*reads = *writes = 0;
+	if (st->Kind != STATEMENT_INSTRUCTION)
+		return;
+	if (st->Ins->Opcode == OPCODE_SYSTEM_CALL || st->Ins->Opcode == OPCODE_CALL
+			|| st->Ins->Opcode == OPCODE_RETURN) {
+		*reads = *writes = (1 << GPR_NUMBER) - 1;
+		return;
+	}
+	// Block instructions take R1 to R3 and leave results in R1 to R3, and
+	// Block Compare its result in R0
+	if (st->Ins->Opcode >= OPCODE_BLOCK_MOVE && st->Ins->Opcode <= OPCODE_BLOCK_COMPARE) {
+		*reads = 0xe;
+		*writes = st->Ins->Opcode == OPCODE_BLOCK_COMPARE ? 0xf : 0xe;
+		return;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		int bit = 1 << ops[i]->Gpr;
+		switch (ops[i]->Mode) {
+			case 1:
+				// Move and Pop only write a register Op1
+				if (i == 1 || (st->Ins->Opcode != OPCODE_MOVE
+							&& st->Ins->Opcode != OPCODE_POP))
+					*reads |= bit;
+				if (i == 0 && st->Ins->WritesOp1)
+					*writes |= bit;
+				break;
+			case 2:
+				*reads |= bit;
+				break;
+			case 3:
+			case 4:
+				*reads |= bit;
+				*writes |= bit;
+				break;
+		}
+	}
+
+	// Atomic instructions leave the old word in R0; Compare And Swap reads it first
+	if (st->Ins->Opcode == OPCODE_COMPARE_AND_SWAP)
+		*reads |= 1;
+	if (st->Ins->Opcode >= OPCODE_COMPARE_AND_SWAP && st->Ins->Opcode <= OPCODE_TEST_AND_SET)
+		*writes |= 1;
+}
+
+/*******************************************************************************
+ * Function: DeleteStatement
+ *
+ * Description: Removes an instruction and counts what it cost.
+ ******************************************************************************/
+
+void DeleteStatement(long i)
+{
+	Statements[i].Deleted = 1;
+	RemovedInstructions++;
+	CyclesSaved += Statements[i].Ins->Cycles;
+	WordsSaved += StatementWords(&Statements[i]);
+}
+
+/*******************************************************************************
+ * Function: FoldConstants
+ *
+ * Description: Removes arithmetic by 0 or 1, turns multiply by 0 into a
+ * move, and merges an immediate Add/Subtract/Multiply/Divide into the
+ * preceding immediate Move or Add/Subtract of the same register.
+ *
+ * Function Return Value
+ *      Number of changes
+ ******************************************************************************/
+
+long FoldConstants()
+{
+	long changes = 0;
+
+	for (long i = NextLive(-1); i < StatementCount; i = NextLive(i)) {
+		struct Statement *s = &Statements[i];
+		if (s->Kind != STATEMENT_INSTRUCTION || !IsImmediate(&s->Op2))
+			continue;
+		int opcode = s->Ins->Opcode;
+		long value = s->Op2.Word;
+
+		// Rx + 0, Rx - 0, Rx * 1, Rx / 1 (a memory Op1 can trap)
+		if (((opcode == OPCODE_ADD || opcode == OPCODE_SUBTRACT) && value == 0)
+				|| ((opcode == OPCODE_MULTIPLY || opcode == OPCODE_DIVIDE) && value == 1)) {
+			if (IsRegister(&s->Op1)) {
+				DeleteStatement(i);
+				changes++;
+			}
+			continue;
+		}
+
+		// Rx * 0 is Move Rx,0
+		if (opcode == OPCODE_MULTIPLY && value == 0 && IsRegister(&s->Op1)) {
+			s->Ins = FindOpcode(OPCODE_MOVE);
+			CyclesSaved += FindOpcode(OPCODE_MULTIPLY)->Cycles - s->Ins->Cycles;
+			changes++;
+			continue;
+		}
+
+		// Pairs on the same register
+		long j = NextLive(i);
+		if (!IsRegister(&s->Op1) || j >= StatementCount)
+			continue;
+		struct Statement *t = &Statements[j];
+		if (t->Kind != STATEMENT_INSTRUCTION || t->Labelled || !IsRegister(&t->Op1)
+				|| t->Op1.Gpr != s->Op1.Gpr || !IsImmediate(&t->Op2))
+			continue;
+		int next = t->Ins->Opcode;
+		long operand = t->Op2.Word;
+
+		if (opcode == OPCODE_MOVE) {
+			// Move Rx,a then Rx op b is Move Rx,(a op b)
+			if (next == OPCODE_ADD)
+				s->Op2.Word = value + operand;
+			else if (next == OPCODE_SUBTRACT)
+				s->Op2.Word = value - operand;
+			else if (next == OPCODE_MULTIPLY)
+				s->Op2.Word = value * operand;
+			else if (next == OPCODE_DIVIDE && operand != 0)
+				s->Op2.Word = value / operand;
+			else
+				continue;
+			DeleteStatement(j);
+			changes++;
+		}
+		else if ((opcode == OPCODE_ADD || opcode == OPCODE_SUBTRACT)
+				&& (next == OPCODE_ADD || next == OPCODE_SUBTRACT)) {
+			// Rx +- a then Rx +- b is one Add or Subtract
+			long total = (opcode == OPCODE_ADD ? value : -value)
+				+ (next == OPCODE_ADD ? operand : -operand);
+			s->Ins = FindOpcode(total < 0 ? OPCODE_SUBTRACT : OPCODE_ADD);
+			s->Op2.Word = total < 0 ? -total : total;
+			DeleteStatement(j);
+			if (total == 0)
+				DeleteStatement(i);
+			changes++;
+		}
+	}
+	FoldedConstants += changes;
+	return changes;
+}
+
+/*******************************************************************************
+ * Function: RemoveRedundantMoves
+ *
+ * Description: Removes Move Rx,Rx, the swap back in Move Rx,Ry; Move Ry,Rx,
+ * and a Move repeating the one just before it.
+ *
+ * Function Return Value
+ *      Number of changes
+ ******************************************************************************/
+
+long RemoveRedundantMoves()
+{
+	long changes = 0;
+
+	for (long i = NextLive(-1); i < StatementCount; i = NextLive(i)) {
+		struct Statement *s = &Statements[i];
+		if (!IsOpcode(i, OPCODE_MOVE) || !IsRegister(&s->Op1))
+			continue;
+
+		if (IsRegister(&s->Op2) && s->Op2.Gpr == s->Op1.Gpr) {
+			DeleteStatement(i);
+			changes++;
+			continue;
+		}
+
+		long j = NextLive(i);
+		if (!IsOpcode(j, OPCODE_MOVE) || Statements[j].Labelled)
+			continue;
+		struct Statement *t = &Statements[j];
+		if (!IsRegister(&t->Op1))
+			continue;
+
+		// Move Rx,Ry then Move Ry,Rx
+		int swapBack = IsRegister(&s->Op2) && IsRegister(&t->Op2)
+			&& t->Op1.Gpr == s->Op2.Gpr && t->Op2.Gpr == s->Op1.Gpr;
+		// Move Rx,src twice, src a different register or an immediate
+		int repeat = t->Op1.Gpr == s->Op1.Gpr && t->Op2.Mode == s->Op2.Mode
+			&& ((IsRegister(&s->Op2) && t->Op2.Gpr == s->Op2.Gpr)
+				|| (IsImmediate(&s->Op2) && t->Op2.Word == s->Op2.Word));
+		if (swapBack || repeat) {
+			DeleteStatement(j);
+			changes++;
+		}
+	}
+	RedundantMoves += changes;
+	return changes;
+}
+
+/*******************************************************************************
+ * Function: RemoveDeadStores
+ *
+ * Description: Removes a register write that is overwritten, in the same
+ * straight-line code, before anything reads it. Divide is kept since it can
+ * fail at run time, and so is an instruction whose Op2 reads memory, since
+ * an invalid address traps too.
+ *
+ * Function Return Value
+ *      Number of changes
+ ******************************************************************************/
+
+long RemoveDeadStores()
+{
+	long changes = 0;
+
+	for (long i = NextLive(-1); i < StatementCount; i = NextLive(i)) {
+		struct Statement *s = &Statements[i];
+		if (s->Kind != STATEMENT_INSTRUCTION || !IsRegister(&s->Op1)
+				|| (s->Op2.Mode != 1 && s->Op2.Mode != 6))
+			continue;
+		int opcode = s->Ins->Opcode;
+		if (opcode != OPCODE_MOVE && opcode != OPCODE_ADD
+				&& opcode != OPCODE_SUBTRACT && opcode != OPCODE_MULTIPLY)
+			continue;
+
+		int bit = 1 << s->Op1.Gpr;
+		for (long j = NextLive(i); j < StatementCount; j = NextLive(j)) {
+			int reads, writes;
+			RegisterUse(&Statements[j], &reads, &writes);
+			if (reads & bit)
+				break;
+			if (writes & bit) {
+				DeleteStatement(i);
+				changes++;
+				break;
+			}
+			if (EndsBlock(&Statements[j]))
+				break;
+		}
+	}
+	DeadStores += changes;
+	return changes;
+}
+
+/*******************************************************************************
+ * Function: ChainBranches
+ *
+ * Description: Retargets branches whose target is an unconditional Branch,
+ * and removes branches to the next instruction.
+ *
+ * Function Return Value
+ *      Number of changes
+ ******************************************************************************/
+
+long ChainBranches()
+{
+	long changes = 0;
+
+	for (long i = NextLive(-1); i < StatementCount; i = NextLive(i)) {
+		struct Operand *target = BranchTarget(&Statements[i]);
+		if (target == NULL || target->Label < 0)
+			continue;
+
+		// Follow Branch to Branch, bounded in case of a cycle
+		long j = TargetStatement(target);
+		for (int hops = 0; hops < 16 && IsOpcode(j, OPCODE_BRANCH)
+				&& Statements[j].Op1.Label >= 0
+				&& Statements[j].Op1.Label != target->Label; hops++) {
+			target->Label = Statements[j].Op1.Label;
+			j = TargetStatement(target);
+			CyclesSaved += FindOpcode(OPCODE_BRANCH)->Cycles;
+			ChainedBranches++;
+			changes++;
+		}
+
+		// Branch to the next instruction (a register Op1 read cannot trap)
+		if (j == NextLive(i) && (IsOpcode(i, OPCODE_BRANCH)
+					|| IsRegister(&Statements[i].Op1))) {
+			DeleteStatement(i);
+			ChainedBranches++;
+			changes++;
+		}
+	}
+	return changes;
+}
+
+/*******************************************************************************
+ * Function: UseRegisterOperands
+ *
+ * Description: Replaces an immediate source operand by a register known to
+ * hold the same value in the same straight-line code. Saves a word and a
+ * memory fetch; the instruction time does not change.
+ ******************************************************************************/
+
+void UseRegisterOperands()
+{
+	long known[GPR_NUMBER];
+	int valid = 0;
+
+	for (long i = NextLive(-1); i < StatementCount; i = NextLive(i)) {
+		struct Statement *s = &Statements[i];
+		if (s->Labelled || s->Kind != STATEMENT_INSTRUCTION)
+			valid = 0;
+		if (s->Kind != STATEMENT_INSTRUCTION)
+			continue;
+
+		int opcode = s->Ins->Opcode;
+		struct Operand *source = NULL;
+		if ((opcode >= OPCODE_ADD && opcode <= OPCODE_MOVE) || opcode == OPCODE_COMPARE
+				|| opcode == OPCODE_COMPARE_AND_SWAP || opcode == OPCODE_FETCH_AND_ADD)
+			source = &s->Op2;
+		else if (opcode == OPCODE_PUSH)
+			source = &s->Op1;
+		if (source != NULL && IsImmediate(source)) {
+			for (int r = 0; r < GPR_NUMBER; r++) {
+				// Op1 is fetched first, so its autoincrement or
+				// autodecrement would change the register read as Op2
+				if (source == &s->Op2 && (s->Op1.Mode == 3 || s->Op1.Mode == 4)
+						&& s->Op1.Gpr == r)
+					continue;
+				if ((valid & (1 << r)) && known[r] == source->Word) {
+					source->Mode = 1;
+					source->Gpr = r;
+					source->HasWord = 0;
+					RegisterOperands++;
+					WordsSaved++;
+					break;
+				}
+			}
+		}
+
+		int reads, writes;
+		RegisterUse(s, &reads, &writes);
+		valid &= ~writes;
+		if (opcode == OPCODE_MOVE && IsRegister(&s->Op1) && IsImmediate(&s->Op2)) {
+			known[s->Op1.Gpr] = s->Op2.Word;
+			valid |= 1 << s->Op1.Gpr;
+		}
+		if (EndsBlock(s))
+			valid = 0;
+	}
+}
+
+/*******************************************************************************
+ * Function: OptimizeProgram
+ *
+ * Description: Runs the peephole passes until none of them changes the
+ * program, then reports what was saved.
+ ******************************************************************************/
+
+void OptimizeProgram()
+{
+	long instructions = 0;
+
+	for (long i = 0; i < StatementCount; i++)
+		instructions += Statements[i].Kind == STATEMENT_INSTRUCTION;
+
+	for (int round = 0; round < 16; round++) {
+		long changes = FoldConstants();
+		changes += RemoveRedundantMoves();
+		changes += RemoveDeadStores();
+		changes += ChainBranches();
+		if (changes == 0)
+			break;
+	}
+	UseRegisterOperands();
+
+	printf("Optimizer: %ld branches chained, %ld dead stores, %ld constants folded, "
+			"%ld redundant moves, %ld register operands\n", ChainedBranches,
+			DeadStores, FoldedConstants, RedundantMoves, RegisterOperands);
+	printf("Optimizer: %ld of %ld instructions removed, %ld words and "
+			"%ld cycles saved\n", RemovedInstructions, instructions,
+			WordsSaved, CyclesSaved);
+}
+
+/*******************************************************************************
+ * Function: LayoutProgram
+ *
+ * Description: Assigns addresses to the optimized statement list, turns the
+ * label statement indexes into addresses and emits the words.
+ *
+ * Function Return Value
+ *      OK, or ErrorSyntax for an undefined label
+ ******************************************************************************/
+
+int LayoutProgram()
+{
+	long *address = malloc((StatementCount + 1) * sizeof(long));
+	if (address == NULL)
+		return ErrorNoMemory;
+
+	// A deleted statement's labels move to the statement after it
+	LocationCounter = 0;
+	for (long i = 0; i < StatementCount; i++) {
+		address[i] = LocationCounter;
+		if (Statements[i].Deleted)
+			continue;
+		if (Statements[i].Kind == STATEMENT_ORIGIN)
+			LocationCounter = Statements[i].Value;
+		else
+			LocationCounter += StatementWords(&Statements[i]);
+	}
+	address[StatementCount] = LocationCounter;
+
+	for (long i = 0; i < LabelCount; i++)
+		if (LabelAddress[i] != UNDEFINED)
+			LabelAddress[i] = address[LabelAddress[i]];
+	EntryPC = LabelAddress[EntryLabel];
+	free(address);
+
+	LocationCounter = 0;
+	for (long i = 0; i < StatementCount; i++)
+		if (!Statements[i].Deleted && EmitStatement(&Statements[i]) != OK)
+			return ErrorNoMemory;
+	return ResolveFixups();
+}
@@ -18,13 +18,20 @@ import sys
 #   3. The Operand Column
 #
 # An Example of a properly formated ASM file is included with this program.
+#
+# hypothesize.c is the native replacement: single pass, all six addressing
+# modes, and text or binary output.
 
 # === CONSTANTS ===
 codearray = {}                                  # Output Stream
 instructions = {
         'Halt':0,'Add':1,'Subtract':2,'Multiply':3,'Divide':4,'Move':5,'Branch':6,\
         'BranchOnMinus':7,'BranchOnPlus':8,'BranchOnZero':9,'Push':10,'Pop':11,\
-        'SystemCall':12 }
+        'SystemCall':12,'BlockMove':13,'BlockFill':14,'BlockCompare':15,\
+        'Call':16,'Return':17,'Compare':18,'BranchOnEqual':19,'BranchOnNotEqual':20,\
+        'BranchOnLess':21,'BranchOnLessOrEqual':22,'BranchOnGreater':23,\
+        'BranchOnGreaterOrEqual':24,'CompareAndSwap':25,'FetchAndAdd':26,\
+        'TestAndSet':27 }
 labels = {}                                     # Label Index Locations
 asmlist = []                                    # In-Memory copy of CSV file
 
@@ -0,0 +1,233 @@
+/*******************************************************************************
+ * hypotop.c - HYPO Statistics Monitor
+ *
+ * Shows the statistics page a running simulator publishes with -p, the way
+ * top shows a host: clock and instruction rates, queue lengths, free lists,
+ * system calls by ID and the process table. The page is only read, so the
+ * simulator never waits for the monitor: a copy that races with an update
+ * is detected by the sequence number of the page and taken again.
+ *
+ * Build:	gcc -O2 -o hypotop tools/hypotop.c
+ * Usage:	hypotop [-d seconds] [-n count] name
+ *      -d	Seconds between refreshes, default 1
+ *      -n	Refreshes before exiting, default until the simulator stops
+ *      name	Shared memory object given to simulator -p, e.g. /hypo
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+/*** PARAMETERS ***/
+// Must match simulator.c; STATS_VERSION changes with the page
+#define STATS_VERSION		1
+#define MAX_SYSTEM_CALL		21
+#define MAX_PROCESSES		128
+#define MAX_REASON		18	// NativeFallback
+
+/*** ERROR CODES ***/
+#define OK                      0
+#define ErrorFileOpen           -2
+#define ErrorVersion		-3
+
+/*** STATISTICS PAGE ***/
+struct StatsProcess {
+	long Pid;				// 0 for a free process slot
+	long State, Reason, Priority;
+};
+struct StatsPage {
+	unsigned long Sequence;			// Odd while the simulator writes
+	long Version;
+	long Running;				// 0 once the OS has shut down
+	long MachineWords, Processes;
+	long Clock, Instructions, ContextSwitches;
+	long ReadyCount, WaitCount;
+	long UserFreeWords, UserFreeBlocks;
+	long OSFreeWords, OSFreeBlocks;
+	long ProgramFreeWords, ProgramFreeBlocks;
+	long SystemCalls;
+	long SystemCallsByID[MAX_SYSTEM_CALL + 1];
+	struct StatsProcess Process[MAX_PROCESSES];
+};
+
+const char *SystemCallNames[MAX_SYSTEM_CALL + 1] = {
+	"invalid", "process_create", "process_delete", "process_inquiry",
+	"mem_alloc", "mem_free", "msg_send", "msg_receive", "io_getc", "io_putc",
+	"time_get", "time_set", "process_exec", "sleep", "timer_set",
+	"timer_wait", "io_read", "io_write", "disk_read", "disk_write", "mmap",
+	"munmap"
+};
+const char *StateNames[] = { "-", "Ready", "Running", "Waiting" };
+const char *ReasonNames[MAX_REASON + 1] = {
+	"-", "StartOfInput", "StartOfOutput", "InputCompletion",
+	"OutputCompletion", "TimeSliceExpired", "WaitForChild",
+	"ChildTermination", "WaitForMessage", "MessageArrival", "WaitForTimer",
+	"TimerExpiry", "StartOfBlockInput", "StartOfBlockOutput",
+	"BlockInputCompletion", "BlockOutputCompletion", "StartOfDiskIO",
+	"DiskCompletion", "NativeFallback"
+};
+
+/*** FUNCTION PROTOTYPES ***/
+int main(int argc, char *argv[]);
+void ReadPage(const struct StatsPage *page, struct StatsPage *copy);
+void ShowPage(const struct StatsPage *now, const struct StatsPage *last, double seconds);
+double Rate(long now, long last, double seconds);
+
+/*******************************************************************************
+ * Function: main
+ *
+ * Description: Maps the statistics page read-only and shows a copy of it
+ * every refresh, until the simulator shuts down or -n refreshes are done.
+ *
+ * Function Return Value
+ *      OK
+ *      ErrorFileOpen			-No such page, or unable to map it
+ *      ErrorVersion			-Page of another simulator version
+ ******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	double delay = 1.0;
+	long count = -1;
+	int option;
+
+	while ((option = getopt(argc, argv, "d:n:")) != -1) {
+		switch (option) {
+			case 'd':
+				delay = atof(optarg);
+				break;
+			case 'n':
+				count = atol(optarg);
+				break;
+			default:
+				printf("Usage: %s [-d seconds] [-n count] name\n", argv[0]);
+				return ErrorFileOpen;
+		}
+	}
+	if (optind != argc - 1) {
+		printf("Usage: %s [-d seconds] [-n count] name\n", argv[0]);
+		return ErrorFileOpen;
+	}
+
+	int fd = shm_open(argv[optind], O_RDONLY, 0);
+	if (fd < 0) {
+		printf("ERROR: Unable to open statistics page %s\n", argv[optind]);
+		return ErrorFileOpen;
+	}
+	const struct StatsPage *page = mmap(NULL, sizeof(struct StatsPage), PROT_READ,
+			MAP_SHARED, fd, 0);
+	close(fd);
+	if (page == MAP_FAILED) {
+		printf("ERROR: Unable to map statistics page %s\n", argv[optind]);
+		return ErrorFileOpen;
+	}
+
+	static struct StatsPage now, last;
+	struct timespec start, end;
+	ReadPage(page, &last);
+	if (last.Version != STATS_VERSION || last.Processes != MAX_PROCESSES) {
+		printf("ERROR: Statistics page version %ld, expected %d\n", last.Version,
+				STATS_VERSION);
+		return ErrorVersion;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	// The first refresh shows the rates since the page was found
+	while (count != 0) {
+		struct timespec pause = { (time_t)delay, (long)((delay - (time_t)delay) * 1e9) };
+		if (last.Running)
+			nanosleep(&pause, NULL);
+		ReadPage(page, &now);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		ShowPage(&now, &last, (end.tv_sec - start.tv_sec) +
+				(end.tv_nsec - start.tv_nsec) / 1e9);
+		if (!now.Running)
+			break;
+		last = now;
+		start = end;
+		if (count > 0)
+			count--;
+	}
+	return OK;
+}
+
+/*******************************************************************************
+ * Function: ReadPage
+ *
+ * Description: Copies the page while its sequence number stays even and
+ * unchanged, i.e. while the simulator did not write it.
+ ******************************************************************************/
+
+void ReadPage(const struct StatsPage *page, struct StatsPage *copy)
+{
+	for (;;) {
+		unsigned long before = __atomic_load_n(&page->Sequence, __ATOMIC_ACQUIRE);
+		if (before & 1) {
+			sched_yield();
+			continue;
+		}
+		memcpy(copy, (const void *)page, sizeof(*copy));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&page->Sequence, __ATOMIC_RELAXED) == before)
+			return;
+	}
+}
+
+/*******************************************************************************
+ * Function: ShowPage
+ *
+ * Description: Prints a screen of statistics, with rates over the time
+ * since the last copy. The screen is cleared first when it is a terminal.
+ ******************************************************************************/
+
+void ShowPage(const struct StatsPage *now, const struct StatsPage *last, double seconds)
+{
+	if (isatty(STDOUT_FILENO))
+		printf("\033[H\033[J");
+	printf("HYPO %ld words, %s\n", now->MachineWords, now->Running ? "running" : "shut down");
+	printf("Clock: %ld (%.0f/s)  Instructions: %ld (%.0f/s)  Context switches: %ld (%.0f/s)\n",
+			now->Clock, Rate(now->Clock, last->Clock, seconds),
+			now->Instructions, Rate(now->Instructions, last->Instructions, seconds),
+			now->ContextSwitches, Rate(now->ContextSwitches, last->ContextSwitches, seconds));
+	printf("Queues: %ld ready, %ld waiting\n", now->ReadyCount, now->WaitCount);
+	printf("Free: user %ld words in %ld blocks, OS %ld words in %ld blocks",
+			now->UserFreeWords, now->UserFreeBlocks, now->OSFreeWords, now->OSFreeBlocks);
+	if (now->ProgramFreeBlocks > 0)
+		printf(", program %ld words in %ld blocks", now->ProgramFreeWords,
+				now->ProgramFreeBlocks);
+	printf("\nSystem calls: %ld (%.0f/s)\n", now->SystemCalls,
+			Rate(now->SystemCalls, last->SystemCalls, seconds));
+	for (int id = 0; id <= MAX_SYSTEM_CALL; id++)
+		if (now->SystemCallsByID[id] > 0)
+			printf("  %-16s %12ld %10.0f/s\n", SystemCallNames[id], now->SystemCallsByID[id],
+					Rate(now->SystemCallsByID[id], last->SystemCallsByID[id], seconds));
+
+	printf("\n  PID  STATE    REASON                 PRIORITY\n");
+	for (int slot = 0; slot < MAX_PROCESSES; slot++) {
+		const struct StatsProcess *process = &now->Process[slot];
+		if (process->Pid == 0)
+			continue;
+		long state = process->State >= 1 && process->State <= 3 ? process->State : 0;
+		long reason = state == 3 && process->Reason >= 1 && process->Reason <= MAX_REASON ?
+			process->Reason : 0;
+		printf("%5ld  %-8s %-22s %8ld\n", process->Pid, StateNames[state],
+				ReasonNames[reason], process->Priority);
+	}
+	fflush(stdout);
+}
+
+/*******************************************************************************
+ * Function: Rate
+ *
+ * Description: Change of a counter per second.
+ ******************************************************************************/
+
+double Rate(long now, long last, double seconds)
+{
+	return seconds > 0 ? (now - last) / seconds : 0;
+}
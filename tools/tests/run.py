@@ -0,0 +1,87 @@
+#!/usr/bin/python
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+# Regression tests for the HYPO simulator and assembler.
+#
+# Every test is an ASM source in this directory, NAME.csv, assembled by
+# hypothesize with the options of the test and run in batch mode under each
+# memory model, with NAME.in as standard input when it exists. The console
+# output, everything before "OS shutting down", must equal NAME.out.
+#
+# Build the simulator and the assembler first:
+#   gcc -O2 -o simulator simulator.c -ldl
+#   gcc -O2 -o tools/hypothesize tools/hypothesize.c
+#
+# Usage:
+#   ./tools/tests/run.py [--simulator ./simulator]
+#                        [--assembler tools/hypothesize] [--test NAME]
+
+# === CONSTANTS ===
+TESTS_DIR = os.path.dirname(os.path.abspath(__file__))
+TOOLS_DIR = os.path.dirname(TESTS_DIR)
+DEFAULT_SIMULATOR = os.path.join(os.path.dirname(TOOLS_DIR), 'simulator')
+DEFAULT_ASSEMBLER = os.path.join(TOOLS_DIR, 'hypothesize')
+MODELS = ['segment', 'flat', 'paged']
+SHUTDOWN = 'OS shutting down'
+
+# === TESTS ===
+# (name, processes created from the module, assembler options)
+TESTS = [
+        ('io_read_shared', 2, ['-r']),          # io_read into a shared segment
+        ('block_move_r0', 1, ['-r', '-O']),     # R0 live across Block Move
+        ('autodecrement_source', 1, ['-O']) ]   # Op2 register moved by Op1,
+                                                # at absolute address 0
+
+# === RUNNING ===
+def assemble(assembler, name, options, workdir):
+    filename = os.path.join(workdir, name + '.txt')
+    result = subprocess.run([assembler] + options + ['-o', filename,
+            os.path.join(TESTS_DIR, name + '.csv')], capture_output=True,
+            text=True)
+    if result.returncode != 0 or 'ERROR' in result.stdout:
+        sys.exit('ERROR: %s not assembled: %s' % (name, result.stdout))
+    return filename
+
+def run(simulator, filename, processes, model, text):
+    command = [simulator, '-b', '-q', '-m', model] + [filename] * processes
+    result = subprocess.run(command, cwd=TOOLS_DIR, input=text,
+            capture_output=True, text=True)
+    return result.stdout.partition(SHUTDOWN)[0]
+
+### === MAIN === ###
+parser = argparse.ArgumentParser(description='HYPO regression tests')
+parser.add_argument('--simulator', default=DEFAULT_SIMULATOR)
+parser.add_argument('--assembler', default=DEFAULT_ASSEMBLER)
+parser.add_argument('--test', action='append',
+        help='test to run (default: every test)')
+args = parser.parse_args()
+
+simulator = os.path.abspath(args.simulator)
+assembler = os.path.abspath(args.assembler)
+failures = 0
+
+with tempfile.TemporaryDirectory() as workdir:
+    for name, processes, options in TESTS:
+        if args.test and name not in args.test:
+            continue
+        filename = assemble(assembler, name, options, workdir)
+        text = ''
+        if os.path.exists(os.path.join(TESTS_DIR, name + '.in')):
+            with open(os.path.join(TESTS_DIR, name + '.in')) as f:
+                text = f.read()
+        with open(os.path.join(TESTS_DIR, name + '.out')) as f:
+            expected = f.read()
+        for model in MODELS:
+            output = run(simulator, filename, processes, model, text)
+            status = 'ok' if output == expected else 'FAILED'
+            failures += status != 'ok'
+            print('%-24s %-8s %s' % (name, model, status))
+            if status != 'ok':
+                print('  expected %r\n  got      %r' % (expected, output))
+
+if failures:
+    sys.exit('%d test(s) failed' % failures)